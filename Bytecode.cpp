@@ -0,0 +1,129 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include "Bytecode.hpp"
+#include "Code.hpp"
+
+namespace {
+uint8_t hexNibble(char c) {
+    if (c >= '0' && c <= '9') return static_cast<uint8_t>(c - '0');
+    if (c >= 'a' && c <= 'f') return static_cast<uint8_t>(c - 'a' + 10);
+    if (c >= 'A' && c <= 'F') return static_cast<uint8_t>(c - 'A' + 10);
+    throw std::runtime_error("co_code com dígito hexadecimal inválido");
+}
+
+uint8_t hexByte(const std::string& hex, size_t byteIndex) {
+    return static_cast<uint8_t>((hexNibble(hex[2 * byteIndex]) << 4) | hexNibble(hex[2 * byteIndex + 1]));
+}
+
+// Saltos cujo argumento é relativo à instrução seguinte
+bool isRelativeJump(uint8_t opcode) {
+    switch (opcode) {
+        case OP_JUMP_FORWARD: case OP_FOR_ITER: case OP_SETUP_FINALLY: case OP_SETUP_WITH:
+        case OP_SETUP_ASYNC_WITH:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Superinstrução para o par (first, second), ou 0 se o par não é fundido
+uint8_t fusedOpcode(uint8_t first, uint8_t second) {
+    switch (first) {
+        case OP_LOAD_FAST:
+            if (second == OP_LOAD_FAST) return OP_LOAD_FAST__LOAD_FAST;
+            if (second == OP_LOAD_CONST) return OP_LOAD_FAST__LOAD_CONST;
+            return 0;
+        case OP_STORE_FAST:
+            return second == OP_LOAD_FAST ? OP_STORE_FAST__LOAD_FAST : 0;
+        case OP_LOAD_CONST:
+            return second == OP_RETURN_VALUE ? OP_LOAD_CONST__RETURN_VALUE : 0;
+        case OP_COMPARE_OP:
+            return second == OP_POP_JUMP_IF_FALSE ? OP_COMPARE_OP__POP_JUMP_IF_FALSE : 0;
+        default:
+            return 0;
+    }
+}
+}
+
+bool isJumpOpcode(uint8_t opcode) {
+    switch (opcode) {
+        case OP_JUMP_IF_FALSE_OR_POP: case OP_JUMP_IF_TRUE_OR_POP: case OP_JUMP_ABSOLUTE:
+        case OP_POP_JUMP_IF_FALSE: case OP_POP_JUMP_IF_TRUE: case OP_JUMP_IF_NOT_EXC_MATCH:
+            return true;
+        default:
+            return isRelativeJump(opcode);
+    }
+}
+
+uint8_t unfusedOpcode(uint8_t opcode) {
+    switch (opcode) {
+        case OP_LOAD_FAST__LOAD_FAST: case OP_LOAD_FAST__LOAD_CONST: return OP_LOAD_FAST;
+        case OP_STORE_FAST__LOAD_FAST: return OP_STORE_FAST;
+        case OP_LOAD_CONST__RETURN_VALUE: return OP_LOAD_CONST;
+        case OP_COMPARE_OP__POP_JUMP_IF_FALSE: return OP_COMPARE_OP;
+        default: return opcode;
+    }
+}
+
+Bytecode::Bytecode(const std::string& hex, bool fuse) {
+    size_t count = hex.size() / 4;
+    code.resize(count);
+    uint32_t extended = 0;
+    for (size_t i = 0; i < count; ++i) {
+        Instruction& instr = code[i];
+        instr.opcode = hexByte(hex, 2 * i);
+        instr.arg = extended | hexByte(hex, 2 * i + 1);
+        extended = instr.opcode == OP_EXTENDED_ARG ? instr.arg << 8 : 0;
+
+        // Destino fora do uint32_t fica no máximo, e quem executa o rejeita como os demais
+        if (isRelativeJump(instr.opcode)) {
+            uint64_t target = i + 1 + static_cast<uint64_t>(instr.arg);
+            instr.arg = static_cast<uint32_t>(std::min<uint64_t>(target, std::numeric_limits<uint32_t>::max()));
+        }
+    }
+
+    // Em ordem crescente, a segunda instrução do par ainda tem o opcode original quando a
+    // primeira é avaliada. Pares sobrepostos (LOAD_FAST, LOAD_FAST, LOAD_FAST) são todos
+    // fundidos: cada superinstrução executa a segunda pelo opcode original
+    if (fuse) {
+        for (size_t i = 0; i + 1 < count; ++i) {
+            if (uint8_t superinstruction = fusedOpcode(code[i].opcode, code[i + 1].opcode)) {
+                code[i].opcode = superinstruction;
+                ++fused;
+            }
+        }
+    }
+}
+
+size_t predecodeBytecode(Code& root) {
+    // Codes deduplicados apontam para o mesmo texto de co_code
+    std::unordered_map<const std::string*, std::shared_ptr<const Bytecode>> decoded;
+    std::unordered_set<const Code*> visited;
+    std::vector<Code*> pending{&root};
+    while (!pending.empty()) {
+        Code* code = pending.back();
+        pending.pop_back();
+        // Após deduplicateCodes um mesmo Code pode aparecer em vários pais
+        if (!visited.insert(code).second) {
+            continue;
+        }
+        code->materialize();
+        for (auto& child : code->children) {
+            pending.push_back(child.get());
+        }
+        std::lock_guard<std::mutex> lock(*code->cacheLock);
+        if (code->bytecode) {
+            continue;
+        }
+
+        auto [it, added] = decoded.try_emplace(code->co_code.get());
+        if (added) {
+            it->second = std::make_shared<const Bytecode>(*code->co_code);
+        }
+        code->bytecode = it->second;
+    }
+    return decoded.size();
+}
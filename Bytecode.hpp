@@ -0,0 +1,135 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+    * Forma pré-decodificada do co_code, feita uma vez na carga para quem percorre ou executa
+    * o bytecode (o mestre emulado, a varredura de chamadas da pré-busca):
+    *
+    *   - uma Instruction por palavra de 2 bytes do co_code, de modo que os índices continuam
+    *     sendo os do CPython 3.10 (saltos contados em instruções)
+    *   - EXTENDED_ARG somado ao argumento da instrução seguinte; a própria palavra de
+    *     EXTENDED_ARG fica no lugar, sem efeito, para não deslocar os destinos de salto
+    *   - saltos relativos convertidos em absolutos: o argumento de todo salto é o índice
+    *     da instrução de destino
+    *   - superinstruções: a primeira de um par comum (LOAD_FAST seguido de LOAD_FAST, por
+    *     exemplo) recebe um opcode que executa as duas e pula a segunda. A segunda continua
+    *     intacta, então um salto para ela ainda funciona
+*/
+
+// Opcodes do CPython 3.10 usados pelos consumidores do bytecode
+enum Opcode : uint8_t {
+    OP_POP_TOP = 1,
+    OP_ROT_TWO = 2,
+    OP_ROT_THREE = 3,
+    OP_DUP_TOP = 4,
+    OP_NOP = 9,
+    OP_UNARY_NEGATIVE = 11,
+    OP_UNARY_NOT = 12,
+    OP_BINARY_POWER = 19,
+    OP_BINARY_MULTIPLY = 20,
+    OP_BINARY_MODULO = 22,
+    OP_BINARY_ADD = 23,
+    OP_BINARY_SUBTRACT = 24,
+    OP_BINARY_SUBSCR = 25,
+    OP_BINARY_FLOOR_DIVIDE = 26,
+    OP_BINARY_TRUE_DIVIDE = 27,
+    OP_INPLACE_FLOOR_DIVIDE = 28,
+    OP_INPLACE_TRUE_DIVIDE = 29,
+    OP_INPLACE_ADD = 55,
+    OP_INPLACE_SUBTRACT = 56,
+    OP_INPLACE_MULTIPLY = 57,
+    OP_INPLACE_MODULO = 59,
+    OP_STORE_SUBSCR = 60,
+    OP_INPLACE_POWER = 67,
+    OP_GET_ITER = 68,
+    OP_LOAD_BUILD_CLASS = 71,
+    OP_RETURN_VALUE = 83,
+    OP_STORE_NAME = 90,
+    OP_UNPACK_SEQUENCE = 92,
+    OP_FOR_ITER = 93,
+    OP_STORE_ATTR = 95,
+    OP_STORE_GLOBAL = 97,
+    OP_LOAD_CONST = 100,
+    OP_LOAD_NAME = 101,
+    OP_BUILD_TUPLE = 102,
+    OP_BUILD_LIST = 103,
+    OP_LOAD_ATTR = 106,
+    OP_COMPARE_OP = 107,
+    OP_JUMP_FORWARD = 110,
+    OP_JUMP_IF_FALSE_OR_POP = 111,
+    OP_JUMP_IF_TRUE_OR_POP = 112,
+    OP_JUMP_ABSOLUTE = 113,
+    OP_POP_JUMP_IF_FALSE = 114,
+    OP_POP_JUMP_IF_TRUE = 115,
+    OP_LOAD_GLOBAL = 116,
+    OP_IS_OP = 117,
+    OP_CONTAINS_OP = 118,
+    OP_JUMP_IF_NOT_EXC_MATCH = 121,
+    OP_SETUP_FINALLY = 122,
+    OP_LOAD_FAST = 124,
+    OP_STORE_FAST = 125,
+    OP_CALL_FUNCTION = 131,
+    OP_MAKE_FUNCTION = 132,
+    OP_LOAD_CLOSURE = 135,
+    OP_LOAD_DEREF = 136,
+    OP_STORE_DEREF = 137,
+    OP_CALL_FUNCTION_KW = 141,
+    OP_SETUP_WITH = 143,
+    OP_EXTENDED_ARG = 144,
+    OP_LIST_APPEND = 145,
+    OP_SETUP_ASYNC_WITH = 154,
+    OP_FORMAT_VALUE = 155,
+    OP_BUILD_STRING = 157,
+    OP_LOAD_METHOD = 160,
+    OP_CALL_METHOD = 161,
+    OP_LIST_EXTEND = 162,
+
+    // Superinstruções, em valores que o CPython 3.10 não usa. O argumento é o da primeira
+    // instrução; o da segunda é lido da instrução seguinte
+    OP_LOAD_FAST__LOAD_FAST = 200,
+    OP_LOAD_FAST__LOAD_CONST = 201,
+    OP_STORE_FAST__LOAD_FAST = 202,
+    OP_LOAD_CONST__RETURN_VALUE = 203,
+    OP_COMPARE_OP__POP_JUMP_IF_FALSE = 204,
+};
+
+// Se o argumento de opcode é um destino de salto (já absoluto na forma pré-decodificada)
+bool isJumpOpcode(uint8_t opcode);
+
+// Opcode original da primeira instrução de uma superinstrução; os demais são devolvidos
+// como estão. Para quem só inspeciona o bytecode, como scanCallees
+uint8_t unfusedOpcode(uint8_t opcode);
+
+struct Instruction {
+    uint8_t opcode = 0;
+    uint32_t arg = 0;
+};
+
+class Bytecode {
+public:
+    // Decodifica o co_code em hexadecimal. fuse = false mantém os opcodes originais
+    explicit Bytecode(const std::string& hex, bool fuse = true);
+
+    std::span<const Instruction> instructions() const { return code; }
+    size_t size() const { return code.size(); }
+    size_t superinstructions() const { return fused; }
+
+private:
+    std::vector<Instruction> code;
+    size_t fused = 0;
+};
+
+class Code;
+
+// Pré-decodifica o bytecode de toda a árvore a partir de root (materializando-a). Codes
+// que compartilham o mesmo texto de co_code (ver deduplicateCodes) compartilham também a
+// forma decodificada. Retorna a quantidade de textos decodificados
+size_t predecodeBytecode(Code& root);
+
+#endif
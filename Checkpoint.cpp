@@ -0,0 +1,486 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include "Checkpoint.hpp"
+#include "IoBackend.hpp"
+
+namespace {
+const char MAGIC[4] = {'C', 'F', 'C', 'K'};
+const uint32_t VERSION = 1;
+
+// Campos opcionais de um bloco
+const uint8_t BLOCK_GLOBALS = 0x01;
+const uint8_t BLOCK_SYMBOLS = 0x02;
+
+// Blocos em trânsito para a thread de escrita; com a fila cheia, capture espera
+const size_t WRITE_QUEUE_DEPTH = 8;
+
+struct CheckpointHeader {
+    char magic[4];
+    uint32_t version;
+};
+
+[[noreturn]] void throwErrno(const std::string& what, int error = errno) {
+    throw std::runtime_error(what + ": " + std::strerror(error));
+}
+
+void appendVarint(std::vector<uint8_t>& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+void appendString(std::vector<uint8_t>& out, std::string_view text) {
+    appendVarint(out, text.size());
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+void appendPath(std::vector<uint8_t>& out, const std::vector<uint32_t>& path) {
+    appendVarint(out, path.size());
+    for (uint32_t index : path) {
+        appendVarint(out, index);
+    }
+}
+
+// Leitura de um bloco; lança std::runtime_error ao passar do fim
+class BlockReader {
+public:
+    BlockReader(const uint8_t* data, size_t size) : position(data), end(data + size) {}
+
+    bool atEnd() const { return position == end; }
+
+    uint8_t byte() {
+        need(1);
+        return *position++;
+    }
+
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            uint8_t next = byte();
+            value |= static_cast<uint64_t>(next & 0x7f) << shift;
+            if (!(next & 0x80)) return value;
+        }
+        throw std::runtime_error("Checkpoint inválido: varint longo demais");
+    }
+
+    std::string_view bytes(size_t count) {
+        need(count);
+        std::string_view text(reinterpret_cast<const char*>(position), count);
+        position += count;
+        return text;
+    }
+
+    std::string_view string() { return bytes(varint()); }
+
+private:
+    const uint8_t* position;
+    const uint8_t* end;
+
+    void need(size_t count) const {
+        if (static_cast<size_t>(end - position) < count) {
+            throw std::runtime_error("Checkpoint inválido: bloco truncado");
+        }
+    }
+};
+
+// Formas do caminho de um frame empilhado
+const uint8_t FRAME_ABSOLUTE = 0;   // caminho a partir do frame raiz
+const uint8_t FRAME_CHILD = 1;      // índice em co_consts do frame logo abaixo
+
+// Code no fim do caminho a partir de root, materializando os do caminho
+Code* resolvePath(BlockReader& reader, Code& root) {
+    Code* code = &root;
+    size_t length = reader.varint();
+    for (size_t i = 0; i < length; ++i) {
+        code->materialize();
+        uint64_t index = reader.varint();
+        if (index >= code->co_consts.size() || !code->co_consts[index].isCode()) {
+            throw std::runtime_error("Checkpoint não corresponde à árvore de Codes: co_consts[" + std::to_string(index) + "]");
+        }
+        code = code->co_consts[index].asCode();
+    }
+    code->materialize();
+    return code;
+}
+
+VarType readValue(BlockReader& reader, Code& root) {
+    switch (static_cast<Value::Type>(reader.byte())) {
+        case Value::Type::Null:
+            return VarType();
+        case Value::Type::Int: {
+            uint64_t zigzag = reader.varint();
+            return VarType(static_cast<int>(static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1)));
+        }
+        case Value::Type::Float: {
+            float value;
+            std::memcpy(&value, reader.bytes(sizeof(value)).data(), sizeof(value));
+            return VarType(value);
+        }
+        case Value::Type::String:
+            return VarType(reader.string());
+        case Value::Type::Code:
+            return VarType(resolvePath(reader, root));
+        case Value::Type::Bool:
+            return VarType(reader.byte() != 0);
+    }
+    throw std::runtime_error("Checkpoint inválido: tipo de valor desconhecido");
+}
+
+void readVector(BlockReader& reader, Code& root, std::vector<VarType>& values) {
+    size_t count = reader.varint();
+    values.clear();
+    values.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        values.push_back(readValue(reader, root));
+    }
+}
+
+void readStrings(BlockReader& reader, std::vector<std::string>& strings) {
+    size_t count = reader.varint();
+    for (size_t i = 0; i < count; ++i) {
+        strings.emplace_back(reader.string());
+    }
+}
+
+// Aplica um bloco sobre o estado lido até aqui
+void readBlock(BlockReader& reader, Code& root, SavedSession& saved, bool first) {
+    saved.record = reader.varint();
+    uint8_t flags = reader.byte();
+    if (flags & BLOCK_GLOBALS) {
+        readVector(reader, root, saved.globals);
+    } else if (first) {
+        throw std::runtime_error("Checkpoint inválido: primeiro bloco sem as globais");
+    }
+
+    size_t keep = reader.varint();
+    if (keep > saved.frames.size() || (first && keep != 0)) {
+        throw std::runtime_error("Checkpoint inválido: pilha inconsistente entre blocos");
+    }
+    saved.frames.resize(keep);
+    size_t pushed = reader.varint();
+    for (size_t i = 0; i < pushed; ++i) {
+        Code* below = saved.frames.empty() ? nullptr : saved.frames.back().code;
+        SavedFrame& frame = saved.frames.emplace_back();
+        if (reader.byte() == FRAME_CHILD && below) {
+            uint64_t index = reader.varint();
+            if (index >= below->co_consts.size() || !below->co_consts[index].isCode()) {
+                throw std::runtime_error("Checkpoint não corresponde à árvore de Codes: co_consts[" + std::to_string(index) + "]");
+            }
+            frame.code = below->co_consts[index].asCode();
+            frame.code->materialize();
+        } else {
+            frame.code = resolvePath(reader, root);
+        }
+        for (size_t table = 1; table <= 4; ++table) {
+            readVector(reader, root, frame.tables.vectors[table]);
+        }
+        frame.tables.count = 5;
+    }
+    if (saved.frames.empty() || saved.frames[0].code != &root) {
+        throw std::runtime_error("Checkpoint inválido: a pilha não começa no frame raiz");
+    }
+
+    saved.symbols = flags & BLOCK_SYMBOLS;
+    if (saved.symbols) {
+        readStrings(reader, saved.incoming);
+        readStrings(reader, saved.outgoing);
+    }
+    if (!reader.atEnd()) {
+        throw std::runtime_error("Checkpoint inválido: bytes além do fim do bloco");
+    }
+}
+
+void writeAll(int fd, const std::vector<uint8_t>& bytes, const std::string& path) {
+    const uint8_t* data = bytes.data();
+    size_t size = bytes.size();
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throwErrno("write " + path);
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+    if (::fdatasync(fd) != 0) {
+        throwErrno("fdatasync " + path);
+    }
+}
+}
+
+SavedSession readCheckpoint(const std::string& path, Code& root) {
+    std::vector<uint8_t> in = readInput(path, IoBackend::Posix);
+    CheckpointHeader header;
+    if (in.size() < sizeof(header)) {
+        throw std::runtime_error("Checkpoint truncado: " + path);
+    }
+    std::memcpy(&header, in.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+        throw std::runtime_error("Arquivo não é um checkpoint: " + path);
+    }
+
+    SavedSession saved;
+    size_t position = sizeof(header);
+    bool first = true;
+    while (in.size() - position >= sizeof(uint32_t)) {
+        uint32_t size;
+        std::memcpy(&size, in.data() + position, sizeof(size));
+        if (in.size() - position - sizeof(size) < size) {
+            break;  // gravação interrompida no meio do bloco
+        }
+        BlockReader reader(in.data() + position + sizeof(size), size);
+        readBlock(reader, root, saved, first);
+        position += sizeof(size) + size;
+        first = false;
+    }
+    if (first) {
+        throw std::runtime_error("Checkpoint sem nenhum bloco completo: " + path);
+    }
+    return saved;
+}
+
+void restoreSession(SavedSession& saved, FrameStack& frames, std::vector<VarType>& globals,
+                    SessionSymbols* symbols, const std::function<void(Code&)>& push) {
+    if (saved.symbols != (symbols != nullptr)) {
+        throw std::runtime_error(saved.symbols ? "Checkpoint gravado no modo de símbolos"
+                                               : "Checkpoint gravado fora do modo de símbolos");
+    }
+    if (frames.depth() != 1 || &frames.topCode() != saved.frames[0].code) {
+        throw std::runtime_error("Checkpoint só pode ser restaurado em uma sessão recém-criada");
+    }
+    if (symbols) {
+        for (const std::string& text : saved.incoming) symbols->incoming.intern(text);
+        for (const std::string& text : saved.outgoing) symbols->outgoing.intern(text);
+    }
+    for (size_t i = 0; i < saved.frames.size(); ++i) {
+        if (i > 0) {
+            push(*saved.frames[i].code);
+        }
+        DecodedPayload& tables = saved.frames[i].tables;
+        tables.vectors[0] = saved.globals;
+        frames.updateTop(tables, globals);
+    }
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& path, Code& root, unsigned fullInterval)
+    : path(path), root(root), fullInterval(std::max(1u, fullInterval)), queue(WRITE_QUEUE_DEPTH) {
+    writer = std::thread([this]() {
+        try {
+            writeBlocks();
+        } catch (...) {
+            writeError = std::current_exception();
+            queue.cancel();
+        }
+    });
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    try {
+        close();
+    } catch (const std::exception&) {
+        // Sem como relatar no destrutor; close deve ser chamado antes para ver o erro
+    }
+}
+
+void CheckpointWriter::close() {
+    if (closed) return;
+    closed = true;
+    queue.close();
+    writer.join();
+    if (writeError) {
+        std::rethrow_exception(writeError);
+    }
+}
+
+const std::vector<uint32_t>& CheckpointWriter::pathOf(const Code* code) {
+    auto found = paths.find(code);
+    if (found != paths.end()) {
+        return found->second;
+    }
+
+    // Percorre os Codes já materializados; os demais não podem estar na pilha
+    paths.clear();
+    std::vector<const Code*> pending{&root};
+    paths[&root] = {};
+    while (!pending.empty()) {
+        const Code* parent = pending.back();
+        pending.pop_back();
+        if (!parent->isMaterialized()) continue;
+        for (size_t i = 0; i < parent->co_consts.size(); ++i) {
+            const VarType& constant = parent->co_consts[i];
+            if (!constant.isCode() || paths.count(constant.asCode())) continue;
+            std::vector<uint32_t> path = paths[parent];
+            path.push_back(static_cast<uint32_t>(i));
+            paths.emplace(constant.asCode(), std::move(path));
+            pending.push_back(constant.asCode());
+        }
+    }
+
+    found = paths.find(code);
+    if (found == paths.end()) {
+        throw std::runtime_error("Code fora da árvore do frame raiz");
+    }
+    return found->second;
+}
+
+void CheckpointWriter::appendFramePath(std::vector<uint8_t>& out, const Code* code, const Code* below) {
+    // Chamadas comuns resolvem o Code nas constantes do chamador: um índice basta, em vez
+    // de um caminho que cresce com a profundidade
+    if (below) {
+        for (size_t i = 0; i < below->co_consts.size(); ++i) {
+            if (below->co_consts[i].isCode() && below->co_consts[i].asCode() == code) {
+                out.push_back(FRAME_CHILD);
+                appendVarint(out, i);
+                return;
+            }
+        }
+    }
+    out.push_back(FRAME_ABSOLUTE);
+    appendPath(out, pathOf(code));
+}
+
+void CheckpointWriter::appendValue(std::vector<uint8_t>& out, const VarType& value) {
+    out.push_back(static_cast<uint8_t>(value.type()));
+    switch (value.type()) {
+        case Value::Type::Null:
+            break;
+        case Value::Type::Int: {
+            int64_t number = value.asInt();
+            appendVarint(out, static_cast<uint64_t>((number << 1) ^ (number >> 63)));
+            break;
+        }
+        case Value::Type::Float: {
+            float number = value.asFloat();
+            const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&number);
+            out.insert(out.end(), bytes, bytes + sizeof(number));
+            break;
+        }
+        case Value::Type::String:
+            appendString(out, value.asString());
+            break;
+        case Value::Type::Code:
+            appendPath(out, pathOf(value.asCode()));
+            break;
+        case Value::Type::Bool:
+            out.push_back(value.asBool() ? 1 : 0);
+            break;
+    }
+}
+
+void CheckpointWriter::appendVector(std::vector<uint8_t>& out, std::span<const VarType> values) {
+    appendVarint(out, values.size());
+    for (const VarType& value : values) {
+        appendValue(out, value);
+    }
+}
+
+void CheckpointWriter::capture(const SessionState& state, uint64_t record) {
+    if (closed) {
+        throw std::runtime_error("Checkpoint já encerrado: " + path);
+    }
+    if (state.frames.empty()) {
+        return;
+    }
+
+    block.full = captured % fullInterval == 0;
+    if (block.full) {
+        written.clear();
+        incomingWritten = 0;
+        outgoingWritten = 0;
+    }
+    std::vector<uint8_t>& out = block.bytes;
+    out.assign(sizeof(uint32_t), 0);    // tamanho, preenchido no fim
+
+    appendVarint(out, record);
+    bool globalsChanged = block.full || state.frames.globalsStamp() != globalsStamp;
+    out.push_back((globalsChanged ? BLOCK_GLOBALS : 0) | (state.symbols ? BLOCK_SYMBOLS : 0));
+    if (globalsChanged) {
+        appendVector(out, state.globals);
+        globalsStamp = state.frames.globalsStamp();
+    }
+
+    // Frames iguais aos da captura anterior, a partir da base
+    size_t depth = state.frames.depth();
+    size_t keep = 0;
+    while (keep < std::min(depth, written.size())) {
+        const Frame& frame = state.frames.frameAt(keep);
+        const FrameKey& key = written[keep];
+        if (frame.code != key.code || !std::equal(frame.versions, frame.versions + 4, key.versions)) break;
+        ++keep;
+    }
+    appendVarint(out, keep);
+    appendVarint(out, depth - keep);
+    written.resize(keep);
+    for (size_t i = keep; i < depth; ++i) {
+        const Frame& frame = state.frames.frameAt(i);
+        FrameTables tables = state.frames.tablesAt(i);
+        appendFramePath(out, frame.code, i > 0 ? state.frames.frameAt(i - 1).code : nullptr);
+        appendVector(out, tables.names);
+        appendVector(out, tables.varnames);
+        appendVector(out, tables.freevars);
+        appendVector(out, tables.cellvars);
+        FrameKey& key = written.emplace_back();
+        key.code = frame.code;
+        std::copy(frame.versions, frame.versions + 4, key.versions);
+    }
+
+    if (state.symbols) {
+        auto appendNew = [&out](const SymbolTable& table, size_t& from) {
+            appendVarint(out, table.size() - from);
+            for (; from < table.size(); ++from) {
+                appendString(out, table.handle(static_cast<uint32_t>(from)).asString());
+            }
+        };
+        appendNew(state.symbols->incoming, incomingWritten);
+        appendNew(state.symbols->outgoing, outgoingWritten);
+    }
+
+    uint32_t size = static_cast<uint32_t>(out.size() - sizeof(uint32_t));
+    std::memcpy(out.data(), &size, sizeof(size));
+    ++captured;
+    encoded += out.size();
+    if (!queue.push(block)) {
+        // A thread de escrita parou; o erro aparece em close
+        close();
+    }
+}
+
+void CheckpointWriter::writeBlocks() {
+    int fd = -1;
+    Block next;
+    std::string temporary = path + ".tmp";
+    try {
+        while (queue.pop(next)) {
+            if (next.full) {
+                // Estado inteiro: arquivo novo, que só substitui o anterior depois de gravado
+                int replacement = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+                if (replacement < 0) {
+                    throwErrno("open " + temporary);
+                }
+                if (fd >= 0) ::close(fd);
+                fd = replacement;
+                CheckpointHeader header{};
+                std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+                header.version = VERSION;
+                next.bytes.insert(next.bytes.begin(), reinterpret_cast<const uint8_t*>(&header),
+                                  reinterpret_cast<const uint8_t*>(&header) + sizeof(header));
+                writeAll(fd, next.bytes, temporary);
+                if (::rename(temporary.c_str(), path.c_str()) != 0) {
+                    throwErrno("rename " + temporary);
+                }
+            } else if (fd >= 0) {
+                writeAll(fd, next.bytes, path);
+            }
+        }
+    } catch (...) {
+        if (fd >= 0) ::close(fd);
+        throw;
+    }
+    if (fd >= 0) ::close(fd);
+}
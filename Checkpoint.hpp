@@ -0,0 +1,140 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Code.hpp"
+#include "Frame.hpp"
+#include "Pipeline.hpp"
+#include "Symbols.hpp"
+
+/*
+    * Checkpoint de uma sessão, para retomar o fluxo do mestre a partir do último registro
+    * gravado em vez de repeti-lo desde o INIT. O arquivo é um cabeçalho seguido de blocos:
+    *
+    *   [cabeçalho "CFCK" + versão][tamanho uint32][bloco][tamanho uint32][bloco]...
+    *
+    * O primeiro bloco tem o estado inteiro; cada um dos seguintes só o que mudou desde o
+    * anterior:
+    *
+    *   - registros aplicados até a captura
+    *   - as globais, se mudaram
+    *   - quantos frames da base da pilha continuam iguais, e os frames acima deles: o
+    *     caminho do Code (índices em co_consts a partir do frame raiz, estável com a carga
+    *     sob demanda e com --dedup; só o último índice quando o Code está nas constantes do
+    *     frame logo abaixo) e as quatro tabelas da ativação
+    *   - as strings novas das tabelas de símbolos, que só crescem
+    *
+    * Um frame é igual ao da captura anterior quando tem o mesmo Code e as mesmas versões
+    * de tabela (ver FrameStack::updateTop), que nunca se repetem em uma sessão. Inteiros
+    * usam varint e strings vêm com o tamanho na frente; um bloco incompleto no fim do
+    * arquivo (gravação interrompida) é ignorado na leitura.
+*/
+
+// Estado de uma sessão lido na captura, sem cópia (ver Dispatcher::state)
+struct SessionState {
+    const FrameStack& frames;
+    const std::vector<VarType>& globals;
+    const SessionSymbols* symbols;      // nullptr fora do modo de símbolos
+};
+
+// Frame lido do checkpoint: o Code, já localizado pelo caminho e materializado, e as
+// tabelas da ativação em tables.vectors[1] a [4]
+struct SavedFrame {
+    Code* code = nullptr;
+    DecodedPayload tables;
+};
+
+// Estado de uma sessão lido por readCheckpoint
+struct SavedSession {
+    uint64_t record = 0;        // registros do fluxo já aplicados
+    bool symbols = false;       // gravado no modo de símbolos
+    std::vector<VarType> globals;
+    std::vector<SavedFrame> frames;     // do frame raiz ao topo
+    std::vector<std::string> incoming;  // strings das tabelas de símbolos, na ordem dos ids
+    std::vector<std::string> outgoing;
+};
+
+// Lê o checkpoint de uma sessão cujo frame raiz é root; lança std::runtime_error se o
+// arquivo não for um checkpoint ou não corresponder à árvore de root
+SavedSession readCheckpoint(const std::string& path, Code& root);
+
+// Leva saved a uma sessão recém-criada, com só o frame raiz: restaura as tabelas de
+// símbolos e empilha os frames com push (que também dá conta das estruturas da sessão,
+// como as corrotinas do FrameExecutor), cada um recebendo as suas tabelas ao chegar ao topo
+void restoreSession(SavedSession& saved, FrameStack& frames, std::vector<VarType>& globals,
+                    SessionSymbols* symbols, const std::function<void(Code&)>& push);
+
+// Grava os checkpoints de uma sessão. capture codifica, na thread chamadora, só o que
+// mudou desde a captura anterior; a escrita no arquivo (com fdatasync) fica em uma thread
+// própria. A cada fullInterval capturas o estado inteiro é gravado em um arquivo novo, que
+// substitui o anterior com rename, e o arquivo não cresce sem limite
+class CheckpointWriter {
+public:
+    static const unsigned DEFAULT_FULL_INTERVAL = 64;
+
+    CheckpointWriter(const std::string& path, Code& root, unsigned fullInterval = DEFAULT_FULL_INTERVAL);
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    // Espera a gravação pendente; erros de escrita só são relatados por close
+    ~CheckpointWriter();
+
+    // Captura o estado depois de record registros aplicados. Uma sessão encerrada não
+    // tem o que retomar, e não é gravada
+    void capture(const SessionState& state, uint64_t record);
+
+    // Espera a gravação de tudo o que foi capturado; relança o erro da thread de escrita
+    void close();
+
+    uint64_t captures() const { return captured; }
+    uint64_t bytesEncoded() const { return encoded; }
+
+private:
+    // Bloco em trânsito para a thread de escrita
+    struct Block {
+        bool full = false;
+        std::vector<uint8_t> bytes;
+    };
+
+    // Identifica o conteúdo de um frame já gravado
+    struct FrameKey {
+        const Code* code;
+        uint64_t versions[4];
+    };
+
+    std::string path;
+    Code& root;
+    unsigned fullInterval;
+    uint64_t captured = 0;
+    uint64_t encoded = 0;
+
+    // Estado já gravado, ponto de partida do próximo delta
+    std::vector<FrameKey> written;
+    uint64_t globalsStamp = 0;
+    size_t incomingWritten = 0;
+    size_t outgoingWritten = 0;
+
+    // Caminho de cada Code materializado a partir de root, refeito quando aparece um
+    // Code novo (carga sob demanda)
+    std::unordered_map<const Code*, std::vector<uint32_t>> paths;
+
+    SpscQueue<Block> queue;
+    Block block;
+    std::thread writer;
+    std::exception_ptr writeError;
+    bool closed = false;
+
+    const std::vector<uint32_t>& pathOf(const Code* code);
+    void appendFramePath(std::vector<uint8_t>& out, const Code* code, const Code* below);
+    void appendValue(std::vector<uint8_t>& out, const VarType& value);
+    void appendVector(std::vector<uint8_t>& out, std::span<const VarType> values);
+    void writeBlocks();
+};
+
+#endif
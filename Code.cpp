@@ -2,14 +2,19 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <variant>
 #include <stack>
 #include <sstream>
 #include <typeinfo>
 #include "include/json.hpp"
 #include <bitset>
 #include <iomanip>
+#include <thread>
+#include <charconv>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include "Code.hpp"
+#include "Bytecode.hpp"
 
 const std::unordered_map<std::string, std::string> PayloadType::typeMap = {
     {"Code", "100"},
@@ -39,6 +44,24 @@ void writeBinaryInt32(std::ostream& os, uint32_t value) {
     os.write(reinterpret_cast<const char*>(&value), sizeof(value));
 }
 
+// Inteiro sem sinal em grupos de 7 bits, do menos significativo para o mais, com o bit
+// alto marcando que há outro byte: valores abaixo de 128 ocupam um só byte
+void writeVarint(std::ostream& os, uint32_t value) {
+    while (value >= 0x80) {
+        os.put(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    os.put(static_cast<char>(value));
+}
+
+void writeSize(std::ostream& os, uint32_t value, PayloadCodec codec) {
+    if (codec == PayloadCodec::V2) {
+        writeVarint(os, value);
+    } else {
+        writeBinaryInt32(os, value);
+    }
+}
+
 void hexToBinaryStream(const std::string& hex, std::ostream& outStream) {
     for (size_t i = 0; i < hex.length(); i += 2) {
         std::string byteStr = hex.substr(i, 2);  // Pega dois caracteres (um byte)
@@ -50,214 +73,553 @@ void hexToBinaryStream(const std::string& hex, std::ostream& outStream) {
     }
 }
 
-std::vector<VarType> Code::globals;
-
-Code::Code(const std::string& code) : co_code(code) {}
+Code::Code(const std::string& code) : co_code(std::make_shared<const std::string>(code)) {}
 
-void Code::setCoCode(const std::string& code) { co_code = code; }
+void Code::setCoCode(const std::string& code) {
+    co_code = std::make_shared<const std::string>(code);
+    bytecode = nullptr;
+    payloadPrecomputed = false;
+}
 void Code::setCoNames(const std::vector<VarType>& names) { co_names = names; }
 void Code::setCoVarnames(const std::vector<VarType>& varnames) { co_varnames = varnames; }
 void Code::setCoFreevars(const std::vector<VarType>& freevars) { co_freevars = freevars; }
 void Code::setCoCellvars(const std::vector<VarType>& cellvars) { co_cellvars = cellvars; }
-void Code::setCoConsts(const std::vector<VarType>& consts) { co_consts = consts; }
+void Code::setCoConsts(const std::vector<VarType>& consts) {
+    co_consts = consts;
+    payloadPrecomputed = false;
+}
+
+VarType Code::addChild(Code&& child) {
+    children.push_back(std::make_unique<Code>(std::move(child)));
+    return VarType(children.back().get());
+}
+
+void Code::materialize() {
+    if (isMaterialized()) {
+        return;
+    }
+    // Se load lançar, a carga fica pendente e a próxima chamada tenta de novo
+    std::call_once(pendingLoad->once, [this]() {
+        pendingLoad->load(*this);
+        pendingLoad->load = nullptr;
+        pendingLoad->done.store(true, std::memory_order_release);
+    });
+}
+
+namespace {
+// Converte uma string de 3 bits em um byte
+char bitsToByte(const std::string& bits) {
+    return static_cast<char>(std::bitset<3>(bits).to_ulong());
+}
+}
+
+char typeCodeByte(const std::string& typeName) {
+    return bitsToByte(PayloadType::typeMap.at(typeName));
+}
+
+namespace {
+// Zigzag: intercala positivos e negativos (0, -1, 1, -2, ...) para que inteiros pequenos
+// de qualquer sinal virem varints curtos
+uint32_t zigzagEncode(int32_t value) {
+    return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+}
 
-void Code::print() const {
-    std::cout << std::endl << "co_code: " << co_code << std::endl;
+int32_t zigzagDecode(uint32_t value) {
+    return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+}
+
+void writeFloat32LE(std::ostream& os, float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    char bytes[4] = {static_cast<char>(bits), static_cast<char>(bits >> 8),
+                     static_cast<char>(bits >> 16), static_cast<char>(bits >> 24)};
+    os.write(bytes, sizeof(bytes));
+}
+}
+
+// Escreve o código de tipo seguido do dado de um item de vetor ou de co_consts
+void writeTypedValue(std::ostream& os, const VarType& item, PayloadCodec codec) {
+    const char NULL_CHAR = 0;  // ASCII NULL
+
+    switch (item.type()) {
+        case Value::Type::Code:
+            os << bitsToByte(PayloadType::typeMap.at("Code"));  // Código para Code como byte binário
+            os << NULL_CHAR;
+            break;
+        case Value::Type::Null:
+            os << bitsToByte(PayloadType::typeMap.at("nullptr_t"));  // Código para nullptr como byte binário
+            os << NULL_CHAR;
+            break;
+        case Value::Type::Int:
+            os << bitsToByte(PayloadType::typeMap.at("int"));  // Código para int como byte binário
+            if (codec == PayloadCodec::V2) {
+                writeVarint(os, zigzagEncode(item.asInt()));
+            } else {
+                writeBinaryInt32(os, item.asInt());
+            }
+            break;
+        case Value::Type::Float:
+            os << bitsToByte(PayloadType::typeMap.at("float"));  // Código para float como byte binário
+            if (codec == PayloadCodec::V2) {
+                writeFloat32LE(os, item.asFloat());
+            } else {
+                os << item.asFloat();
+            }
+            break;
+        case Value::Type::String:
+            os << bitsToByte(PayloadType::typeMap.at("string"));  // Código para string como byte binário
+            os << item.asString();
+            break;
+        case Value::Type::Bool:
+            os << bitsToByte(PayloadType::typeMap.at("bool"));  // Código para bool como byte binário
+            os << (item.asBool() ? "1" : "0");
+            break;
+    }
+}
+
+void Code::print(std::ostream& os, const std::vector<VarType>& globals) const {
+    print(os, globals, tables());
+}
 
-    auto printVector = [](const std::vector<VarType>& vec) {
+void Code::print(std::ostream& os, const std::vector<VarType>& globals, const FrameTables& frame) const {
+    os << std::endl << "co_code: " << *co_code << std::endl;
+
+    auto printVector = [&os](std::span<const VarType> vec) {
         for (const auto& item : vec) {
-            std::visit([](const auto& val) {
-                using T = std::decay_t<decltype(val)>;
-                if constexpr (std::is_same_v<T, Code>) {
-                    std::cout << "<code> ";
-                } else if constexpr (std::is_same_v<T, std::nullptr_t>) {
-                    std::cout << "null ";
-                } else if constexpr (std::is_integral_v<T>) {
-                    std::cout << val << " ";
-                } else if constexpr (std::is_floating_point_v<T>) {
-                    std::cout << val << " ";
-                } else {
-                    std::cout << "\"" << val << "\"" << " ";
-                }
-            }, item);
+            switch (item.type()) {
+                case Value::Type::Code:
+                    os << "<code> ";
+                    break;
+                case Value::Type::Null:
+                    os << "null ";
+                    break;
+                case Value::Type::Int:
+                    os << item.asInt() << " ";
+                    break;
+                case Value::Type::Bool:
+                    os << item.asBool() << " ";
+                    break;
+                case Value::Type::Float:
+                    os << item.asFloat() << " ";
+                    break;
+                case Value::Type::String:
+                    os << "\"" << item.asString() << "\"" << " ";
+                    break;
+            }
         }
-        std::cout << std::endl;
+        os << std::endl;
     };
 
-    std::cout << "globals: ";
-    printVector(Code::globals);
+    os << "globals: ";
+    printVector(globals);
 
-    std::cout << "co_names: ";
-    printVector(co_names);
+    os << "co_names: ";
+    printVector(frame.names);
 
-    std::cout << "co_varnames: ";
-    printVector(co_varnames);
+    os << "co_varnames: ";
+    printVector(frame.varnames);
 
-    std::cout << "co_freevars: ";
-    printVector(co_freevars);
+    os << "co_freevars: ";
+    printVector(frame.freevars);
 
-    std::cout << "co_cellvars: ";
-    printVector(co_cellvars);
+    os << "co_cellvars: ";
+    printVector(frame.cellvars);
 
-    std::cout << "co_consts: ";
+    os << "co_consts: ";
     printVector(co_consts);
 }
 
 // Método para acessar um objeto Code aninhado
-Code& Code::getCodeFromVariable(size_t vector, size_t index) {
+Code& Code::getCodeFromVariable(const std::vector<VarType>& globals, size_t vector, size_t index) {
+    return getCodeFromVariable(globals, tables(), vector, index);
+}
+
+Code& Code::getCodeFromVariable(const std::vector<VarType>& globals, const FrameTables& frame, size_t vector, size_t index) {
     if (index >= co_consts.size()) {
         throw std::out_of_range("Index out of range for co_consts");
     }
 
-    std::vector<VarType>* targetVector = nullptr;
+    std::span<const VarType> targetVector;
 
     switch (vector) {
         case 0:
-            targetVector = &Code::globals;
+            targetVector = globals;
             break;
         case 1:
-            targetVector = &co_names;
+            targetVector = frame.names;
             break;
         case 2:
-            targetVector = &co_varnames;
+            targetVector = frame.varnames;
             break;
         case 3:
-            targetVector = &co_freevars;
+            targetVector = frame.freevars;
             break;
         case 4:
-            targetVector = &co_cellvars;
+            targetVector = frame.cellvars;
             break;
         default:
             throw std::invalid_argument("Invalid dstVector value.");
     }
 
     // Verifica se o índice está dentro dos limites do vetor
-    if (index >= targetVector->size()) {
+    if (index >= targetVector.size()) {
         throw std::out_of_range("Index out of range for targetVector");
     }
 
     // Verifica se o elemento no índice é do tipo int
-    if (!std::holds_alternative<int>((*targetVector)[index])) {
+    if (!targetVector[index].isInt()) {
         throw std::runtime_error("Code::getCodeFromVariable -> elemento no índice não é um int");
     }
 
     // Recupera o índice do elemento em co_consts
-    int constsIndex = std::get<int>((*targetVector)[index]);
+    int constsIndex = targetVector[index].asInt();
+    if (constsIndex < 0 || static_cast<size_t>(constsIndex) >= co_consts.size()) {
+        throw std::out_of_range("Index out of range for co_consts");
+    }
 
     // Verifica se o elemento em constsIndex é do tipo Code
-    if (std::holds_alternative<Code>(co_consts[constsIndex])) {
-        return std::get<Code>(co_consts[constsIndex]); // Retorna a referência ao objeto Code
+    if (co_consts[constsIndex].isCode()) {
+        Code& child = *co_consts[constsIndex].asCode();
+        child.materialize();  // Filhos de carga adiada são lidos na primeira chamada
+        return child; // Retorna a referência ao objeto Code
     } else {
         throw std::runtime_error("Tentativa de acesso a Code filho, porém o index não é de um objeto Code");
     }
 }
 
     
-std::string Code::generatePayload() const {
-    const char GS = 29;  // ASCII Group Separator
-    const char US = 31;  // ASCII Unit Separator
-    const char NULL_CHAR = 0;  // ASCII NULL
+std::string Code::generatePayload(const std::vector<VarType>& globals) const {
+    return generatePayload(globals, tables());
+}
 
-    // Função para converter uma string de 3 bits em um byte
-    auto bitsToByte = [](const std::string& bits) -> char {
-        return static_cast<char>(std::bitset<3>(bits).to_ulong());
-    };
+namespace {
+// Blocos de generatePayload que não dependem da ativação: GS co_code GS e CONSTS GS
+void writeCodeBlock(std::ostream& os, const std::string& co_code) {
+    const char GS = 29;
+    os << GS;
+    hexToBinaryStream(co_code, os);
+    os << GS;
+}
 
-    std::ostringstream result;
-    result << GS;
-    hexToBinaryStream(co_code, result);
-    result << GS;
-
-    // Função lambda para formatar um vetor com códigos de tipo
-    auto formatVector = [&](const std::vector<VarType>& vec) -> std::string {
-        std::ostringstream oss;
-        writeBinaryInt32(oss, vec.size());
-        for (const auto& item : vec) {
-            oss << US;  // Inicia o item com um US
-            
-            std::visit([&oss, &bitsToByte, this](const auto& val) {
-                using T = std::decay_t<decltype(val)>;
-                if constexpr (std::is_same_v<T, Code>) {
-                    oss << bitsToByte(PayloadType::typeMap.at("Code"));  // Código para Code como byte binário
-                    oss << NULL_CHAR;
-                } else if constexpr (std::is_same_v<T, std::nullptr_t>) {
-                    oss << bitsToByte(PayloadType::typeMap.at("nullptr_t"));  // Código para nullptr como byte binário
-                    oss << NULL_CHAR;
-                } else if constexpr (std::is_integral_v<T>) {
-                    oss << bitsToByte(PayloadType::typeMap.at("int"));  // Código para int como byte binário
-                    writeBinaryInt32(oss, val);
-                } else if constexpr (std::is_floating_point_v<T>) {
-                    oss << bitsToByte(PayloadType::typeMap.at("float"));  // Código para float como byte binário
-                    oss << val;
-                } else if constexpr (std::is_same_v<T, std::string>) {
-                    oss << bitsToByte(PayloadType::typeMap.at("string"));  // Código para string como byte binário
-                    oss << val;
-                } else if constexpr (std::is_same_v<T, bool>) {
-                    oss << bitsToByte(PayloadType::typeMap.at("bool"));  // Código para bool como byte binário
-                    oss << (val ? "1" : "0");
-                } else {
-                    oss << bitsToByte(PayloadType::typeMap.at("unknown"));  // Código reservado como byte binário
-                    oss << "undefined";  // Placeholder para tipos não especificados
-                }
-            }, item);
+void writeConstsBlock(std::ostream& os, const std::vector<VarType>& co_consts, PayloadCodec codec) {
+    const char GS = 29;
+    const char US = 31;
+
+    // Formata o campo CONSTS, sem incluir o tamanho
+    for (size_t i = 0; i < co_consts.size(); ++i) {
+        if (i > 0) os << US;
+        writeTypedValue(os, co_consts[i], codec);
+    }
+    os << GS;
+}
+}
+
+void Code::precomputePayload(PayloadCodec codec) {
+    // Codifica fora da trava; só a troca dos blocos é feita sob ela
+    std::ostringstream codeBlock;
+    writeCodeBlock(codeBlock, *co_code);
+    std::ostringstream constsBlock;
+    writeConstsBlock(constsBlock, co_consts, codec);
+
+    std::lock_guard<std::mutex> lock(*cacheLock);
+    encodedCode = codeBlock.str();
+    encodedConsts = constsBlock.str();
+    precomputedCodec = codec;
+    payloadPrecomputed = true;
+}
+
+bool Code::hasPrecomputedPayload(PayloadCodec codec) const {
+    std::lock_guard<std::mutex> lock(*cacheLock);
+    return payloadPrecomputed && precomputedCodec == codec;
+}
+
+const Bytecode& Code::decodedBytecode() {
+    materialize();
+    // O Bytecode em cache só é descartado por setCoCode, na carga
+    std::lock_guard<std::mutex> lock(*cacheLock);
+    if (!bytecode) {
+        bytecode = std::make_shared<const Bytecode>(*co_code);
+    }
+    return *bytecode;
+}
+
+size_t precomputePayloads(Code& root, unsigned threadCount, PayloadCodec codec) {
+    // A materialização altera a árvore, então é feita antes, em uma só thread
+    std::vector<Code*> codes;
+    std::vector<Code*> pending{&root};
+    while (!pending.empty()) {
+        Code* code = pending.back();
+        pending.pop_back();
+        code->materialize();
+        codes.push_back(code);
+        for (auto& child : code->children) {
+            pending.push_back(child.get());
+        }
+    }
+
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, codes.size()));
+
+    // Cada Code é codificado por uma única thread; o índice compartilhado distribui o trabalho
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i = next++; i < codes.size(); i = next++) {
+            codes[i]->precomputePayload(codec);
         }
-        return oss.str();
     };
 
-    // Concatena cada campo formatado com GS entre eles
-    result << formatVector(Code::globals) << GS;
-    result << formatVector(co_names) << GS;
-    result << formatVector(co_varnames) << GS;
-    result << formatVector(co_freevars) << GS;
-    result << formatVector(co_cellvars) << GS;
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threadCount; ++i) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    return codes.size();
+}
+
+namespace {
+// Um vetor de variáveis com seu tamanho e seus itens com códigos de tipo, terminado por GS
+void writeTableVector(std::ostream& os, std::span<const VarType> vec, const PayloadOptions& options) {
+    const char GS = 29;  // ASCII Group Separator
+    const char US = 31;  // ASCII Unit Separator
+    SymbolTable* symbols = options.symbols;
+
+    writeSize(os, vec.size(), options.codec);
+    for (const auto& item : vec) {
+        os << US;  // Inicia o item com um US
+        bool added = true;
+        uint32_t id = 0;
+        if (symbols && item.isString()) {
+            id = symbols->intern(item.asString(), &added);
+        }
+        if (added) {
+            writeTypedValue(os, item, options.codec);
+        } else if (options.codec == PayloadCodec::V2) {
+            os << typeCodeByte("custom");
+            writeVarint(os, id);
+        } else {
+            os << typeCodeByte("custom") << id;  // Id em decimal: nunca colide com GS/US
+        }
+    }
+    os << GS;
+}
+
+// CONSTS com os Codes aninhados embutidos até options.inlineDepth níveis abaixo de depth.
+// sent guarda os Codes já escritos na resposta; a posição de cada um é o seu ordinal
+void writeNestedConstsBlock(std::ostream& os, const std::vector<VarType>& co_consts, const PayloadOptions& options,
+                            unsigned depth, std::vector<const Code*>& sent) {
+    const char GS = 29;
+    const char US = 31;
 
-    // Formata o campo CONSTS, sem incluir o tamanho
     for (size_t i = 0; i < co_consts.size(); ++i) {
-        if (i > 0) result << US;
-        std::visit([&result, &bitsToByte, this](const auto& val) {
-            using T = std::decay_t<decltype(val)>;
-            if constexpr (std::is_same_v<T, Code>) {
-                result << bitsToByte(PayloadType::typeMap.at("Code"));  // NULL_CHAR para Code ou nullptr como byte binário
-                result << NULL_CHAR;
-            } else if constexpr (std::is_same_v<T, std::nullptr_t>) {
-                result << bitsToByte(PayloadType::typeMap.at("nullptr_t"));  // NULL_CHAR para Code ou nullptr como byte binário
-                result << NULL_CHAR;
-            } else if constexpr (std::is_integral_v<T>) {
-                result << bitsToByte(PayloadType::typeMap.at("int"));  // Código para int como byte binário
-                writeBinaryInt32(result, val);
-            } else if constexpr (std::is_floating_point_v<T>) {
-                result << bitsToByte(PayloadType::typeMap.at("float"));  // Código para float como byte binário
-                result << val;
-            } else if constexpr (std::is_same_v<T, std::string>) {
-                result << bitsToByte(PayloadType::typeMap.at("string"));  // Código para string como byte binário
-                result << val;
-            } else if constexpr (std::is_same_v<T, bool>) {
-                result << bitsToByte(PayloadType::typeMap.at("bool"));  // Código para bool como byte binário
-                result << (val ? "1" : "0");
-            } else {
-                result << bitsToByte(PayloadType::typeMap.at("unkown"));  // Código reservado como byte binário
-                result << "undefined";  // Placeholder para tipos não especificados
-            }
-        }, co_consts[i]);
+        if (i > 0) os << US;
+        const VarType& item = co_consts[i];
+        if (!item.isCode()) {
+            writeTypedValue(os, item, options.codec);
+            continue;
+        }
+
+        Code& child = *item.asCode();
+        os << typeCodeByte("Code");
+        auto seen = std::find(sent.begin(), sent.end(), &child);
+        if (seen != sent.end()) {
+            os.put(static_cast<char>(NestedCodeTag::Ref));
+            writeSize(os, static_cast<uint32_t>(seen - sent.begin()), options.codec);
+        } else if (depth >= options.inlineDepth) {
+            os.put(static_cast<char>(NestedCodeTag::None));
+        } else {
+            child.materialize();  // Filhos de carga adiada são lidos para serem enviados
+            sent.push_back(&child);
+
+            std::ostringstream body;
+            writeCodeBlock(body, child.getCoCode());
+            writeTableVector(body, child.co_names, options);
+            writeTableVector(body, child.co_varnames, options);
+            writeTableVector(body, child.co_freevars, options);
+            writeTableVector(body, child.co_cellvars, options);
+            writeNestedConstsBlock(body, child.co_consts, options, depth + 1, sent);
+
+            std::string encoded = std::move(body).str();
+            os.put(static_cast<char>(NestedCodeTag::Inline));
+            writeSize(os, static_cast<uint32_t>(encoded.size()), options.codec);
+            os << encoded;
+        }
     }
+    os << GS;
+}
+}
 
-    result << GS;
-    
-    // Salva o payload em um arquivo binário
-    std::string resultString = result.str();
-    std::ofstream outFile("output.bin", std::ios::binary);
-    if (outFile) {
-        outFile.write(resultString.data(), resultString.size());  // Escreve os dados da string no arquivo binário
+void writeFrameTables(std::ostream& os, const std::vector<VarType>& globals, const FrameTables& frame,
+                      const PayloadOptions& options) {
+    writeTableVector(os, globals, options);
+    writeTableVector(os, frame.names, options);
+    writeTableVector(os, frame.varnames, options);
+    writeTableVector(os, frame.freevars, options);
+    writeTableVector(os, frame.cellvars, options);
+}
+
+std::string Code::generatePayload(const std::vector<VarType>& globals, const FrameTables& frame,
+                                  const PayloadOptions& options) const {
+    std::ostringstream result;
+    bool precomputed;
+    {
+        std::lock_guard<std::mutex> lock(*cacheLock);
+        precomputed = payloadPrecomputed;
+        if (precomputed) {
+            result << encodedCode;
+        }
+    }
+    if (!precomputed) {
+        writeCodeBlock(result, *co_code);
+    }
+
+    writeFrameTables(result, globals, frame, options);
+
+    bool hasNested = std::ranges::any_of(co_consts, [](const VarType& item) { return item.isCode(); });
+    if (options.inlineDepth > 0 && hasNested) {
+        std::vector<const Code*> sent{this};
+        writeNestedConstsBlock(result, co_consts, options, 0, sent);
     } else {
-        std::cerr << "Erro ao abrir o arquivo para escrita!" << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(*cacheLock);
+            precomputed = payloadPrecomputed && precomputedCodec == options.codec;
+            if (precomputed) {
+                result << encodedConsts;
+            }
+        }
+        if (!precomputed) {
+            writeConstsBlock(result, co_consts, options.codec);
+        }
     }
-    
+
     return result.str();
 }
 
-void Code::updateFromPayload(const std::string& payload) {
+void Code::updateFromPayload(const std::string& payload, std::vector<VarType>& globals) {
+    decodeFramePayload(payload, globals, co_names, co_varnames, co_freevars, co_cellvars);
+}
+
+namespace {
+// Decodificação da revisão V2: os itens são percorridos em sequência e o tamanho de cada
+// dado vem do seu tipo, porque números binários podem conter bytes iguais a GS ou US.
+// Cada vetor é uma série de itens "US tipo dado" terminada por GS
+class CompactReader {
+public:
+    explicit CompactReader(const std::string& data) : data(data) {}
+
+    bool atEnd() const { return pos >= data.size(); }
+
+    unsigned char byte() {
+        if (atEnd()) {
+            throw std::runtime_error("Payload V2 truncado");
+        }
+        return static_cast<unsigned char>(data[pos++]);
+    }
+
+    uint32_t varint() {
+        uint32_t value = 0;
+        for (int shift = 0; shift < 35; shift += 7) {
+            unsigned char b = byte();
+            value |= static_cast<uint32_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return value;
+        }
+        throw std::runtime_error("Varint inválido no payload");
+    }
+
+    float float32() {
+        uint32_t bits = 0;
+        for (int shift = 0; shift < 32; shift += 8) {
+            bits |= static_cast<uint32_t>(byte()) << shift;
+        }
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    // Texto até o próximo US ou GS (ou o fim do payload), sem consumir o separador
+    std::string_view text() {
+        size_t end = data.find_first_of("\x1d\x1f", pos);
+        if (end == std::string::npos) end = data.size();
+        std::string_view value(data.data() + pos, end - pos);
+        pos = end;
+        return value;
+    }
+
+private:
+    const std::string& data;
+    size_t pos = 0;
+};
+
+size_t decodeCompactPayload(const std::string& payload, std::initializer_list<std::vector<VarType>*> targets,
+                            SymbolTable* symbols, bool unresolvedSymbols) {
+    const unsigned char GS = 29;
+    const unsigned char US = 31;
+    static const char CODE = typeCodeByte("Code");
+    static const char NULL_TYPE = typeCodeByte("nullptr_t");
+    static const char INT = typeCodeByte("int");
+    static const char FLOAT = typeCodeByte("float");
+    static const char STRING = typeCodeByte("string");
+    static const char BOOL = typeCodeByte("bool");
+    static const char CUSTOM = typeCodeByte("custom");
+
+    CompactReader reader(payload);
+    size_t count = 0;
+    for (std::vector<VarType>* target : targets) {
+        if (reader.atEnd()) break;  // Só os vetores presentes são substituídos
+        target->clear();
+        ++count;
+
+        while (!reader.atEnd()) {
+            unsigned char separator = reader.byte();
+            if (separator == GS) break;
+            if (separator != US) {
+                throw std::runtime_error("Payload V2 malformado: separador de item esperado");
+            }
+
+            char type = static_cast<char>(reader.byte() & 0x07);
+            if (type == CODE || type == NULL_TYPE) {
+                reader.byte();
+                target->emplace_back(nullptr);
+            } else if (type == INT) {
+                target->emplace_back(static_cast<int>(zigzagDecode(reader.varint())));
+            } else if (type == FLOAT) {
+                target->emplace_back(reader.float32());
+            } else if (type == BOOL) {
+                target->emplace_back(reader.byte() == '1');
+            } else if (type == STRING) {
+                std::string_view value = reader.text();
+                if (symbols) {
+                    target->push_back(symbols->handle(symbols->intern(value)));
+                } else {
+                    target->emplace_back(value);
+                }
+            } else if (type == CUSTOM && symbols) {
+                target->push_back(symbols->handle(reader.varint()));
+            } else if (type == CUSTOM && unresolvedSymbols) {
+                reader.varint();
+                target->emplace_back(nullptr);
+            } else {
+                throw std::runtime_error("Tipo desconhecido no payload");
+            }
+        }
+    }
+    return count;
+}
+
+// Decodifica os vetores presentes no payload em targets, na ordem, e retorna quantos foram substituídos
+size_t decodePayloadVectors(const std::string& payload, std::initializer_list<std::vector<VarType>*> targets,
+                            const PayloadOptions& options) {
     const char GS = 29;
     const char US = 31;
+    SymbolTable* symbols = options.symbols;
+
+    if (options.codec == PayloadCodec::V2) {
+        return decodeCompactPayload(payload, targets, symbols, options.unresolvedSymbols);
+    }
 
     auto parseVector = [&](const std::string& segment) -> std::vector<VarType> {
         std::vector<VarType> result;
@@ -281,7 +643,22 @@ void Code::updateFromPayload(const std::string& payload) {
             } else if (typeName == "int") {
                 result.emplace_back(static_cast<int>(static_cast<unsigned char>(value[0])));
             } else if (typeName == "string") {
-                result.emplace_back(value); // Adiciona diretamente como string
+                if (symbols) {
+                    result.push_back(symbols->handle(symbols->intern(value)));
+                } else {
+                    result.emplace_back(value); // Adiciona diretamente como string
+                }
+            } else if (typeName == "custom" && (symbols || options.unresolvedSymbols)) {
+                uint32_t id = 0;
+                auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), id);
+                if (error != std::errc() || end != value.data() + value.size()) {
+                    throw std::runtime_error("Referência a símbolo inválida no payload");
+                }
+                if (symbols) {
+                    result.push_back(symbols->handle(id));
+                } else {
+                    result.emplace_back(nullptr);
+                }
             } else if (typeName == "bool") {
                 result.emplace_back(value == "1"); // Converte "1" para true, "0" para false
             } else if (typeName == "float") {
@@ -304,68 +681,52 @@ void Code::updateFromPayload(const std::string& payload) {
     }
 
     // Atualiza os campos com os segmentos decodificados
-    if (segments.size() > 0) Code::globals = parseVector(segments[0]);
-    if (segments.size() > 1) co_names = parseVector(segments[1]);
-    if (segments.size() > 2) co_varnames = parseVector(segments[2]);
-    if (segments.size() > 3) co_freevars = parseVector(segments[3]);
-    if (segments.size() > 4) co_cellvars = parseVector(segments[4]);
+    size_t count = std::min(segments.size(), targets.size());
+    auto target = targets.begin();
+    for (size_t i = 0; i < count; ++i, ++target) {
+        **target = parseVector(segments[i]);
+    }
+    return count;
+}
 }
 
+void decodeFramePayload(const std::string& payload, std::vector<VarType>& globals, std::vector<VarType>& names,
+                        std::vector<VarType>& varnames, std::vector<VarType>& freevars, std::vector<VarType>& cellvars,
+                        const PayloadOptions& options) {
+    decodePayloadVectors(payload, {&globals, &names, &varnames, &freevars, &cellvars}, options);
+}
 
-std::string Code::generateInputTestPayload() const {
-    const char GS = 29;  // ASCII Group Separator
-    const char US = 31;  // ASCII Unit Separator
-    const char NULL_CHAR = 0;  // ASCII NULL
+void decodeFramePayload(const std::string& payload, DecodedPayload& decoded, const PayloadOptions& options) {
+    std::vector<VarType>* vectors = decoded.vectors;
+    decoded.count = decodePayloadVectors(payload, {&vectors[0], &vectors[1], &vectors[2], &vectors[3], &vectors[4]},
+                                         options);
+}
 
-    // Função para converter uma string de 3 bits em um byte
-    auto bitsToByte = [](const std::string& bits) -> char {
-        return static_cast<char>(std::bitset<3>(bits).to_ulong());
-    };
 
-    std::ostringstream result;
+void writeInputTables(std::ostream& os, const std::vector<VarType>& globals, const FrameTables& frame,
+                      PayloadCodec codec) {
+    const char GS = 29;  // ASCII Group Separator
+    const char US = 31;  // ASCII Unit Separator
 
-    // Função lambda para formatar um vetor com códigos de tipo
-    auto formatVector = [&](const std::vector<VarType>& vec) -> std::string {
-        std::ostringstream oss;
+    // Cada campo com seus itens e códigos de tipo, com GS entre eles
+    auto writeVector = [&](std::span<const VarType> vec) {
         for (const auto& item : vec) {
-            oss << US;  // Inicia o item com um US
-            
-            std::visit([&oss, &bitsToByte, this](const auto& val) {
-                using T = std::decay_t<decltype(val)>;
-                if constexpr (std::is_same_v<T, Code>) {
-                    oss << bitsToByte(PayloadType::typeMap.at("Code"));  // Código para Code como byte binário
-                    oss << NULL_CHAR;
-                } else if constexpr (std::is_same_v<T, std::nullptr_t>) {
-                    oss << bitsToByte(PayloadType::typeMap.at("nullptr_t"));  // Código para nullptr como byte binário
-                    oss << NULL_CHAR;
-                } else if constexpr (std::is_integral_v<T>) {
-                    oss << bitsToByte(PayloadType::typeMap.at("int"));  // Código para int como byte binário
-                    writeBinaryInt32(oss, val);
-                } else if constexpr (std::is_floating_point_v<T>) {
-                    oss << bitsToByte(PayloadType::typeMap.at("float"));  // Código para float como byte binário
-                    oss << val;
-                } else if constexpr (std::is_same_v<T, std::string>) {
-                    oss << bitsToByte(PayloadType::typeMap.at("string"));  // Código para string como byte binário
-                    oss << val;
-                } else if constexpr (std::is_same_v<T, bool>) {
-                    oss << bitsToByte(PayloadType::typeMap.at("bool"));  // Código para bool como byte binário
-                    oss << (val ? "1" : "0");
-                } else {
-                    oss << bitsToByte(PayloadType::typeMap.at("unknown"));  // Código reservado como byte binário
-                    oss << "undefined";  // Placeholder para tipos não especificados
-                }
-            }, item);
+            os << US;  // Inicia o item com um US
+            writeTypedValue(os, item, codec);
         }
-        return oss.str();
+        os << GS;
     };
 
-    // Concatena cada campo formatado com GS entre eles
-    result << GS;
-    result << formatVector(Code::globals) << GS;
-    result << formatVector(co_names) << GS;
-    result << formatVector(co_varnames) << GS;
-    result << formatVector(co_freevars) << GS;
-    result << formatVector(co_cellvars) << GS;
+    os << GS;
+    writeVector(globals);
+    writeVector(frame.names);
+    writeVector(frame.varnames);
+    writeVector(frame.freevars);
+    writeVector(frame.cellvars);
+}
 
+std::string Code::generateInputTestPayload(const std::vector<VarType>& globals, PayloadCodec codec) const {
+    std::ostringstream result;
+    writeInputTables(result, globals, tables(), codec);
     return result.str();
 }
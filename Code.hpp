@@ -5,7 +5,11 @@
 #include <fstream>
 #include <string>
 #include <vector>
-#include <variant>
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <atomic>
+#include <span>
 #include <stack>
 #include <sstream>
 #include <bitset>
@@ -13,15 +17,53 @@
 #include <unordered_map>
 #include <stdexcept>
 
-// Declarações antecipadas
-class Code;
+#include "Value.hpp"
+#include "Symbols.hpp"
+
+// Tipos de dados personalizados: cada posição dos vetores ocupa 16 bytes (ver Value.hpp)
+using VarType = Value;
+
+// Revisões da codificação dos valores nos payloads:
+//   V1: int em 4 bytes (só o primeiro é lido na decodificação), float em texto e tamanhos
+//       de vetor em 4 bytes. É o padrão, compatível com os mestres existentes
+//   V2: int em varint zigzag, float IEEE-754 em 4 bytes little-endian, tamanhos e
+//       referências a símbolos em varint. Os itens são lidos em sequência, então bytes
+//       iguais a GS/US dentro de números não quebram o payload
+enum class PayloadCodec : uint8_t { V1 = 1, V2 = 2 };
+
+// Opções de codificação de uma sessão (ver Dispatcher::setCodec e enableSymbols)
+struct PayloadOptions {
+    SymbolTable* symbols = nullptr;
+    PayloadCodec codec = PayloadCodec::V1;
+
+    // Níveis de Codes aninhados embutidos no CONSTS de generatePayload (0: nenhum, o Code
+    // filho sai só como o código de tipo 100 seguido de NUL). Ver NestedCodeTag
+    unsigned inlineDepth = 0;
 
-// Tipos de dados personalizados
-using VarType = std::variant<Code, int, bool, std::string, std::nullptr_t, float>;
+    // Só na decodificação sem sessão (ver Validation.hpp): aceita referências a símbolos
+    // sem tabela, como valores nulos, já que os ids dependem das strings de registros anteriores
+    bool unresolvedSymbols = false;
+};
+
+// Byte que segue o código de tipo 100 de um Code em CONSTS:
+//   None:   filho não enviado (formato original); o mestre o pede em outra chamada
+//   Inline: [tamanho][GS co_code GS names GS varnames GS freevars GS cellvars GS CONSTS GS],
+//           com as tabelas iniciais do filho e cada vetor com seu tamanho, como em
+//           generatePayload. O tamanho permite ao mestre pular o corpo inteiro
+//   Ref:    [ordinal] de um Code já enviado na mesma resposta, contando os Codes na ordem
+//           em que aparecem e começando pelo frame da resposta (ordinal 0)
+enum class NestedCodeTag : uint8_t { None = 0, Inline = 1, Ref = 2 };
 
 // Funções auxiliares
 void writeBinaryInt32(std::ostream& os, uint32_t value);
+void writeVarint(std::ostream& os, uint32_t value);
+// Tamanhos e ids: 4 bytes na codificação V1 e varint na V2
+void writeSize(std::ostream& os, uint32_t value, PayloadCodec codec);
 void hexToBinaryStream(const std::string& hex, std::ostream& outStream);
+void writeTypedValue(std::ostream& os, const VarType& item, PayloadCodec codec = PayloadCodec::V1);
+
+// Byte com o código de 3 bits do tipo (ver PayloadType::typeMap)
+char typeCodeByte(const std::string& typeName);
 
 // Classe PayloadType para mapeamento de tipos e códigos
 class PayloadType {
@@ -30,21 +72,132 @@ public:
     static const std::unordered_map<std::string, std::string> codeMap;
 };
 
+class Code;
+class Bytecode;
+
+// Tabelas de variáveis reescritas pelo mestre a cada CALL_FUNCTION. Pertencem a uma
+// ativação (ver Frame.hpp); o Code só guarda os valores iniciais carregados do arquivo
+struct FrameTables {
+    std::span<const VarType> names;
+    std::span<const VarType> varnames;
+    std::span<const VarType> freevars;
+    std::span<const VarType> cellvars;
+};
+
+// Escreve as globais e as quatro tabelas do frame, cada vetor com seu tamanho e
+// terminado por GS, como no meio do payload de generatePayload. Com options.symbols,
+// strings já enviadas saem como referências (ver Symbols.hpp)
+void writeFrameTables(std::ostream& os, const std::vector<VarType>& globals, const FrameTables& frame,
+                      const PayloadOptions& options = {});
+
+// Payload de um CALL_FUNCTION do mestre: GS seguido das globais e das quatro tabelas,
+// cada vetor terminado por GS e sem tamanho (formato lido por decodeFramePayload)
+void writeInputTables(std::ostream& os, const std::vector<VarType>& globals, const FrameTables& frame,
+                      PayloadCodec codec = PayloadCodec::V1);
+
+// Decodifica o payload de um CALL_FUNCTION nas globais e nas quatro tabelas do frame.
+// Só os vetores presentes no payload são substituídos. Com options.symbols, as strings
+// recebidas são internadas e as referências a símbolos são aceitas
+void decodeFramePayload(const std::string& payload, std::vector<VarType>& globals, std::vector<VarType>& names,
+                        std::vector<VarType>& varnames, std::vector<VarType>& freevars, std::vector<VarType>& cellvars,
+                        const PayloadOptions& options = {});
+
+// Payload de um CALL_FUNCTION decodificado antes de chegar à sessão (ver Pipeline.hpp):
+// globais e as quatro tabelas, na ordem do payload; só as count primeiras vieram nele
+struct DecodedPayload {
+    std::vector<VarType> vectors[5];
+    size_t count = 0;
+};
+
+// Decodifica em vetores próprios, sem depender do estado do frame que vai recebê-los
+void decodeFramePayload(const std::string& payload, DecodedPayload& decoded, const PayloadOptions& options = {});
+
+// Aquecimento: materializa toda a árvore a partir de root e pré-codifica o payload de
+// cada Code em threadCount threads (0 usa uma por núcleo). Retorna a quantidade de Codes
+size_t precomputePayloads(Code& root, unsigned threadCount = 0, PayloadCodec codec = PayloadCodec::V1);
+
+// Constante de co_consts que Value não representa: inteiro fora de int32, tupla (com os
+// itens) ou um tipo que o leitor não converte. Em co_consts a posição fica com None
+struct ConstantLiteral {
+    enum class Kind : uint8_t { None, Bool, Int, Float, Str, Tuple, Unsupported };
+
+    Kind kind = Kind::None;
+    int64_t integer = 0;    // Int e Bool
+    double real = 0.0;      // Float
+    std::string text;       // Str; em Unsupported, a descrição da constante
+    std::vector<ConstantLiteral> items;  // Tuple
+
+    bool operator==(const ConstantLiteral&) const = default;
+};
+
+// Identificadores do código-fonte de um Code: nomes das variáveis de cada tabela e
+// quantidade de argumentos posicionais. O protocolo não os usa (as tabelas do Code só
+// guardam valores); servem a quem executa o bytecode, como o mestre emulado, assim como
+// as constantes que co_consts guarda como None
+struct CodeIdentifiers {
+    std::vector<std::string> names;
+    std::vector<std::string> varnames;
+    std::vector<std::string> freevars;
+    std::vector<std::string> cellvars;
+    int argcount = -1;  // -1: desconhecido (JSON sem co_argcount)
+    std::vector<std::pair<uint32_t, ConstantLiteral>> literals;  // índice em co_consts e valor
+
+    bool operator==(const CodeIdentifiers&) const = default;
+};
+
 // Declaração da classe Code
 class Code {
 public:
     // Campos
-    std::string co_code;
+    // Bytecode em hexadecimal, imutável e compartilhável: Codes com o mesmo co_code passam
+    // a apontar para o mesmo texto depois de deduplicateCodes (ver Dedup.hpp)
+    std::shared_ptr<const std::string> co_code;
     std::vector<VarType> co_names;
     std::vector<VarType> co_varnames;
     std::vector<VarType> co_freevars;
     std::vector<VarType> co_cellvars;
     std::vector<VarType> co_consts;
-    static std::vector<VarType> globals;
+
+    // Preenchido pelos leitores de JSON e de .pyc; nullptr em Codes montados à mão
+    std::shared_ptr<const CodeIdentifiers> identifiers;
+
+    // co_code pré-decodificado (ver Bytecode.hpp), compartilhado entre Codes com o mesmo
+    // texto. Preenchido por predecodeBytecode ou decodedBytecode e descartado por setCoCode.
+    // Lido e escrito sob cacheLock
+    std::shared_ptr<const Bytecode> bytecode;
+
+    // Objetos Code aninhados, referenciados por ponteiro em co_consts
+    std::vector<std::unique_ptr<Code>> children;
+
+    // Carga adiada (ver readCodeFromJsonLazy): enquanto load não tiver rodado, este Code é
+    // só um marcador e seus campos são preenchidos por materialize(). Sessões em threads
+    // diferentes podem pedir a mesma carga; ela roda uma vez, e as outras esperam por ela
+    struct PendingLoad {
+        std::function<void(Code&)> load;
+        std::once_flag once;
+        std::atomic<bool> done{false};
+    };
+    std::unique_ptr<PendingLoad> pendingLoad;  // nullptr: carregado desde a leitura
+
+    // Partes de generatePayload que só dependem de co_code e co_consts, já codificadas.
+    // Preenchidas por precomputePayload e descartadas por setCoCode/setCoConsts.
+    // encodedConsts só é usado por payloads na mesma revisão de codificação. Lidas e
+    // escritas sob cacheLock
+    std::string encodedCode;
+    std::string encodedConsts;
+    PayloadCodec precomputedCodec = PayloadCodec::V1;
+    bool payloadPrecomputed = false;
+
+    // Protege os caches preenchidos durante a execução (bytecode e os blocos acima):
+    // --prefetch e o emulador os preenchem sob demanda, e sessões em threads diferentes
+    // podem compartilhar o mesmo Code
+    std::unique_ptr<std::mutex> cacheLock = std::make_unique<std::mutex>();
 
     // Construtores
     explicit Code(const std::string& code = "");
 
+    const std::string& getCoCode() const { return *co_code; }
+
     // Métodos set
     void setCoCode(const std::string& code);
     void setCoNames(const std::vector<VarType>& names);
@@ -53,16 +206,44 @@ public:
     void setCoCellvars(const std::vector<VarType>& cellvars);
     void setCoConsts(const std::vector<VarType>& consts);
 
+    // Transfere um Code aninhado para este objeto e retorna o valor que o referencia
+    VarType addChild(Code&& child);
+
+    // Preenche os campos de um Code de carga adiada; não faz nada se já estiver carregado.
+    // Pode ser chamado de várias threads ao mesmo tempo
+    void materialize();
+    bool isMaterialized() const { return !pendingLoad || pendingLoad->done.load(std::memory_order_acquire); }
+
+    // As variáveis globais pertencem à sessão (ver Dispatcher) e são recebidas
+    // como parâmetro pelos métodos que as leem ou escrevem
+
+    // Tabelas iniciais deste Code, usadas quando não há uma ativação separada
+    FrameTables tables() const { return FrameTables{co_names, co_varnames, co_freevars, co_cellvars}; }
+
     // Métodos de impressão
-    void print() const;
+    void print(std::ostream& os, const std::vector<VarType>& globals) const;
+    void print(std::ostream& os, const std::vector<VarType>& globals, const FrameTables& frame) const;
 
     // Acessar objetos Code aninhados
-    Code& getCodeFromVariable(size_t vector, size_t index);
+    Code& getCodeFromVariable(const std::vector<VarType>& globals, size_t vector, size_t index);
+    Code& getCodeFromVariable(const std::vector<VarType>& globals, const FrameTables& frame, size_t vector, size_t index);
 
     // Geração de payloads
-    std::string generatePayload() const;
-    std::string generateInputTestPayload() const;
-    void updateFromPayload(const std::string& payload);
+    std::string generatePayload(const std::vector<VarType>& globals) const;
+    std::string generatePayload(const std::vector<VarType>& globals, const FrameTables& frame,
+                                const PayloadOptions& options = {}) const;
+    std::string generateInputTestPayload(const std::vector<VarType>& globals,
+                                         PayloadCodec codec = PayloadCodec::V1) const;
+
+    // Codifica antecipadamente co_code e co_consts; um CALL_FUNCTION passa a só intercalar
+    // as tabelas da ativação entre os dois blocos
+    void precomputePayload(PayloadCodec codec = PayloadCodec::V1);
+    bool hasPrecomputedPayload(PayloadCodec codec) const;
+
+    // Forma pré-decodificada do co_code, decodificada aqui se ainda não estiver em cache
+    const Bytecode& decodedBytecode();
+
+    void updateFromPayload(const std::string& payload, std::vector<VarType>& globals);
 };
 
 #endif
@@ -0,0 +1,71 @@
+#include <sstream>
+#include <stdexcept>
+#include "CodeTable.hpp"
+
+CodeTable::CodeTable(Code& root) {
+    std::vector<Code*> pending{&root};
+    while (!pending.empty()) {
+        Code* code = pending.back();
+        pending.pop_back();
+        code->materialize();
+
+        ids.emplace(code, static_cast<uint32_t>(codes.size()));
+        codes.push_back(code);
+
+        // Empilha em ordem inversa para que os filhos recebam ids na ordem de co_consts
+        for (auto it = code->children.rbegin(); it != code->children.rend(); ++it) {
+            pending.push_back(it->get());
+        }
+    }
+}
+
+Code& CodeTable::at(uint32_t id) const {
+    if (id >= codes.size()) {
+        throw std::out_of_range("Id de frame inexistente: " + std::to_string(id));
+    }
+    return *codes[id];
+}
+
+uint32_t CodeTable::idOf(const Code& code) const {
+    auto it = ids.find(&code);
+    if (it == ids.end()) {
+        throw std::runtime_error("Code fora da tabela de frames");
+    }
+    return it->second;
+}
+
+std::string CodeTable::encode(PayloadCodec codec) const {
+    const char GS = 29;  // ASCII Group Separator
+    const char US = 31;  // ASCII Unit Separator
+
+    std::ostringstream result;
+    writeSize(result, codes.size(), codec);
+    for (const Code* code : codes) {
+        writeSize(result, code->getCoCode().size() / 2, codec);
+        hexToBinaryStream(code->getCoCode(), result);
+
+        for (size_t i = 0; i < code->co_consts.size(); ++i) {
+            if (i > 0) result << US;
+            const VarType& item = code->co_consts[i];
+            if (item.isCode()) {
+                result << typeCodeByte("Code");
+                writeSize(result, idOf(*item.asCode()), codec);
+            } else {
+                writeTypedValue(result, item, codec);
+            }
+        }
+        result << GS;
+    }
+    return result.str();
+}
+
+std::string CodeTable::framePayload(const Code& code, const std::vector<VarType>& globals, const FrameTables& frame,
+                                    const PayloadOptions& options) const {
+    const char GS = 29;
+
+    std::ostringstream result;
+    writeSize(result, idOf(code), options.codec);
+    result << GS;
+    writeFrameTables(result, globals, frame, options);
+    return result.str();
+}
@@ -0,0 +1,44 @@
+#ifndef CODE_TABLE_H
+#define CODE_TABLE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include "Code.hpp"
+
+/*
+    * Modo de protocolo por id de frame: logo após o INIT o gerenciador envia uma única vez
+    * a tabela plana com o co_code e o co_consts de todos os Code do módulo. A partir daí a
+    * resposta a uma chamada leva só o id do frame e as tabelas de variáveis.
+    *
+    * Tabela:   [quantidade uint32] e, para cada Code na ordem dos ids,
+    *           [tamanho do co_code uint32][co_code][CONSTS][GS]
+    *           Em CONSTS, um Code aninhado é o código de tipo 100 seguido do seu id (uint32).
+    * Resposta: [id uint32][GS] globals GS names GS varnames GS freevars GS cellvars GS
+    *
+    * Na codificação V2 (ver PayloadCodec) quantidade, tamanhos e ids são varints.
+*/
+
+// Ids atribuídos em pré-ordem a partir da raiz (id 0). Toda a árvore é materializada
+class CodeTable {
+public:
+    explicit CodeTable(Code& root);
+
+    size_t size() const { return codes.size(); }
+    Code& at(uint32_t id) const;
+    uint32_t idOf(const Code& code) const;
+
+    // Tabela enviada ao mestre após o INIT
+    std::string encode(PayloadCodec codec = PayloadCodec::V1) const;
+
+    // Resposta compacta a uma chamada: id do frame mais as tabelas de variáveis
+    std::string framePayload(const Code& code, const std::vector<VarType>& globals, const FrameTables& frame,
+                             const PayloadOptions& options = {}) const;
+
+private:
+    std::vector<Code*> codes;
+    std::unordered_map<const Code*, uint32_t> ids;
+};
+
+#endif
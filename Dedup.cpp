@@ -0,0 +1,131 @@
+#include <string_view>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include "Dedup.hpp"
+
+namespace {
+void hashCombine(size_t& seed, size_t value) {
+    seed ^= value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+}
+
+size_t hashValue(const VarType& item) {
+    size_t seed = static_cast<size_t>(item.type());
+    switch (item.type()) {
+        case Value::Type::Null: break;
+        case Value::Type::Int: hashCombine(seed, std::hash<int>{}(item.asInt())); break;
+        case Value::Type::Float: hashCombine(seed, std::hash<float>{}(item.asFloat())); break;
+        case Value::Type::Bool: hashCombine(seed, item.asBool()); break;
+        case Value::Type::String: hashCombine(seed, std::hash<std::string_view>{}(item.asString())); break;
+        case Value::Type::Code: hashCombine(seed, std::hash<const Code*>{}(item.asCode())); break;
+    }
+    return seed;
+}
+
+void hashTable(size_t& seed, const std::vector<VarType>& table) {
+    hashCombine(seed, table.size());
+    for (const auto& item : table) {
+        hashCombine(seed, hashValue(item));
+    }
+}
+
+// co_code já internado: a identidade do ponteiro equivale à igualdade do texto
+size_t hashCode(const Code& code) {
+    size_t seed = std::hash<const std::string*>{}(code.co_code.get());
+    hashTable(seed, code.co_names);
+    hashTable(seed, code.co_varnames);
+    hashTable(seed, code.co_freevars);
+    hashTable(seed, code.co_cellvars);
+    hashTable(seed, code.co_consts);
+    return seed;
+}
+
+bool sameCode(const Code& a, const Code& b) {
+    return a.co_code == b.co_code &&
+           a.co_names == b.co_names &&
+           a.co_varnames == b.co_varnames &&
+           a.co_freevars == b.co_freevars &&
+           a.co_cellvars == b.co_cellvars &&
+           a.co_consts == b.co_consts &&
+           (a.identifiers == b.identifiers ||
+            (a.identifiers && b.identifiers && *a.identifiers == *b.identifiers));
+}
+
+// Espaço de um Code descartado, sem contar o co_code, que já foi contado ao ser internado
+size_t footprint(const Code& code) {
+    size_t entries = code.co_names.size() + code.co_varnames.size() + code.co_freevars.size() +
+                     code.co_cellvars.size() + code.co_consts.size();
+    return sizeof(Code) + entries * sizeof(VarType);
+}
+
+class Deduplicator {
+public:
+    DedupReport report;
+
+    // Pós-ordem: os filhos são trocados pelos seus representantes antes de o próprio Code
+    // ser comparado, então Codes com filhos iguais ficam com os mesmos ponteiros
+    Code* canonical(Code& code) {
+        code.materialize();
+        ++report.codes;
+        internBlob(code);
+
+        for (auto& item : code.co_consts) {
+            if (!item.isCode()) continue;
+            Code* child = item.asCode();
+            Code* representative = canonical(*child);
+            if (representative != child) {
+                item = VarType(representative);
+                releaseChild(code, child);
+            }
+        }
+
+        auto& bucket = codes[hashCode(code)];
+        for (Code* other : bucket) {
+            if (sameCode(*other, code)) {
+                report.bytesSaved += footprint(code);
+                return other;
+            }
+        }
+        bucket.push_back(&code);
+        ++report.uniqueCodes;
+        return &code;
+    }
+
+    void finish() { report.uniqueBlobs = blobs.size(); }
+
+private:
+    // A chave aponta para o texto guardado no próprio valor, que o mantém vivo
+    std::unordered_map<std::string_view, std::shared_ptr<const std::string>> blobs;
+    std::unordered_map<size_t, std::vector<Code*>> codes;
+
+    void internBlob(Code& code) {
+        auto [it, inserted] = blobs.try_emplace(std::string_view(*code.co_code), code.co_code);
+        if (!inserted && it->second != code.co_code) {
+            report.bytesSaved += code.co_code->size();
+            code.co_code = it->second;
+        }
+    }
+
+    // O duplicado não é mais referenciado: seus próprios filhos repetidos já foram
+    // liberados na pós-ordem, então nada dentro dele é usado por outro Code
+    void releaseChild(Code& parent, Code* child) {
+        auto it = std::find_if(parent.children.begin(), parent.children.end(),
+                               [child](const std::unique_ptr<Code>& owned) { return owned.get() == child; });
+        if (it != parent.children.end()) {
+            parent.children.erase(it);
+        }
+    }
+};
+}
+
+DedupReport deduplicateCodes(Code& root) {
+    Deduplicator deduplicator;
+    deduplicator.canonical(root);
+    deduplicator.finish();
+    return deduplicator.report;
+}
+
+void DedupReport::write(std::ostream& os) const {
+    os << "dedup: codes=" << codes << " unique=" << uniqueCodes
+       << " co_code blobs=" << uniqueBlobs << " bytes saved=" << bytesSaved << std::endl;
+}
@@ -0,0 +1,26 @@
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include <cstddef>
+#include <ostream>
+#include "Code.hpp"
+
+// Resultado de deduplicateCodes
+struct DedupReport {
+    size_t codes = 0;         // Codes encontrados na árvore
+    size_t uniqueCodes = 0;   // Codes que restaram após a deduplicação
+    size_t uniqueBlobs = 0;   // Textos de co_code distintos
+    size_t bytesSaved = 0;    // co_code repetidos mais o espaço dos Codes descartados (estimativa)
+
+    void write(std::ostream& os) const;
+};
+
+// Deduplicação por conteúdo feita logo após a carga. co_code idênticos passam a ser um
+// único texto compartilhado, e Codes idênticos (mesmo co_code, mesmas tabelas iniciais e
+// mesmas constantes, com os filhos já deduplicados) passam a ser um único objeto,
+// referenciado por todos os co_consts que continham uma cópia. Como o Code não é alterado
+// durante a execução (ver Frame.hpp), compartilhá-lo entre chamadores é seguro.
+// Materializa toda a árvore; deve rodar antes de montar uma CodeTable
+DedupReport deduplicateCodes(Code& root);
+
+#endif
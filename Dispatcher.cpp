@@ -0,0 +1,111 @@
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include "Dispatcher.hpp"
+
+const char* instructionName(uint8_t instruction) {
+    switch (instruction) {
+        case INSTR_INIT: return "INIT";
+        case INSTR_RETURN: return "RETURN";
+        case INSTR_CALL_FUNCTION: return "CALL_FUNCTION";
+        case INSTR_CALL_FRAME: return "CALL_FRAME";
+        default: return "UNKNOWN";
+    }
+}
+
+namespace {
+void updateTopFromSegment(FrameStack& frames, const std::vector<uint8_t>& segment, std::vector<VarType>& globals,
+                          DecodedPayload* decoded) {
+    if (decoded) {
+        frames.updateTop(*decoded, globals);
+    } else {
+        frames.updateTop(std::string(segment.begin() + 4, segment.end()), globals);
+    }
+}
+}
+
+Code& applyCallFunction(FrameStack& frames, const std::vector<uint8_t>& segment, std::vector<VarType>& globals,
+                        DecodedPayload* decoded) {
+    if (segment.size() < 4) {
+        throw std::runtime_error("Registro de CALL_FUNCTION truncado");
+    }
+    std::vector<uint8_t> args(segment.begin() + 1, segment.begin() + 3);
+
+    updateTopFromSegment(frames, segment, globals, decoded);
+    return frames.resolveCall(globals, args[0], args[1]);
+}
+
+Code& applyCallFrame(FrameStack& frames, const CodeTable* table, const std::vector<uint8_t>& segment, std::vector<VarType>& globals,
+                     DecodedPayload* decoded) {
+    if (!table) {
+        throw std::runtime_error("CALL_FRAME recebido fora do modo por id de frame");
+    }
+    if (segment.size() < 4) {
+        throw std::runtime_error("Registro de CALL_FRAME truncado");
+    }
+    uint32_t id = segment[1] | (static_cast<uint32_t>(segment[2]) << 8);
+    Code& callee = table->at(id);
+
+    updateTopFromSegment(frames, segment, globals, decoded);
+    return callee;
+}
+
+Dispatcher::Dispatcher(Code& root) : globals(root.co_names) {
+    frames.push(root);
+}
+
+uint8_t Dispatcher::dispatch(const std::vector<uint8_t>& segment, DecodedPayload* decoded) {
+    if (!metrics) {
+        return apply(segment, decoded);
+    }
+
+    // Apenas instruções aplicadas com sucesso entram no histograma
+    auto start = Metrics::Clock::now();
+    uint8_t instruction = apply(segment, decoded);
+    metrics->recordInstruction(instruction, Metrics::Clock::now() - start);
+    metrics->recordDecoded(segment.size());
+    if (instruction == INSTR_CALL_FUNCTION) {
+        metrics->recordCallCache(frames.lastCallHit());
+    }
+    if (prefetcher && (instruction == INSTR_CALL_FUNCTION || instruction == INSTR_CALL_FRAME)) {
+        metrics->recordPrefetch(prefetcher->lastCallHit());
+    }
+    return instruction;
+}
+
+uint8_t Dispatcher::apply(const std::vector<uint8_t>& segment, DecodedPayload* decoded) {
+    if (segment.empty()) {
+        throw std::runtime_error("Registro vazio");
+    }
+
+    uint8_t instruction = segment[0];
+
+    if (instruction == INSTR_CALL_FUNCTION || instruction == INSTR_CALL_FRAME) {
+        Code& callee = instruction == INSTR_CALL_FUNCTION
+            ? applyCallFunction(frames, segment, globals, decoded)
+            : applyCallFrame(frames, codeTable, segment, globals, decoded);
+        frames.push(callee);
+        if (prefetcher) prefetcher->call(callee);
+    } else if (instruction == INSTR_RETURN) {
+        frames.pop();
+        if (frames.empty()) {
+            throw std::runtime_error("Navigation stack is empty.");
+        }
+    } else if (instruction == INSTR_INIT) {
+        // Nada a fazer: o primeiro frame já está no topo da pilha
+    } else {
+        throw std::runtime_error("Instrução desconhecida");
+    }
+
+    return instruction;
+}
+
+void Dispatcher::restore(SavedSession& saved) {
+    if (frames.empty()) {
+        throw std::runtime_error("Navigation stack is empty.");
+    }
+    restoreSession(saved, frames, globals, symbols.get(), [this](Code& code) {
+        frames.push(code);
+        if (prefetcher) prefetcher->call(code);
+    });
+}
@@ -0,0 +1,135 @@
+#ifndef DISPATCHER_H
+#define DISPATCHER_H
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <stdexcept>
+#include "Code.hpp"
+#include "Frame.hpp"
+#include "CodeTable.hpp"
+#include "Prefetch.hpp"
+#include "Metrics.hpp"
+#include "Checkpoint.hpp"
+
+/*
+    * Instruções enviadas pelo mestre
+    * INITIALIZE: 0x02
+    * RETURN_VALUE: 0x53
+    * CALL_FUNCTION: 0x83
+    * CALL_FRAME: 0x84 (apenas no modo por id de frame)
+*/
+const uint8_t INSTR_INIT = 0x02;
+const uint8_t INSTR_RETURN = 0x53;
+const uint8_t INSTR_CALL_FUNCTION = 0x83;
+
+// Modo por id de frame (ver CodeTable.hpp): chamada que nomeia o frame diretamente,
+// [0x84][id 16 bits little-endian][GS][payload], sem resolver pelas tabelas do chamador
+const uint8_t INSTR_CALL_FRAME = 0x84;
+
+// Nome legível da instrução, usado em logs e métricas
+const char* instructionName(uint8_t instruction);
+
+// Aplica o payload de um CALL_FUNCTION à ativação do topo e retorna o Code chamado,
+// que ainda precisa ser empilhado pelo chamador. Com decoded, o payload do registro já
+// foi decodificado (ver Pipeline.hpp) e não é lido de novo
+Code& applyCallFunction(FrameStack& frames, const std::vector<uint8_t>& segment, std::vector<VarType>& globals,
+                        DecodedPayload* decoded = nullptr);
+
+// Aplica o payload de um CALL_FRAME à ativação do topo e retorna o Code de id pedido
+Code& applyCallFrame(FrameStack& frames, const CodeTable* table, const std::vector<uint8_t>& segment, std::vector<VarType>& globals,
+                     DecodedPayload* decoded = nullptr);
+
+// Aplica os registros do mestre (instrução + argumentos + payload) sobre a pilha de frames.
+// Cada Dispatcher é uma sessão independente: a pilha e as variáveis globais pertencem a ele,
+// e nada é escrito no console ou em arquivos
+class Dispatcher {
+private:
+    std::unique_ptr<SessionSymbols> symbols;
+    PayloadCodec codec = PayloadCodec::V1;
+    unsigned inlineDepth = 0;
+    FrameStack frames;
+    std::vector<VarType> globals;
+    Metrics* metrics = nullptr;
+    const CodeTable* codeTable = nullptr;
+    Prefetcher* prefetcher = nullptr;
+
+    uint8_t apply(const std::vector<uint8_t>& segment, DecodedPayload* decoded);
+
+    PayloadOptions incomingOptions() const {
+        return PayloadOptions{symbols ? &symbols->incoming : nullptr, codec};
+    }
+
+public:
+    // As variáveis globais da sessão começam com os nomes do módulo (co_names do frame raiz)
+    explicit Dispatcher(Code& root);
+
+    // Processa um registro já separado por splitByDelimiters e retorna a instrução aplicada.
+    // decoded: payload do registro já decodificado com decodeOptions() (ver Pipeline.hpp)
+    uint8_t dispatch(const std::vector<uint8_t>& segment, DecodedPayload* decoded = nullptr);
+
+    // Ativa a coleta de métricas por instrução (nullptr desativa)
+    void setMetrics(Metrics* m) { metrics = m; }
+
+    // Liga o modo por id de frame: aceita CALL_FRAME e responde só com id e tabelas
+    void setCodeTable(const CodeTable* table) { codeTable = table; }
+
+    // Liga o modo de símbolos (ver Symbols.hpp) nas duas direções da sessão
+    void enableSymbols() {
+        symbols = std::make_unique<SessionSymbols>();
+        frames.setPayloadOptions(incomingOptions());
+    }
+
+    // Opções com que os payloads recebidos são decodificados. Quem decodifica fora da
+    // sessão usa a tabela de símbolos de entrada dela, e passa a ser seu único usuário
+    PayloadOptions decodeOptions() const { return incomingOptions(); }
+
+    // Revisão da codificação dos payloads, nas duas direções da sessão
+    void setCodec(PayloadCodec value) {
+        codec = value;
+        frames.setPayloadOptions(incomingOptions());
+    }
+
+    // Liga a pré-busca dos possíveis filhos de cada frame empilhado (nullptr desativa)
+    void setPrefetcher(Prefetcher* p) {
+        prefetcher = p;
+        if (prefetcher) prefetcher->enter(frames.topCode());
+    }
+
+    // Embute até depth níveis de Codes aninhados nas respostas (ver NestedCodeTag)
+    void setInlineDepth(unsigned depth) { inlineDepth = depth; }
+
+    // Frame no topo da pilha de execução e as tabelas da sua ativação
+    Code* current() { return &frames.topCode(); }
+    FrameTables currentTables() const { return frames.topTables(); }
+
+    // Acesso mutável às globais: invalida o cache de chamadas, que não vê alterações externas
+    std::vector<VarType>& getGlobals() {
+        frames.invalidateGlobals();
+        return globals;
+    }
+
+    const CallCacheStats& callCacheStats() const { return frames.callCacheStats(); }
+
+    // Payload do frame corrente, enviado ao mestre em resposta a um CALL_FUNCTION. Não é
+    // const: com --symbols, as strings enviadas entram na tabela de saída e os payloads
+    // seguintes só as referenciam, então cada payload gerado deve ir para o mestre
+    std::string currentPayload() {
+        PayloadOptions outgoing{symbols ? &symbols->outgoing : nullptr, codec, inlineDepth};
+        if (codeTable) {
+            return codeTable->framePayload(frames.topCode(), globals, frames.topTables(), outgoing);
+        }
+        return frames.topCode().generatePayload(globals, frames.topTables(), outgoing);
+    }
+
+    // Verdadeiro quando a pilha foi esvaziada e nada mais pode ser processado
+    bool finished() { return frames.empty(); }
+
+    // Estado lido pelos checkpoints (ver Checkpoint.hpp)
+    SessionState state() const { return SessionState{frames, globals, symbols.get()}; }
+
+    // Retoma a sessão de um checkpoint; só antes do primeiro registro
+    void restore(SavedSession& saved);
+};
+
+#endif
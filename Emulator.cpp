@@ -0,0 +1,1849 @@
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <optional>
+#include "Emulator.hpp"
+#include "Bytecode.hpp"
+
+// Despacho por threaded code: cada instrução pré-decodificada guarda o endereço do seu
+// tratador (extensão "labels as values" do GCC/Clang). Nos demais compiladores, switch
+#if defined(__GNUC__)
+#define EMULATOR_COMPUTED_GOTO 1
+#else
+#define EMULATOR_COMPUTED_GOTO 0
+#endif
+
+namespace {
+
+// Opcodes tratados pelo interpretador, com os valores de Bytecode.hpp
+#define EMULATOR_OPCODES(X) \
+    X(POP_TOP) X(ROT_TWO) X(ROT_THREE) X(DUP_TOP) X(NOP) X(UNARY_NEGATIVE) X(UNARY_NOT) \
+    X(BINARY_POWER) X(BINARY_MULTIPLY) X(BINARY_MODULO) X(BINARY_ADD) X(BINARY_SUBTRACT) X(BINARY_SUBSCR) \
+    X(BINARY_FLOOR_DIVIDE) X(BINARY_TRUE_DIVIDE) X(INPLACE_FLOOR_DIVIDE) X(INPLACE_TRUE_DIVIDE) \
+    X(INPLACE_ADD) X(INPLACE_SUBTRACT) X(INPLACE_MULTIPLY) X(INPLACE_MODULO) X(STORE_SUBSCR) \
+    X(INPLACE_POWER) X(GET_ITER) X(LOAD_BUILD_CLASS) X(RETURN_VALUE) X(STORE_NAME) X(UNPACK_SEQUENCE) X(FOR_ITER) \
+    X(STORE_ATTR) X(STORE_GLOBAL) X(LOAD_CONST) \
+    X(LOAD_NAME) X(BUILD_TUPLE) X(BUILD_LIST) X(LOAD_ATTR) X(COMPARE_OP) X(JUMP_FORWARD) \
+    X(JUMP_IF_FALSE_OR_POP) X(JUMP_IF_TRUE_OR_POP) X(JUMP_ABSOLUTE) X(POP_JUMP_IF_FALSE) X(POP_JUMP_IF_TRUE) \
+    X(LOAD_GLOBAL) X(IS_OP) X(CONTAINS_OP) X(LOAD_FAST) X(STORE_FAST) X(CALL_FUNCTION) X(MAKE_FUNCTION) \
+    X(LOAD_CLOSURE) X(LOAD_DEREF) X(STORE_DEREF) X(CALL_FUNCTION_KW) X(EXTENDED_ARG) X(LIST_APPEND) \
+    X(FORMAT_VALUE) X(BUILD_STRING) X(LOAD_METHOD) X(CALL_METHOD) X(LIST_EXTEND) \
+    X(LOAD_FAST__LOAD_FAST) X(LOAD_FAST__LOAD_CONST) X(STORE_FAST__LOAD_FAST) X(LOAD_CONST__RETURN_VALUE) \
+    X(COMPARE_OP__POP_JUMP_IF_FALSE)
+
+// Bytes dos registros enviados ao gerenciador (ver Dispatcher.hpp)
+const uint8_t RECORD_INIT = 0x02;
+const uint8_t RECORD_RETURN = 0x53;
+const uint8_t RECORD_CALL_FUNCTION = 0x83;
+const uint8_t RECORD_CALL_FRAME = 0x84;
+
+// Exceção do programa emulado (NameError, TypeError, ...): encerra a execução
+class PythonError : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+[[noreturn]] void raise(const std::string& type, const std::string& message) {
+    throw PythonError(type + ": " + message);
+}
+
+enum class ObjectKind : uint8_t {
+    Str, Tuple, List, Range, Iterator, Cell, Function, Builtin, Class, Instance, BoundMethod, ClassMethod
+};
+
+struct Object {
+    explicit Object(ObjectKind kind) : kind(kind) {}
+    virtual ~Object() = default;
+    const ObjectKind kind;
+};
+
+// Valor do programa emulado: imediatos no próprio objeto e o resto no heap
+struct PyObj {
+    enum class Kind : uint8_t { Unbound, None, Bool, Int, Float, Code, Object };
+
+    Kind kind = Kind::Unbound;
+    union {
+        bool boolean;
+        int64_t integer;
+        double real;
+        Code* code;
+    };
+    std::shared_ptr<Object> object;
+
+    PyObj() : integer(0) {}
+
+    static PyObj none() { PyObj v; v.kind = Kind::None; return v; }
+    static PyObj fromBool(bool b) { PyObj v; v.kind = Kind::Bool; v.boolean = b; return v; }
+    static PyObj fromInt(int64_t i) { PyObj v; v.kind = Kind::Int; v.integer = i; return v; }
+    static PyObj fromFloat(double d) { PyObj v; v.kind = Kind::Float; v.real = d; return v; }
+    static PyObj fromCode(Code* c) { PyObj v; v.kind = Kind::Code; v.code = c; return v; }
+    static PyObj fromObject(std::shared_ptr<Object> o) {
+        PyObj v;
+        v.kind = Kind::Object;
+        v.object = std::move(o);
+        return v;
+    }
+
+    bool is(ObjectKind k) const { return kind == Kind::Object && object->kind == k; }
+    bool isIntegral() const { return kind == Kind::Int || kind == Kind::Bool; }
+    bool isNumber() const { return isIntegral() || kind == Kind::Float; }
+    int64_t asInteger() const { return kind == Kind::Bool ? static_cast<int64_t>(boolean) : integer; }
+    double asReal() const { return kind == Kind::Float ? real : static_cast<double>(asInteger()); }
+};
+
+using Namespace = std::unordered_map<std::string, PyObj>;
+
+struct StrObject : Object {
+    explicit StrObject(std::string text) : Object(ObjectKind::Str), text(std::move(text)) {}
+    std::string text;
+};
+
+struct TupleObject : Object {
+    TupleObject() : Object(ObjectKind::Tuple) {}
+    std::vector<PyObj> items;
+};
+
+struct ListObject : Object {
+    ListObject() : Object(ObjectKind::List) {}
+    std::vector<PyObj> items;
+};
+
+struct RangeObject : Object {
+    RangeObject(int64_t start, int64_t stop, int64_t step)
+        : Object(ObjectKind::Range), start(start), stop(stop), step(step) {}
+    int64_t start;
+    int64_t stop;
+    int64_t step;  // nunca zero
+
+    uint64_t length() const {
+        // Em uint64_t a distância entre start e stop não transborda
+        if (step > 0 && start < stop) {
+            return (static_cast<uint64_t>(stop) - static_cast<uint64_t>(start) - 1) / static_cast<uint64_t>(step) + 1;
+        }
+        if (step < 0 && start > stop) {
+            return (static_cast<uint64_t>(start) - static_cast<uint64_t>(stop) - 1) / (0 - static_cast<uint64_t>(step)) + 1;
+        }
+        return 0;
+    }
+    int64_t at(uint64_t index) const {
+        return static_cast<int64_t>(static_cast<uint64_t>(start) + index * static_cast<uint64_t>(step));
+    }
+};
+
+// Iterador de GET_ITER sobre uma tupla, lista, range ou string (position em bytes na string)
+struct IteratorObject : Object {
+    explicit IteratorObject(PyObj sequence) : Object(ObjectKind::Iterator), sequence(std::move(sequence)) {}
+    PyObj sequence;
+    uint64_t position = 0;
+};
+
+struct CellObject : Object {
+    CellObject() : Object(ObjectKind::Cell) {}
+    PyObj value;
+};
+
+struct FunctionObject : Object {
+    FunctionObject() : Object(ObjectKind::Function) {}
+    Code* code = nullptr;
+    std::string name;
+    std::vector<std::shared_ptr<CellObject>> closure;
+    std::vector<PyObj> defaults;
+};
+
+struct ClassObject : Object {
+    explicit ClassObject(std::string name) : Object(ObjectKind::Class), name(std::move(name)) {}
+    std::string name;
+    Namespace attrs;
+};
+
+struct InstanceObject : Object {
+    explicit InstanceObject(std::shared_ptr<ClassObject> cls) : Object(ObjectKind::Instance), cls(std::move(cls)) {}
+    std::shared_ptr<ClassObject> cls;
+    Namespace attrs;
+};
+
+struct BoundMethodObject : Object {
+    BoundMethodObject(PyObj self, std::shared_ptr<FunctionObject> function)
+        : Object(ObjectKind::BoundMethod), self(std::move(self)), function(std::move(function)) {}
+    PyObj self;
+    std::shared_ptr<FunctionObject> function;
+};
+
+struct ClassMethodObject : Object {
+    explicit ClassMethodObject(std::shared_ptr<FunctionObject> function)
+        : Object(ObjectKind::ClassMethod), function(std::move(function)) {}
+    std::shared_ptr<FunctionObject> function;
+};
+
+class Interpreter;
+using Keywords = std::vector<std::pair<std::string, PyObj>>;
+using BuiltinFn = PyObj (*)(Interpreter&, std::vector<PyObj>&);
+// Builtin que aceita argumentos nomeados, como print(end=...)
+using BuiltinKeywordsFn = PyObj (*)(Interpreter&, std::vector<PyObj>&, Keywords&);
+
+struct BuiltinObject : Object {
+    BuiltinObject(const char* name, BuiltinFn fn) : Object(ObjectKind::Builtin), name(name), fn(fn) {}
+    BuiltinObject(const char* name, BuiltinKeywordsFn fn) : Object(ObjectKind::Builtin), name(name), keywordsFn(fn) {}
+    const char* name;
+    BuiltinFn fn = nullptr;
+    BuiltinKeywordsFn keywordsFn = nullptr;
+};
+
+template <typename T>
+T& as(const PyObj& v) {
+    return static_cast<T&>(*v.object);
+}
+
+PyObj makeStr(std::string text) {
+    return PyObj::fromObject(std::make_shared<StrObject>(std::move(text)));
+}
+
+std::string typeName(const PyObj& v) {
+    switch (v.kind) {
+        case PyObj::Kind::Unbound:
+        case PyObj::Kind::None: return "NoneType";
+        case PyObj::Kind::Bool: return "bool";
+        case PyObj::Kind::Int: return "int";
+        case PyObj::Kind::Float: return "float";
+        case PyObj::Kind::Code: return "code";
+        case PyObj::Kind::Object: break;
+    }
+    switch (v.object->kind) {
+        case ObjectKind::Str: return "str";
+        case ObjectKind::Tuple: return "tuple";
+        case ObjectKind::List: return "list";
+        case ObjectKind::Range: return "range";
+        case ObjectKind::Iterator: return typeName(as<IteratorObject>(v).sequence) + "_iterator";
+        case ObjectKind::Cell: return "cell";
+        case ObjectKind::Function: return "function";
+        case ObjectKind::Builtin: return "builtin_function_or_method";
+        case ObjectKind::Class: return "type";
+        case ObjectKind::Instance: return as<InstanceObject>(v).cls->name;
+        case ObjectKind::BoundMethod: return "method";
+        case ObjectKind::ClassMethod: return "classmethod";
+    }
+    return "object";
+}
+
+// repr() de float como no Python: a menor representação que volta ao mesmo valor
+std::string formatFloat(double x) {
+    if (std::isnan(x)) return "nan";
+    if (std::isinf(x)) return x > 0 ? "inf" : "-inf";
+    char buffer[32];
+    auto [end, error] = std::to_chars(buffer, buffer + sizeof(buffer), x);
+    std::string text(buffer, end);
+    if (text.find_first_of(".e") == std::string::npos) {
+        text += ".0";
+    }
+    return text;
+}
+
+std::string repr(const PyObj& v);
+
+std::string toStr(const PyObj& v) {
+    switch (v.kind) {
+        case PyObj::Kind::Unbound:
+        case PyObj::Kind::None: return "None";
+        case PyObj::Kind::Bool: return v.boolean ? "True" : "False";
+        case PyObj::Kind::Int: return std::to_string(v.integer);
+        case PyObj::Kind::Float: return formatFloat(v.real);
+        case PyObj::Kind::Code: return "<code object>";
+        case PyObj::Kind::Object: break;
+    }
+    switch (v.object->kind) {
+        case ObjectKind::Str: return as<StrObject>(v).text;
+        case ObjectKind::Tuple: {
+            const auto& items = as<TupleObject>(v).items;
+            std::string text = "(";
+            for (size_t i = 0; i < items.size(); ++i) {
+                if (i > 0) text += ", ";
+                text += repr(items[i]);
+            }
+            return text + (items.size() == 1 ? ",)" : ")");
+        }
+        case ObjectKind::List: {
+            const auto& items = as<ListObject>(v).items;
+            std::string text = "[";
+            for (size_t i = 0; i < items.size(); ++i) {
+                if (i > 0) text += ", ";
+                text += items[i].object == v.object ? "[...]" : repr(items[i]);
+            }
+            return text + "]";
+        }
+        case ObjectKind::Range: {
+            const auto& range = as<RangeObject>(v);
+            std::string text = "range(" + std::to_string(range.start) + ", " + std::to_string(range.stop);
+            return text + (range.step == 1 ? ")" : ", " + std::to_string(range.step) + ")");
+        }
+        case ObjectKind::Function: return "<function " + as<FunctionObject>(v).name + ">";
+        case ObjectKind::Builtin: return std::string("<built-in function ") + as<BuiltinObject>(v).name + ">";
+        case ObjectKind::Class: return "<class '__main__." + as<ClassObject>(v).name + "'>";
+        case ObjectKind::Instance: return "<__main__." + as<InstanceObject>(v).cls->name + " object>";
+        case ObjectKind::BoundMethod: return "<bound method " + as<BoundMethodObject>(v).function->name + ">";
+        default: return "<" + typeName(v) + " object>";
+    }
+}
+
+std::string repr(const PyObj& v) {
+    if (v.is(ObjectKind::Str)) {
+        return "'" + as<StrObject>(v).text + "'";
+    }
+    return toStr(v);
+}
+
+bool truthy(const PyObj& v) {
+    switch (v.kind) {
+        case PyObj::Kind::Unbound:
+        case PyObj::Kind::None: return false;
+        case PyObj::Kind::Bool: return v.boolean;
+        case PyObj::Kind::Int: return v.integer != 0;
+        case PyObj::Kind::Float: return v.real != 0.0;
+        case PyObj::Kind::Code: return true;
+        case PyObj::Kind::Object: break;
+    }
+    if (v.is(ObjectKind::Str)) return !as<StrObject>(v).text.empty();
+    if (v.is(ObjectKind::Tuple)) return !as<TupleObject>(v).items.empty();
+    if (v.is(ObjectKind::List)) return !as<ListObject>(v).items.empty();
+    if (v.is(ObjectKind::Range)) return as<RangeObject>(v).length() != 0;
+    return true;
+}
+
+enum class ArithOp { Add, Sub, Mul, TrueDiv, FloorDiv, Mod, Pow };
+
+const char* arithSymbol(ArithOp op) {
+    switch (op) {
+        case ArithOp::Add: return "+";
+        case ArithOp::Sub: return "-";
+        case ArithOp::Mul: return "*";
+        case ArithOp::TrueDiv: return "/";
+        case ArithOp::FloorDiv: return "//";
+        case ArithOp::Mod: return "%";
+        case ArithOp::Pow: return "** or pow()";
+    }
+    return "?";
+}
+
+[[noreturn]] void overflow() {
+    raise("OverflowError", "resultado inteiro fora de 64 bits");
+}
+
+PyObj integerArith(ArithOp op, int64_t a, int64_t b) {
+    int64_t result = 0;
+    switch (op) {
+        case ArithOp::Add:
+            if (__builtin_add_overflow(a, b, &result)) overflow();
+            return PyObj::fromInt(result);
+        case ArithOp::Sub:
+            if (__builtin_sub_overflow(a, b, &result)) overflow();
+            return PyObj::fromInt(result);
+        case ArithOp::Mul:
+            if (__builtin_mul_overflow(a, b, &result)) overflow();
+            return PyObj::fromInt(result);
+        case ArithOp::TrueDiv:
+            if (b == 0) raise("ZeroDivisionError", "division by zero");
+            return PyObj::fromFloat(static_cast<double>(a) / static_cast<double>(b));
+        case ArithOp::FloorDiv:
+        case ArithOp::Mod: {
+            if (b == 0) raise("ZeroDivisionError", "integer division or modulo by zero");
+            if (a == std::numeric_limits<int64_t>::min() && b == -1) {
+                if (op == ArithOp::Mod) return PyObj::fromInt(0);
+                overflow();
+            }
+            // Divisão arredondada para baixo e resto com o sinal do divisor
+            int64_t quotient = a / b;
+            int64_t remainder = a % b;
+            if (remainder != 0 && ((remainder < 0) != (b < 0))) {
+                --quotient;
+                remainder += b;
+            }
+            return PyObj::fromInt(op == ArithOp::FloorDiv ? quotient : remainder);
+        }
+        case ArithOp::Pow: {
+            if (b < 0) return PyObj::fromFloat(std::pow(static_cast<double>(a), static_cast<double>(b)));
+            int64_t base = a;
+            result = 1;
+            for (int64_t exponent = b; exponent > 0; exponent >>= 1) {
+                if ((exponent & 1) && __builtin_mul_overflow(result, base, &result)) overflow();
+                if (exponent > 1 && __builtin_mul_overflow(base, base, &base)) overflow();
+            }
+            return PyObj::fromInt(result);
+        }
+    }
+    return PyObj::none();
+}
+
+PyObj realArith(ArithOp op, double a, double b) {
+    switch (op) {
+        case ArithOp::Add: return PyObj::fromFloat(a + b);
+        case ArithOp::Sub: return PyObj::fromFloat(a - b);
+        case ArithOp::Mul: return PyObj::fromFloat(a * b);
+        case ArithOp::TrueDiv:
+            if (b == 0.0) raise("ZeroDivisionError", "float division by zero");
+            return PyObj::fromFloat(a / b);
+        case ArithOp::FloorDiv:
+            if (b == 0.0) raise("ZeroDivisionError", "float floor division by zero");
+            return PyObj::fromFloat(std::floor(a / b));
+        case ArithOp::Mod: {
+            if (b == 0.0) raise("ZeroDivisionError", "float modulo");
+            double remainder = std::fmod(a, b);
+            if (remainder != 0.0 && ((remainder < 0) != (b < 0))) remainder += b;
+            return PyObj::fromFloat(remainder);
+        }
+        case ArithOp::Pow: return PyObj::fromFloat(std::pow(a, b));
+    }
+    return PyObj::none();
+}
+
+PyObj repeatStr(const std::string& text, int64_t count) {
+    std::string result;
+    for (int64_t i = 0; i < count; ++i) result += text;
+    return makeStr(std::move(result));
+}
+
+PyObj arith(ArithOp op, const PyObj& a, const PyObj& b) {
+    if (a.isIntegral() && b.isIntegral()) {
+        return integerArith(op, a.asInteger(), b.asInteger());
+    }
+    if (a.isNumber() && b.isNumber()) {
+        return realArith(op, a.asReal(), b.asReal());
+    }
+    if (op == ArithOp::Add && a.is(ObjectKind::Str) && b.is(ObjectKind::Str)) {
+        return makeStr(as<StrObject>(a).text + as<StrObject>(b).text);
+    }
+    if (op == ArithOp::Add && a.is(ObjectKind::Tuple) && b.is(ObjectKind::Tuple)) {
+        auto tuple = std::make_shared<TupleObject>();
+        tuple->items = as<TupleObject>(a).items;
+        const auto& tail = as<TupleObject>(b).items;
+        tuple->items.insert(tuple->items.end(), tail.begin(), tail.end());
+        return PyObj::fromObject(std::move(tuple));
+    }
+    if (op == ArithOp::Mul && a.is(ObjectKind::Str) && b.isIntegral()) {
+        return repeatStr(as<StrObject>(a).text, b.asInteger());
+    }
+    if (op == ArithOp::Mul && a.isIntegral() && b.is(ObjectKind::Str)) {
+        return repeatStr(as<StrObject>(b).text, a.asInteger());
+    }
+    raise("TypeError", std::string("unsupported operand type(s) for ") + arithSymbol(op) + ": '" + typeName(a) +
+                           "' and '" + typeName(b) + "'");
+}
+
+bool equals(const PyObj& a, const PyObj& b) {
+    if (a.isNumber() && b.isNumber()) {
+        if (a.isIntegral() && b.isIntegral()) return a.asInteger() == b.asInteger();
+        return a.asReal() == b.asReal();
+    }
+    if (a.kind != b.kind) {
+        return false;
+    }
+    switch (a.kind) {
+        case PyObj::Kind::Unbound:
+        case PyObj::Kind::None: return true;
+        case PyObj::Kind::Code: return a.code == b.code;
+        default: break;
+    }
+    if (a.is(ObjectKind::Str) && b.is(ObjectKind::Str)) {
+        return as<StrObject>(a).text == as<StrObject>(b).text;
+    }
+    if (a.is(ObjectKind::Tuple) && b.is(ObjectKind::Tuple)) {
+        const auto& left = as<TupleObject>(a).items;
+        const auto& right = as<TupleObject>(b).items;
+        return std::equal(left.begin(), left.end(), right.begin(), right.end(), equals);
+    }
+    if (a.is(ObjectKind::List) && b.is(ObjectKind::List)) {
+        const auto& left = as<ListObject>(a).items;
+        const auto& right = as<ListObject>(b).items;
+        return a.object == b.object || std::equal(left.begin(), left.end(), right.begin(), right.end(), equals);
+    }
+    if (a.is(ObjectKind::Range) && b.is(ObjectKind::Range)) {
+        // Como sequências: mesmo tamanho, mesmo primeiro item e, com dois ou mais, mesmo passo
+        const auto& left = as<RangeObject>(a);
+        const auto& right = as<RangeObject>(b);
+        uint64_t length = left.length();
+        return length == right.length() &&
+               (length == 0 || (left.start == right.start && (length == 1 || left.step == right.step)));
+    }
+    return a.object == b.object;
+}
+
+bool identical(const PyObj& a, const PyObj& b) {
+    if (a.kind != b.kind) return false;
+    switch (a.kind) {
+        case PyObj::Kind::Object: return a.object == b.object;
+        case PyObj::Kind::Float: return a.real == b.real;
+        case PyObj::Kind::Code: return a.code == b.code;
+        default: return a.asInteger() == b.asInteger();
+    }
+}
+
+// Comparações de COMPARE_OP: <, <=, ==, !=, >, >=
+bool compare(uint32_t op, const PyObj& a, const PyObj& b) {
+    static const char* const symbols[] = {"<", "<=", "==", "!=", ">", ">="};
+    if (op == 2) return equals(a, b);
+    if (op == 3) return !equals(a, b);
+    if (op > 5) raise("SystemError", "COMPARE_OP inválido: " + std::to_string(op));
+
+    int order;
+    if (a.isIntegral() && b.isIntegral()) {
+        order = (a.asInteger() > b.asInteger()) - (a.asInteger() < b.asInteger());
+    } else if (a.isNumber() && b.isNumber()) {
+        if (std::isnan(a.asReal()) || std::isnan(b.asReal())) return false;
+        order = (a.asReal() > b.asReal()) - (a.asReal() < b.asReal());
+    } else if (a.is(ObjectKind::Str) && b.is(ObjectKind::Str)) {
+        order = as<StrObject>(a).text.compare(as<StrObject>(b).text);
+    } else {
+        raise("TypeError", std::string("'") + symbols[op] + "' not supported between instances of '" + typeName(a) +
+                               "' and '" + typeName(b) + "'");
+    }
+    switch (op) {
+        case 0: return order < 0;
+        case 1: return order <= 0;
+        case 4: return order > 0;
+        default: return order >= 0;
+    }
+}
+
+PyObj getAttr(const PyObj& owner, const std::string& name) {
+    if (owner.is(ObjectKind::Instance)) {
+        auto& instance = as<InstanceObject>(owner);
+        if (auto it = instance.attrs.find(name); it != instance.attrs.end()) {
+            return it->second;
+        }
+        if (auto it = instance.cls->attrs.find(name); it != instance.cls->attrs.end()) {
+            const PyObj& value = it->second;
+            if (value.is(ObjectKind::Function)) {
+                return PyObj::fromObject(std::make_shared<BoundMethodObject>(
+                    owner, std::static_pointer_cast<FunctionObject>(value.object)));
+            }
+            if (value.is(ObjectKind::ClassMethod)) {
+                return PyObj::fromObject(std::make_shared<BoundMethodObject>(
+                    PyObj::fromObject(instance.cls), as<ClassMethodObject>(value).function));
+            }
+            return value;
+        }
+    } else if (owner.is(ObjectKind::Class)) {
+        auto& cls = as<ClassObject>(owner);
+        if (auto it = cls.attrs.find(name); it != cls.attrs.end()) {
+            if (it->second.is(ObjectKind::ClassMethod)) {
+                return PyObj::fromObject(
+                    std::make_shared<BoundMethodObject>(owner, as<ClassMethodObject>(it->second).function));
+            }
+            return it->second;
+        }
+        if (name == "__name__") {
+            return makeStr(cls.name);
+        }
+    }
+    raise("AttributeError", "'" + typeName(owner) + "' object has no attribute '" + name + "'");
+}
+
+void setAttr(const PyObj& owner, const std::string& name, PyObj value) {
+    if (owner.is(ObjectKind::Instance)) {
+        as<InstanceObject>(owner).attrs[name] = std::move(value);
+    } else if (owner.is(ObjectKind::Class)) {
+        as<ClassObject>(owner).attrs[name] = std::move(value);
+    } else {
+        raise("AttributeError", "'" + typeName(owner) + "' object has no attribute '" + name + "'");
+    }
+}
+
+// Fim do caractere UTF-8 que começa em pos
+size_t utf8Next(const std::string& text, size_t pos) {
+    ++pos;
+    while (pos < text.size() && (static_cast<unsigned char>(text[pos]) & 0xC0) == 0x80) ++pos;
+    return pos;
+}
+
+PyObj makeIterator(const PyObj& iterable) {
+    if (iterable.is(ObjectKind::Iterator)) {
+        return iterable;
+    }
+    if (iterable.is(ObjectKind::Tuple) || iterable.is(ObjectKind::List) || iterable.is(ObjectKind::Range) ||
+        iterable.is(ObjectKind::Str)) {
+        return PyObj::fromObject(std::make_shared<IteratorObject>(iterable));
+    }
+    raise("TypeError", "'" + typeName(iterable) + "' object is not iterable");
+}
+
+// Próximo item de FOR_ITER; false quando o iterador se esgotou
+bool nextItem(IteratorObject& iterator, PyObj& item) {
+    const PyObj& sequence = iterator.sequence;
+    switch (sequence.object->kind) {
+        case ObjectKind::Tuple:
+        case ObjectKind::List: {
+            const auto& items = sequence.is(ObjectKind::Tuple) ? as<TupleObject>(sequence).items
+                                                                : as<ListObject>(sequence).items;
+            if (iterator.position >= items.size()) return false;
+            item = items[iterator.position++];
+            return true;
+        }
+        case ObjectKind::Range: {
+            const auto& range = as<RangeObject>(sequence);
+            if (iterator.position >= range.length()) return false;
+            item = PyObj::fromInt(range.at(iterator.position++));
+            return true;
+        }
+        case ObjectKind::Str: {
+            const std::string& text = as<StrObject>(sequence).text;
+            if (iterator.position >= text.size()) return false;
+            size_t end = utf8Next(text, iterator.position);
+            item = makeStr(text.substr(iterator.position, end - iterator.position));
+            iterator.position = end;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Itens de um iterável, para UNPACK_SEQUENCE, LIST_EXTEND, list(), tuple(), max() e min()
+std::vector<PyObj> itemsOf(const PyObj& iterable) {
+    if (iterable.is(ObjectKind::Tuple)) return as<TupleObject>(iterable).items;
+    if (iterable.is(ObjectKind::List)) return as<ListObject>(iterable).items;
+    PyObj iterator = makeIterator(iterable);
+    std::vector<PyObj> items;
+    for (PyObj item; nextItem(as<IteratorObject>(iterator), item);) {
+        items.push_back(std::move(item));
+    }
+    return items;
+}
+
+// Posição de um índice de subscrição, negativo contando do fim
+uint64_t sequenceIndex(const PyObj& container, const PyObj& index, uint64_t size) {
+    if (!index.isIntegral()) {
+        raise("TypeError", typeName(container) + " indices must be integers, not " + typeName(index));
+    }
+    int64_t i = index.asInteger();
+    uint64_t position = i < 0 ? size - (0 - static_cast<uint64_t>(i)) : static_cast<uint64_t>(i);
+    if ((i < 0 && 0 - static_cast<uint64_t>(i) > size) || position >= size) {
+        raise("IndexError", typeName(container) + " index out of range");
+    }
+    return position;
+}
+
+PyObj subscript(const PyObj& container, const PyObj& index) {
+    if (container.is(ObjectKind::Tuple)) {
+        const auto& items = as<TupleObject>(container).items;
+        return items[sequenceIndex(container, index, items.size())];
+    }
+    if (container.is(ObjectKind::List)) {
+        const auto& items = as<ListObject>(container).items;
+        return items[sequenceIndex(container, index, items.size())];
+    }
+    if (container.is(ObjectKind::Range)) {
+        const auto& range = as<RangeObject>(container);
+        return PyObj::fromInt(range.at(sequenceIndex(container, index, range.length())));
+    }
+    if (container.is(ObjectKind::Str)) {
+        const std::string& text = as<StrObject>(container).text;
+        std::vector<size_t> starts;
+        for (size_t pos = 0; pos < text.size(); pos = utf8Next(text, pos)) starts.push_back(pos);
+        uint64_t position = sequenceIndex(container, index, starts.size());
+        size_t begin = starts[position];
+        return makeStr(text.substr(begin, utf8Next(text, begin) - begin));
+    }
+    raise("TypeError", "'" + typeName(container) + "' object is not subscriptable");
+}
+
+void storeSubscript(const PyObj& container, const PyObj& index, PyObj value) {
+    if (!container.is(ObjectKind::List)) {
+        raise("TypeError", "'" + typeName(container) + "' object does not support item assignment");
+    }
+    auto& items = as<ListObject>(container).items;
+    items[sequenceIndex(container, index, items.size())] = std::move(value);
+}
+
+// Operador in de CONTAINS_OP
+bool contains(const PyObj& container, const PyObj& item) {
+    if (container.is(ObjectKind::Str)) {
+        if (!item.is(ObjectKind::Str)) {
+            raise("TypeError", "'in <string>' requires string as left operand, not " + typeName(item));
+        }
+        return as<StrObject>(container).text.find(as<StrObject>(item).text) != std::string::npos;
+    }
+    if (container.is(ObjectKind::Range)) {
+        const auto& range = as<RangeObject>(container);
+        if (!item.isIntegral()) return false;
+        int64_t value = item.asInteger();
+        if (range.step > 0 ? (value < range.start || value >= range.stop) : (value > range.start || value <= range.stop)) {
+            return false;
+        }
+        uint64_t distance = range.step > 0 ? static_cast<uint64_t>(value) - static_cast<uint64_t>(range.start)
+                                           : static_cast<uint64_t>(range.start) - static_cast<uint64_t>(value);
+        uint64_t step = range.step > 0 ? static_cast<uint64_t>(range.step) : 0 - static_cast<uint64_t>(range.step);
+        return distance % step == 0;
+    }
+    if (container.is(ObjectKind::Tuple) || container.is(ObjectKind::List)) {
+        const auto& items = container.is(ObjectKind::Tuple) ? as<TupleObject>(container).items
+                                                            : as<ListObject>(container).items;
+        return std::any_of(items.begin(), items.end(), [&](const PyObj& element) { return equals(element, item); });
+    }
+    raise("TypeError", "argument of type '" + typeName(container) + "' is not iterable");
+}
+
+// max/min: vários argumentos ou um único iterável
+PyObj extreme(std::vector<PyObj>& args, const char* name, bool wantMax) {
+    const std::vector<PyObj>* items = &args;
+    std::vector<PyObj> iterated;
+    if (args.size() == 1) {
+        iterated = itemsOf(args[0]);
+        items = &iterated;
+    }
+    if (items->empty()) {
+        raise("ValueError", std::string(name) + "() arg is an empty sequence");
+    }
+    const PyObj* best = &(*items)[0];
+    for (const PyObj& item : *items) {
+        if (compare(wantMax ? 4 : 0, item, *best)) best = &item;
+    }
+    return *best;
+}
+
+void expectArgs(const std::vector<PyObj>& args, size_t count, const char* name) {
+    if (args.size() != count) {
+        raise("TypeError", std::string(name) + "() takes exactly " + std::to_string(count) + " argument(s) (" +
+                               std::to_string(args.size()) + " given)");
+    }
+}
+
+size_t utf8Length(const std::string& text) {
+    return static_cast<size_t>(std::count_if(text.begin(), text.end(),
+                                             [](char c) { return (static_cast<unsigned char>(c) & 0xC0) != 0x80; }));
+}
+
+// Constante que co_consts guarda como None (ver CodeIdentifiers::literals)
+PyObj fromLiteral(const ConstantLiteral& literal) {
+    switch (literal.kind) {
+        case ConstantLiteral::Kind::None: return PyObj::none();
+        case ConstantLiteral::Kind::Bool: return PyObj::fromBool(literal.integer != 0);
+        case ConstantLiteral::Kind::Int: return PyObj::fromInt(literal.integer);
+        case ConstantLiteral::Kind::Float: return PyObj::fromFloat(literal.real);
+        case ConstantLiteral::Kind::Str: return makeStr(literal.text);
+        case ConstantLiteral::Kind::Tuple: {
+            auto tuple = std::make_shared<TupleObject>();
+            for (const ConstantLiteral& item : literal.items) {
+                tuple->items.push_back(fromLiteral(item));
+            }
+            return PyObj::fromObject(std::move(tuple));
+        }
+        case ConstantLiteral::Kind::Unsupported: break;
+    }
+    raise("SystemError", "constante não suportada pelo emulador: " + literal.text);
+}
+
+class Interpreter {
+public:
+    Interpreter(Code& root, const RecordSink& sink, const EmulatorOptions& options, EmulatorReport& report);
+    ~Interpreter();
+
+    void runModule();
+    // Com keywords, os últimos keywords->size() argumentos são os valores dos nomeados
+    PyObj call(const PyObj& callable, std::vector<PyObj>& args, const std::vector<PyObj>* keywords = nullptr);
+    PyObj buildClass(std::vector<PyObj>& args);
+    PyObj makeList(std::vector<PyObj> items) {
+        auto list = track<ListObject>();
+        list->items = std::move(items);
+        return PyObj::fromObject(std::move(list));
+    }
+    void write(const std::string& text) {
+        if (options.output) *options.output << text;
+    }
+
+private:
+    // Instrução de Bytecode com o endereço do seu tratador
+    struct Instr {
+        const void* label = nullptr;
+        uint32_t arg = 0;
+        uint8_t opcode = 0;
+    };
+
+    struct Program {
+        bool threaded = false;
+        std::vector<Instr> code;  // termina com uma sentinela de opcode 0
+        std::vector<PyObj> consts;
+        std::vector<std::string> names;
+        std::vector<std::string> varnames;
+        int argcount = -1;  // -1: desconhecido; os argumentos ocupam as primeiras varnames
+        std::vector<std::string> cellNames;  // cellvars seguidos de freevars
+        size_t cellCount = 0;
+        std::vector<int> cellArgs;  // para cada cellvar, o argumento homônimo ou -1
+        // Índice em co_consts de cada Code filho: é o valor que o gerenciador resolve
+        std::unordered_map<const Code*, uint32_t> children;
+    };
+
+    struct Frame {
+        Code* code;
+        Program* program;
+        std::vector<PyObj> fast;
+        std::vector<std::shared_ptr<CellObject>> cells;
+        Namespace* locals;  // módulo e corpos de classe; nullptr nas funções
+        bool mirrored;      // se o gerenciador tem este frame na sua pilha
+    };
+
+    Program& programOf(Code& code);
+    PyObj runFrame(Frame& frame);
+
+    // Cria uma célula, classe ou instância e a registra para a limpeza final
+    template <typename T, typename... Args>
+    std::shared_ptr<T> track(Args&&... args);
+
+    PyObj callFunction(const std::shared_ptr<FunctionObject>& function, std::vector<PyObj>& args, Namespace* locals,
+                       const std::vector<PyObj>* keywords = nullptr);
+    PyObj binary(ArithOp op, const PyObj& a, const PyObj& b);
+    PyObj lookupGlobal(const std::string& name) const;
+
+    VarType encode(const Program& program, const PyObj& value) const;
+    bool emitCall(Frame& caller, const FunctionObject& function);
+    void emit();
+
+    Code& root;
+    const RecordSink& sink;
+    const EmulatorOptions& options;
+    EmulatorReport& report;
+
+    std::unordered_map<const Code*, std::unique_ptr<Program>> programs;
+    Program* rootProgram = nullptr;
+    Namespace globals;
+    Namespace builtins;
+    std::vector<Frame*> frames;
+
+    // Objetos que guardam referências (células, classes e instâncias). Ciclos entre eles,
+    // como a célula de uma função recursiva que aponta para a própria função, nunca
+    // zerariam os contadores dos shared_ptr; no fim da execução o conteúdo dos que ainda
+    // estiverem vivos é descartado, o que desfaz os ciclos
+    std::vector<std::weak_ptr<Object>> containers;
+    size_t containersLimit = 1024;
+
+    // Reaproveitados entre as chamadas
+    std::vector<VarType> tables[5];
+    std::vector<uint8_t> record;
+    std::ostringstream payload;
+};
+
+PyObj builtinPrint(Interpreter& interpreter, std::vector<PyObj>& args, Keywords& keywords) {
+    std::string sep = " ";
+    std::string end = "\n";
+    for (const auto& [name, value] : keywords) {
+        if (name != "sep" && name != "end") {
+            raise("TypeError", "'" + name + "' is an invalid keyword argument for print()");
+        }
+        if (value.kind == PyObj::Kind::None) continue;
+        if (!value.is(ObjectKind::Str)) {
+            raise("TypeError", name + " must be None or a string, not " + typeName(value));
+        }
+        (name == "sep" ? sep : end) = as<StrObject>(value).text;
+    }
+    std::string text;
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (i > 0) text += sep;
+        text += toStr(args[i]);
+    }
+    interpreter.write(text + end);
+    return PyObj::none();
+}
+
+PyObj builtinMax(Interpreter&, std::vector<PyObj>& args) { return extreme(args, "max", true); }
+PyObj builtinMin(Interpreter&, std::vector<PyObj>& args) { return extreme(args, "min", false); }
+
+PyObj builtinAbs(Interpreter&, std::vector<PyObj>& args) {
+    expectArgs(args, 1, "abs");
+    const PyObj& v = args[0];
+    if (v.isIntegral()) {
+        int64_t i = v.asInteger();
+        if (i == std::numeric_limits<int64_t>::min()) overflow();
+        return PyObj::fromInt(i < 0 ? -i : i);
+    }
+    if (v.kind == PyObj::Kind::Float) return PyObj::fromFloat(std::fabs(v.real));
+    raise("TypeError", "bad operand type for abs(): '" + typeName(v) + "'");
+}
+
+PyObj builtinLen(Interpreter&, std::vector<PyObj>& args) {
+    expectArgs(args, 1, "len");
+    if (args[0].is(ObjectKind::Str)) return PyObj::fromInt(static_cast<int64_t>(utf8Length(as<StrObject>(args[0]).text)));
+    if (args[0].is(ObjectKind::Tuple)) return PyObj::fromInt(static_cast<int64_t>(as<TupleObject>(args[0]).items.size()));
+    if (args[0].is(ObjectKind::List)) return PyObj::fromInt(static_cast<int64_t>(as<ListObject>(args[0]).items.size()));
+    if (args[0].is(ObjectKind::Range)) {
+        uint64_t length = as<RangeObject>(args[0]).length();
+        if (length > static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) overflow();
+        return PyObj::fromInt(static_cast<int64_t>(length));
+    }
+    raise("TypeError", "object of type '" + typeName(args[0]) + "' has no len()");
+}
+
+PyObj builtinStr(Interpreter&, std::vector<PyObj>& args) {
+    return makeStr(args.empty() ? std::string() : toStr(args[0]));
+}
+
+PyObj builtinRepr(Interpreter&, std::vector<PyObj>& args) {
+    expectArgs(args, 1, "repr");
+    return makeStr(repr(args[0]));
+}
+
+PyObj builtinInt(Interpreter&, std::vector<PyObj>& args) {
+    if (args.empty()) return PyObj::fromInt(0);
+    const PyObj& v = args[0];
+    if (v.isIntegral()) return PyObj::fromInt(v.asInteger());
+    if (v.kind == PyObj::Kind::Float) {
+        if (!std::isfinite(v.real) || std::fabs(v.real) >= 9.2e18) overflow();
+        return PyObj::fromInt(static_cast<int64_t>(v.real));
+    }
+    if (v.is(ObjectKind::Str)) {
+        const std::string& text = as<StrObject>(v).text;
+        size_t first = text.find_first_not_of(" \t\n");
+        size_t last = text.find_last_not_of(" \t\n");
+        int64_t value = 0;
+        if (first != std::string::npos) {
+            const char* begin = text.data() + first + (text[first] == '+' ? 1 : 0);
+            const char* end = text.data() + last + 1;
+            auto [ptr, error] = std::from_chars(begin, end, value);
+            if (error == std::errc() && ptr == end) return PyObj::fromInt(value);
+        }
+        raise("ValueError", "invalid literal for int() with base 10: " + repr(v));
+    }
+    raise("TypeError", "int() argument must be a string or a number, not '" + typeName(v) + "'");
+}
+
+PyObj builtinFloat(Interpreter&, std::vector<PyObj>& args) {
+    if (args.empty()) return PyObj::fromFloat(0.0);
+    const PyObj& v = args[0];
+    if (v.isNumber()) return PyObj::fromFloat(v.asReal());
+    if (v.is(ObjectKind::Str)) {
+        const std::string& text = as<StrObject>(v).text;
+        char* parsed = nullptr;
+        double value = std::strtod(text.c_str(), &parsed);
+        const char* end = parsed;
+        auto isSpace = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
+        if (end != text.c_str() && std::all_of(end, text.c_str() + text.size(), isSpace)) {
+            return PyObj::fromFloat(value);
+        }
+        raise("ValueError", "could not convert string to float: " + repr(v));
+    }
+    raise("TypeError", "float() argument must be a string or a number, not '" + typeName(v) + "'");
+}
+
+PyObj builtinBool(Interpreter&, std::vector<PyObj>& args) {
+    return PyObj::fromBool(!args.empty() && truthy(args[0]));
+}
+
+PyObj builtinRange(Interpreter&, std::vector<PyObj>& args) {
+    if (args.empty() || args.size() > 3) {
+        raise("TypeError", "range expected at most 3 arguments, got " + std::to_string(args.size()));
+    }
+    int64_t bounds[3] = {0, 0, 1};
+    for (size_t i = 0; i < args.size(); ++i) {
+        if (!args[i].isIntegral()) {
+            raise("TypeError", "'" + typeName(args[i]) + "' object cannot be interpreted as an integer");
+        }
+        bounds[args.size() == 1 ? 1 : i] = args[i].asInteger();
+    }
+    if (bounds[2] == 0) {
+        raise("ValueError", "range() arg 3 must not be zero");
+    }
+    return PyObj::fromObject(std::make_shared<RangeObject>(bounds[0], bounds[1], bounds[2]));
+}
+
+PyObj builtinList(Interpreter& interpreter, std::vector<PyObj>& args) {
+    if (args.size() > 1) expectArgs(args, 1, "list");
+    return interpreter.makeList(args.empty() ? std::vector<PyObj>() : itemsOf(args[0]));
+}
+
+PyObj builtinTuple(Interpreter&, std::vector<PyObj>& args) {
+    if (args.size() > 1) expectArgs(args, 1, "tuple");
+    if (!args.empty() && args[0].is(ObjectKind::Tuple)) return args[0];
+    auto tuple = std::make_shared<TupleObject>();
+    if (!args.empty()) tuple->items = itemsOf(args[0]);
+    return PyObj::fromObject(std::move(tuple));
+}
+
+PyObj builtinClassmethod(Interpreter&, std::vector<PyObj>& args) {
+    expectArgs(args, 1, "classmethod");
+    if (!args[0].is(ObjectKind::Function)) {
+        raise("TypeError", "classmethod espera uma função");
+    }
+    return PyObj::fromObject(std::make_shared<ClassMethodObject>(std::static_pointer_cast<FunctionObject>(args[0].object)));
+}
+
+PyObj builtinBuildClass(Interpreter& interpreter, std::vector<PyObj>& args) {
+    return interpreter.buildClass(args);
+}
+
+Interpreter::Interpreter(Code& root, const RecordSink& sink, const EmulatorOptions& options, EmulatorReport& report)
+    : root(root), sink(sink), options(options), report(report) {
+    const std::pair<const char*, BuiltinFn> table[] = {
+        {"max", builtinMax}, {"min", builtinMin}, {"abs", builtinAbs}, {"len", builtinLen},
+        {"str", builtinStr}, {"repr", builtinRepr}, {"int", builtinInt}, {"float", builtinFloat},
+        {"bool", builtinBool}, {"range", builtinRange}, {"list", builtinList}, {"tuple", builtinTuple},
+        {"classmethod", builtinClassmethod}, {"__build_class__", builtinBuildClass},
+    };
+    for (const auto& [name, fn] : table) {
+        builtins[name] = PyObj::fromObject(std::make_shared<BuiltinObject>(name, fn));
+    }
+    builtins["print"] = PyObj::fromObject(std::make_shared<BuiltinObject>("print", builtinPrint));
+    globals["__name__"] = makeStr("__main__");
+}
+
+Interpreter::~Interpreter() {
+    for (const auto& weak : containers) {
+        std::shared_ptr<Object> object = weak.lock();
+        if (!object) continue;
+        switch (object->kind) {
+            case ObjectKind::Cell: static_cast<CellObject&>(*object).value = PyObj(); break;
+            case ObjectKind::List: static_cast<ListObject&>(*object).items.clear(); break;
+            case ObjectKind::Class: static_cast<ClassObject&>(*object).attrs.clear(); break;
+            case ObjectKind::Instance: {
+                auto& instance = static_cast<InstanceObject&>(*object);
+                instance.attrs.clear();
+                instance.cls.reset();
+                break;
+            }
+            default: break;
+        }
+    }
+}
+
+template <typename T, typename... Args>
+std::shared_ptr<T> Interpreter::track(Args&&... args) {
+    auto object = std::make_shared<T>(std::forward<Args>(args)...);
+    if (containers.size() >= containersLimit) {
+        // Compacta os registros de objetos já destruídos antes de crescer
+        std::erase_if(containers, [](const std::weak_ptr<Object>& weak) { return weak.expired(); });
+        containersLimit = std::max<size_t>(1024, 2 * containers.size());
+    }
+    containers.push_back(object);
+    return object;
+}
+
+Interpreter::Program& Interpreter::programOf(Code& code) {
+    auto found = programs.find(&code);
+    if (found != programs.end()) {
+        return *found->second;
+    }
+
+    code.materialize();
+    if (!code.identifiers) {
+        raise("SystemError", "Code sem identificadores: carregue o módulo de um JSON ou .pyc");
+    }
+    const CodeIdentifiers& identifiers = *code.identifiers;
+    auto program = std::make_unique<Program>();
+    program->names = identifiers.names;
+    program->varnames = identifiers.varnames;
+    program->argcount = identifiers.argcount;
+    if (program->argcount > static_cast<int>(program->varnames.size())) {
+        raise("SystemError", "co_argcount maior que co_varnames");
+    }
+    program->cellNames = identifiers.cellvars;
+    program->cellCount = program->cellNames.size();
+    program->cellNames.insert(program->cellNames.end(), identifiers.freevars.begin(), identifiers.freevars.end());
+    for (size_t i = 0; i < program->cellCount; ++i) {
+        auto it = std::find(program->varnames.begin(), program->varnames.end(), program->cellNames[i]);
+        program->cellArgs.push_back(it == program->varnames.end() ? -1 : static_cast<int>(it - program->varnames.begin()));
+    }
+
+    for (size_t i = 0; i < code.co_consts.size(); ++i) {
+        const VarType& value = code.co_consts[i];
+        switch (value.type()) {
+            case Value::Type::Null: program->consts.push_back(PyObj::none()); break;
+            case Value::Type::Int: program->consts.push_back(PyObj::fromInt(value.asInt())); break;
+            case Value::Type::Float: program->consts.push_back(PyObj::fromFloat(value.asFloat())); break;
+            case Value::Type::Bool: program->consts.push_back(PyObj::fromBool(value.asBool())); break;
+            case Value::Type::String: program->consts.push_back(makeStr(std::string(value.asString()))); break;
+            case Value::Type::Code:
+                program->consts.push_back(PyObj::fromCode(value.asCode()));
+                program->children.emplace(value.asCode(), static_cast<uint32_t>(i));
+                break;
+        }
+    }
+    for (const auto& [index, literal] : identifiers.literals) {
+        if (index < program->consts.size()) program->consts[index] = fromLiteral(literal);
+    }
+
+    // Sem superinstruções, o co_code é decodificado só para este Program, sem tocar no cache
+    std::optional<Bytecode> plain;
+    const Bytecode& bytecode =
+        options.superinstructions ? code.decodedBytecode() : plain.emplace(code.getCoCode(), false);
+    std::span<const Instruction> instructions = bytecode.instructions();
+    size_t count = instructions.size();
+    program->code.resize(count + 1);  // + sentinela
+    for (size_t i = 0; i < count; ++i) {
+        Instr& instr = program->code[i];
+        instr.opcode = instructions[i].opcode;
+        instr.arg = instructions[i].arg;
+
+        // Argumentos validados aqui para que o laço principal indexe sem verificar
+        size_t limit = std::numeric_limits<size_t>::max();
+        switch (instr.opcode) {
+            case OP_LOAD_CONST: case OP_LOAD_CONST__RETURN_VALUE: limit = program->consts.size(); break;
+            case OP_STORE_NAME: case OP_STORE_ATTR: case OP_STORE_GLOBAL: case OP_LOAD_NAME:
+            case OP_LOAD_ATTR: case OP_LOAD_GLOBAL: case OP_LOAD_METHOD:
+                limit = program->names.size();
+                break;
+            case OP_LOAD_FAST: case OP_STORE_FAST: case OP_LOAD_FAST__LOAD_FAST: case OP_LOAD_FAST__LOAD_CONST:
+            case OP_STORE_FAST__LOAD_FAST:
+                limit = program->varnames.size();
+                break;
+            case OP_LOAD_CLOSURE: case OP_LOAD_DEREF: case OP_STORE_DEREF: limit = program->cellNames.size(); break;
+            default:
+                // Saltos já absolutos; o destino count é a sentinela
+                if (isJumpOpcode(instr.opcode)) limit = count + 1;
+                break;
+        }
+        if (instr.arg >= limit) {
+            raise("SystemError", "argumento inválido " + std::to_string(instr.arg) + " para o opcode " +
+                                     std::to_string(instr.opcode) + " no co_code");
+        }
+    }
+
+    Program& result = *program;
+    programs.emplace(&code, std::move(program));
+    return result;
+}
+
+PyObj Interpreter::lookupGlobal(const std::string& name) const {
+    if (auto it = globals.find(name); it != globals.end()) return it->second;
+    if (auto it = builtins.find(name); it != builtins.end()) return it->second;
+    raise("NameError", "name '" + name + "' is not defined");
+}
+
+void Interpreter::runModule() {
+    rootProgram = &programOf(root);
+    record.assign(1, RECORD_INIT);
+    emit();
+
+    Frame frame{&root, rootProgram, {}, {}, &globals, true};
+    frame.fast.resize(rootProgram->varnames.size());
+    for (size_t i = 0; i < rootProgram->cellNames.size(); ++i) {
+        frame.cells.push_back(track<CellObject>());
+    }
+    runFrame(frame);
+}
+
+PyObj Interpreter::call(const PyObj& callable, std::vector<PyObj>& args, const std::vector<PyObj>* keywords) {
+    if (callable.kind == PyObj::Kind::Object) {
+        switch (callable.object->kind) {
+            case ObjectKind::Function:
+                return callFunction(std::static_pointer_cast<FunctionObject>(callable.object), args, nullptr, keywords);
+            case ObjectKind::BoundMethod: {
+                auto& method = as<BoundMethodObject>(callable);
+                args.insert(args.begin(), method.self);
+                return callFunction(method.function, args, nullptr, keywords);
+            }
+            case ObjectKind::Builtin: {
+                auto& builtin = as<BuiltinObject>(callable);
+                size_t keywordCount = keywords ? keywords->size() : 0;
+                if (!builtin.keywordsFn) {
+                    if (keywordCount > 0) {
+                        raise("TypeError", std::string(builtin.name) + "() takes no keyword arguments");
+                    }
+                    return builtin.fn(*this, args);
+                }
+                Keywords named;
+                for (size_t i = 0; i < keywordCount; ++i) {
+                    named.emplace_back(as<StrObject>((*keywords)[i]).text, std::move(args[args.size() - keywordCount + i]));
+                }
+                args.resize(args.size() - keywordCount);
+                return builtin.keywordsFn(*this, args, named);
+            }
+            case ObjectKind::Class: {
+                auto cls = std::static_pointer_cast<ClassObject>(callable.object);
+                PyObj instance = PyObj::fromObject(track<InstanceObject>(cls));
+                auto init = cls->attrs.find("__init__");
+                if (init != cls->attrs.end() && init->second.is(ObjectKind::Function)) {
+                    args.insert(args.begin(), instance);
+                    PyObj result = callFunction(std::static_pointer_cast<FunctionObject>(init->second.object), args,
+                                                nullptr, keywords);
+                    if (result.kind != PyObj::Kind::None) {
+                        raise("TypeError", "__init__() should return None, not '" + typeName(result) + "'");
+                    }
+                } else if (!args.empty()) {
+                    raise("TypeError", cls->name + "() takes no arguments");
+                }
+                return instance;
+            }
+            default:
+                break;
+        }
+    }
+    raise("TypeError", "'" + typeName(callable) + "' object is not callable");
+}
+
+PyObj Interpreter::buildClass(std::vector<PyObj>& args) {
+    if (args.size() < 2 || !args[0].is(ObjectKind::Function) || !args[1].is(ObjectKind::Str)) {
+        raise("TypeError", "__build_class__: argumentos inválidos");
+    }
+    auto cls = track<ClassObject>(as<StrObject>(args[1]).text);
+    std::vector<PyObj> noArgs;
+    callFunction(std::static_pointer_cast<FunctionObject>(args[0].object), noArgs, &cls->attrs);
+    return PyObj::fromObject(std::move(cls));
+}
+
+PyObj Interpreter::callFunction(const std::shared_ptr<FunctionObject>& function, std::vector<PyObj>& args,
+                                Namespace* locals, const std::vector<PyObj>* keywords) {
+    Program& program = programOf(*function->code);
+    if (frames.size() >= options.recursionLimit) {
+        raise("RecursionError", "maximum recursion depth exceeded");
+    }
+    // Sem co_argcount (JSON antigo), os argumentos só são limitados pela quantidade de varnames
+    size_t argcount = program.argcount >= 0 ? static_cast<size_t>(program.argcount) : program.varnames.size();
+    size_t keywordCount = keywords ? keywords->size() : 0;
+    size_t positional = args.size() - keywordCount;
+    if (positional > argcount) {
+        raise("TypeError", function->name + "() takes " + std::to_string(argcount) + " positional arguments but " +
+                               std::to_string(positional) + " were given");
+    }
+    if (keywordCount > 0) {
+        if (program.argcount < 0) {
+            raise("SystemError", "argumentos nomeados em " + function->name + "() exigem co_argcount no JSON");
+        }
+        // Cada nomeado vai para a posição do parâmetro homônimo; só parâmetros posicionais
+        // são aceitos (keyword-only não chegam ao emulador)
+        std::vector<PyObj> values(std::make_move_iterator(args.end() - keywordCount), std::make_move_iterator(args.end()));
+        args.resize(positional);
+        args.resize(argcount);
+        for (size_t i = 0; i < keywordCount; ++i) {
+            const std::string& name = as<StrObject>((*keywords)[i]).text;
+            auto parameters = program.varnames.begin();
+            auto it = std::find(parameters, parameters + argcount, name);
+            if (it == parameters + argcount) {
+                raise("TypeError", function->name + "() got an unexpected keyword argument '" + name + "'");
+            }
+            PyObj& slot = args[it - parameters];
+            if (slot.kind != PyObj::Kind::Unbound) {
+                raise("TypeError", function->name + "() got multiple values for argument '" + name + "'");
+            }
+            slot = std::move(values[i]);
+        }
+    }
+    if (program.argcount >= 0) {
+        // Parâmetros sem argumento recebem o default; os defaults são os dos últimos
+        args.resize(argcount);
+        size_t firstDefault = argcount - std::min(function->defaults.size(), argcount);
+        size_t missing = 0;
+        for (size_t i = 0; i < argcount; ++i) {
+            if (args[i].kind != PyObj::Kind::Unbound) continue;
+            if (i >= firstDefault) {
+                args[i] = function->defaults[function->defaults.size() - (argcount - i)];
+            } else {
+                ++missing;
+            }
+        }
+        if (missing > 0) {
+            raise("TypeError", function->name + "() missing " + std::to_string(missing) +
+                                   " required positional argument(s)");
+        }
+    }
+
+    Frame frame{function->code, &program, {}, {}, locals, false};
+    frame.fast.resize(program.varnames.size());
+    std::move(args.begin(), args.end(), frame.fast.begin());
+    frame.cells.reserve(program.cellNames.size());
+    for (size_t i = 0; i < program.cellCount; ++i) {
+        auto cell = track<CellObject>();
+        if (program.cellArgs[i] >= 0) cell->value = frame.fast[program.cellArgs[i]];
+        frame.cells.push_back(std::move(cell));
+    }
+    for (size_t i = program.cellCount; i < program.cellNames.size(); ++i) {
+        size_t closureIndex = i - program.cellCount;
+        frame.cells.push_back(closureIndex < function->closure.size() ? function->closure[closureIndex]
+                                                                      : track<CellObject>());
+    }
+
+    ++report.calls;
+    frame.mirrored = !frames.empty() && frames.back()->mirrored && emitCall(*frames.back(), *function);
+
+    PyObj result = runFrame(frame);
+    if (frame.mirrored) {
+        record.assign(1, RECORD_RETURN);
+        emit();
+    }
+    return result;
+}
+
+// arith com as listas, que são criadas pelo interpretador
+PyObj Interpreter::binary(ArithOp op, const PyObj& a, const PyObj& b) {
+    if (op == ArithOp::Add && a.is(ObjectKind::List) && b.is(ObjectKind::List)) {
+        std::vector<PyObj> items = as<ListObject>(a).items;
+        const auto& tail = as<ListObject>(b).items;
+        items.insert(items.end(), tail.begin(), tail.end());
+        return makeList(std::move(items));
+    }
+    if (op == ArithOp::Mul && (a.is(ObjectKind::List) || b.is(ObjectKind::List)) && (a.isIntegral() || b.isIntegral())) {
+        const auto& items = as<ListObject>(a.is(ObjectKind::List) ? a : b).items;
+        int64_t count = a.isIntegral() ? a.asInteger() : b.asInteger();
+        std::vector<PyObj> repeated;
+        for (int64_t i = 0; i < count; ++i) repeated.insert(repeated.end(), items.begin(), items.end());
+        return makeList(std::move(repeated));
+    }
+    return arith(op, a, b);
+}
+
+VarType Interpreter::encode(const Program& program, const PyObj& value) const {
+    switch (value.kind) {
+        case PyObj::Kind::Unbound:
+        case PyObj::Kind::None:
+        case PyObj::Kind::Code:
+            return VarType(nullptr);
+        case PyObj::Kind::Bool:
+            return VarType(value.boolean);
+        case PyObj::Kind::Int:
+            if (value.integer < std::numeric_limits<int32_t>::min() || value.integer > std::numeric_limits<int32_t>::max()) {
+                return VarType(nullptr);
+            }
+            return VarType(static_cast<int>(value.integer));
+        case PyObj::Kind::Float:
+            return VarType(static_cast<float>(value.real));
+        case PyObj::Kind::Object:
+            break;
+    }
+    if (value.is(ObjectKind::Str)) {
+        return VarType(as<StrObject>(value).text);
+    }
+    if (value.is(ObjectKind::Function)) {
+        auto it = program.children.find(as<FunctionObject>(value).code);
+        if (it != program.children.end()) {
+            return VarType(static_cast<int>(it->second));  // Referência que o gerenciador resolve em co_consts
+        }
+    }
+    return VarType(nullptr);
+}
+
+bool Interpreter::emitCall(Frame& caller, const FunctionObject& function) {
+    const Program& program = *caller.program;
+    const bool isChild = program.children.count(function.code) != 0;
+
+    // Tabelas do chamador, como o mestre as envia; procura também a posição da função
+    // chamada, preferindo variáveis locais às globais
+    static const int priority[5] = {4, 3, 0, 2, 1};
+    int vector = -1;
+    size_t index = 0;
+    auto fill = [&](int v, size_t i, const PyObj& value) {
+        tables[v].push_back(encode(program, value));
+        if (isChild && i < 256 && value.kind == PyObj::Kind::Object && value.object.get() == &function &&
+            (vector < 0 || priority[v] < priority[vector])) {
+            vector = v;
+            index = i;
+        }
+    };
+    for (auto& table : tables) table.clear();
+
+    for (size_t i = 0; i < rootProgram->names.size(); ++i) {
+        auto it = globals.find(rootProgram->names[i]);
+        fill(0, i, it != globals.end() ? it->second : PyObj());
+    }
+    for (size_t i = 0; i < program.names.size(); ++i) {
+        const PyObj* value = nullptr;
+        if (caller.locals) {
+            auto it = caller.locals->find(program.names[i]);
+            if (it != caller.locals->end()) value = &it->second;
+        }
+        if (!value) {
+            auto it = globals.find(program.names[i]);
+            if (it != globals.end()) value = &it->second;
+        }
+        fill(1, i, value ? *value : PyObj());
+    }
+    for (size_t i = 0; i < caller.fast.size(); ++i) {
+        fill(2, i, caller.fast[i]);
+    }
+    for (size_t i = program.cellCount; i < caller.cells.size(); ++i) {
+        fill(3, i - program.cellCount, caller.cells[i]->value);
+    }
+    for (size_t i = 0; i < program.cellCount; ++i) {
+        fill(4, i, caller.cells[i]->value);
+    }
+
+    if (vector >= 0) {
+        record.assign({RECORD_CALL_FUNCTION, static_cast<uint8_t>(vector), static_cast<uint8_t>(index)});
+    } else if (options.codeTable) {
+        uint32_t id = options.codeTable->idOf(*function.code);
+        if (id > 0xFFFF) return false;
+        record.assign({RECORD_CALL_FRAME, static_cast<uint8_t>(id & 0xFF), static_cast<uint8_t>(id >> 8)});
+    } else {
+        return false;  // Sem representação no protocolo: a chamada fica só no emulador
+    }
+
+    payload.str(std::string());
+    writeInputTables(payload, tables[0], FrameTables{tables[1], tables[2], tables[3], tables[4]}, options.codec);
+    const std::string encoded = payload.str();
+    record.insert(record.end(), encoded.begin(), encoded.end());
+    emit();
+    ++report.mirroredCalls;
+    return true;
+}
+
+void Interpreter::emit() {
+    sink(record);
+    ++report.records;
+}
+
+PyObj Interpreter::runFrame(Frame& frame) {
+    Program& program = *frame.program;
+
+#if EMULATOR_COMPUTED_GOTO
+    if (!program.threaded) {
+        const void* labels[256];
+        std::fill(std::begin(labels), std::end(labels), &&label_unknown);
+#define EMULATOR_LABEL(name) labels[OP_##name] = &&label_##name;
+        EMULATOR_OPCODES(EMULATOR_LABEL)
+#undef EMULATOR_LABEL
+        for (Instr& instr : program.code) {
+            instr.label = labels[instr.opcode];
+        }
+        program.threaded = true;
+    }
+#endif
+
+    // Contabiliza as instruções e desempilha o frame também quando uma exceção o encerra
+    uint64_t executed = 0;
+    struct Scope {
+        Interpreter& interpreter;
+        uint64_t& executed;
+        ~Scope() {
+            interpreter.frames.pop_back();
+            interpreter.report.instructions += executed;
+        }
+    } scope{*this, executed};
+    frames.push_back(&frame);
+
+    std::vector<PyObj> stack;
+    stack.reserve(16);
+    auto pop = [&stack]() {
+        if (stack.empty()) raise("SystemError", "pilha de avaliação vazia");
+        PyObj value = std::move(stack.back());
+        stack.pop_back();
+        return value;
+    };
+    auto popArgs = [&stack](size_t count) {
+        if (stack.size() < count) raise("SystemError", "pilha de avaliação vazia");
+        std::vector<PyObj> args(std::make_move_iterator(stack.end() - count), std::make_move_iterator(stack.end()));
+        stack.resize(stack.size() - count);
+        return args;
+    };
+
+    auto top = [&stack]() -> PyObj& {
+        if (stack.empty()) raise("SystemError", "pilha de avaliação vazia");
+        return stack.back();
+    };
+
+    auto pushFast = [&](uint32_t index) {
+        const PyObj& value = frame.fast[index];
+        if (value.kind == PyObj::Kind::Unbound) {
+            raise("UnboundLocalError", "local variable '" + program.varnames[index] + "' referenced before assignment");
+        }
+        stack.push_back(value);
+    };
+
+    const Instr* const begin = program.code.data();
+    const Instr* ip = begin;
+    const Instr* instr = nullptr;
+
+    // O goto computado sai do bloco sem chamar destrutores: cada tratador fecha o bloco
+    // com as suas variáveis antes do DISPATCH
+#if EMULATOR_COMPUTED_GOTO
+#define DISPATCH()                \
+    do {                          \
+        instr = ip++;             \
+        ++executed;               \
+        goto *instr->label;       \
+    } while (0)
+#define TARGET(name) case OP_##name: label_##name:
+#else
+#define DISPATCH() goto next
+#define TARGET(name) case OP_##name:
+#endif
+
+#define BINARY_TARGET(name, op)                        \
+    TARGET(name) {                                     \
+        PyObj right = pop();                           \
+        stack.back() = binary(op, stack.back(), right); \
+    }                                                  \
+    DISPATCH();
+
+#if EMULATOR_COMPUTED_GOTO
+    DISPATCH();
+#else
+next:
+    instr = ip++;
+    ++executed;
+#endif
+    switch (instr->opcode) {
+        TARGET(POP_TOP) {
+            pop();
+        }
+        DISPATCH();
+        TARGET(ROT_TWO) {
+            if (stack.size() < 2) raise("SystemError", "pilha de avaliação vazia");
+            std::swap(stack[stack.size() - 1], stack[stack.size() - 2]);
+        }
+        DISPATCH();
+        TARGET(ROT_THREE) {
+            if (stack.size() < 3) raise("SystemError", "pilha de avaliação vazia");
+            std::rotate(stack.end() - 3, stack.end() - 1, stack.end());
+        }
+        DISPATCH();
+        TARGET(DUP_TOP) {
+            if (stack.empty()) raise("SystemError", "pilha de avaliação vazia");
+            stack.push_back(stack.back());
+        }
+        DISPATCH();
+        TARGET(NOP)
+        TARGET(EXTENDED_ARG)
+        DISPATCH();
+        TARGET(UNARY_NEGATIVE) {
+            PyObj value = pop();
+            if (value.isIntegral()) {
+                if (value.asInteger() == std::numeric_limits<int64_t>::min()) overflow();
+                stack.push_back(PyObj::fromInt(-value.asInteger()));
+            } else if (value.kind == PyObj::Kind::Float) {
+                stack.push_back(PyObj::fromFloat(-value.real));
+            } else {
+                raise("TypeError", "bad operand type for unary -: '" + typeName(value) + "'");
+            }
+        }
+        DISPATCH();
+        TARGET(UNARY_NOT) {
+            stack.push_back(PyObj::fromBool(!truthy(pop())));
+        }
+        DISPATCH();
+        BINARY_TARGET(BINARY_POWER, ArithOp::Pow)
+        BINARY_TARGET(BINARY_MULTIPLY, ArithOp::Mul)
+        BINARY_TARGET(BINARY_MODULO, ArithOp::Mod)
+        BINARY_TARGET(BINARY_ADD, ArithOp::Add)
+        BINARY_TARGET(BINARY_SUBTRACT, ArithOp::Sub)
+        BINARY_TARGET(BINARY_FLOOR_DIVIDE, ArithOp::FloorDiv)
+        BINARY_TARGET(BINARY_TRUE_DIVIDE, ArithOp::TrueDiv)
+        BINARY_TARGET(INPLACE_FLOOR_DIVIDE, ArithOp::FloorDiv)
+        BINARY_TARGET(INPLACE_TRUE_DIVIDE, ArithOp::TrueDiv)
+        BINARY_TARGET(INPLACE_ADD, ArithOp::Add)
+        BINARY_TARGET(INPLACE_SUBTRACT, ArithOp::Sub)
+        BINARY_TARGET(INPLACE_MULTIPLY, ArithOp::Mul)
+        BINARY_TARGET(INPLACE_MODULO, ArithOp::Mod)
+        BINARY_TARGET(INPLACE_POWER, ArithOp::Pow)
+        TARGET(BINARY_SUBSCR) {
+            PyObj index = pop();
+            top() = subscript(top(), index);
+        }
+        DISPATCH();
+        TARGET(STORE_SUBSCR) {
+            PyObj index = pop();
+            PyObj container = pop();
+            storeSubscript(container, index, pop());
+        }
+        DISPATCH();
+        TARGET(GET_ITER) {
+            top() = makeIterator(top());
+        }
+        DISPATCH();
+        TARGET(FOR_ITER) {
+            if (!top().is(ObjectKind::Iterator)) raise("SystemError", "FOR_ITER sem iterador na pilha");
+            PyObj item;
+            if (nextItem(as<IteratorObject>(stack.back()), item)) {
+                stack.push_back(std::move(item));
+            } else {
+                stack.pop_back();
+                ip = begin + instr->arg;
+            }
+        }
+        DISPATCH();
+        TARGET(UNPACK_SEQUENCE) {
+            std::vector<PyObj> items = itemsOf(pop());
+            if (items.size() != instr->arg) {
+                raise("ValueError", items.size() > instr->arg
+                                        ? "too many values to unpack (expected " + std::to_string(instr->arg) + ")"
+                                        : "not enough values to unpack (expected " + std::to_string(instr->arg) +
+                                              ", got " + std::to_string(items.size()) + ")");
+            }
+            stack.insert(stack.end(), std::make_move_iterator(items.rbegin()), std::make_move_iterator(items.rend()));
+        }
+        DISPATCH();
+        TARGET(LOAD_BUILD_CLASS) {
+            stack.push_back(builtins.at("__build_class__"));
+        }
+        DISPATCH();
+        TARGET(RETURN_VALUE) {
+            return pop();
+        }
+        TARGET(STORE_NAME) {
+            Namespace& target = frame.locals ? *frame.locals : globals;
+            target[program.names[instr->arg]] = pop();
+        }
+        DISPATCH();
+        TARGET(STORE_ATTR) {
+            PyObj owner = pop();
+            setAttr(owner, program.names[instr->arg], pop());
+        }
+        DISPATCH();
+        TARGET(STORE_GLOBAL) {
+            globals[program.names[instr->arg]] = pop();
+        }
+        DISPATCH();
+        TARGET(LOAD_CONST) {
+            stack.push_back(program.consts[instr->arg]);
+        }
+        DISPATCH();
+        TARGET(LOAD_NAME) {
+            const std::string& name = program.names[instr->arg];
+            auto it = frame.locals ? frame.locals->find(name) : globals.end();
+            if (frame.locals && it != frame.locals->end()) {
+                stack.push_back(it->second);
+            } else {
+                stack.push_back(lookupGlobal(name));
+            }
+        }
+        DISPATCH();
+        TARGET(BUILD_TUPLE) {
+            auto tuple = std::make_shared<TupleObject>();
+            tuple->items = popArgs(instr->arg);
+            stack.push_back(PyObj::fromObject(std::move(tuple)));
+        }
+        DISPATCH();
+        TARGET(BUILD_LIST) {
+            stack.push_back(makeList(popArgs(instr->arg)));
+        }
+        DISPATCH();
+        TARGET(LIST_APPEND)
+        TARGET(LIST_EXTEND) {
+            // A lista fica arg posições abaixo do item, como nas compreensões de lista
+            PyObj item = pop();
+            if (instr->arg == 0 || instr->arg > stack.size() || !stack[stack.size() - instr->arg].is(ObjectKind::List)) {
+                raise("SystemError", "LIST_APPEND/LIST_EXTEND sem lista na pilha");
+            }
+            auto& items = as<ListObject>(stack[stack.size() - instr->arg]).items;
+            if (instr->opcode == OP_LIST_APPEND) {
+                items.push_back(std::move(item));
+            } else {
+                std::vector<PyObj> tail = itemsOf(item);
+                items.insert(items.end(), std::make_move_iterator(tail.begin()), std::make_move_iterator(tail.end()));
+            }
+        }
+        DISPATCH();
+        TARGET(LOAD_ATTR)
+        TARGET(LOAD_METHOD) {
+            // LOAD_METHOD/CALL_METHOD viram um atributo já ligado seguido de uma chamada comum
+            PyObj owner = pop();
+            stack.push_back(getAttr(owner, program.names[instr->arg]));
+        }
+        DISPATCH();
+        TARGET(COMPARE_OP) {
+            PyObj right = pop();
+            PyObj left = pop();
+            stack.push_back(PyObj::fromBool(compare(instr->arg, left, right)));
+        }
+        DISPATCH();
+        TARGET(JUMP_FORWARD)
+        TARGET(JUMP_ABSOLUTE) {
+            ip = begin + instr->arg;
+        }
+        DISPATCH();
+        TARGET(JUMP_IF_FALSE_OR_POP) {
+            if (truthy(top())) {
+                stack.pop_back();
+            } else {
+                ip = begin + instr->arg;
+            }
+        }
+        DISPATCH();
+        TARGET(JUMP_IF_TRUE_OR_POP) {
+            if (truthy(top())) {
+                ip = begin + instr->arg;
+            } else {
+                stack.pop_back();
+            }
+        }
+        DISPATCH();
+        TARGET(POP_JUMP_IF_FALSE) {
+            if (!truthy(pop())) ip = begin + instr->arg;
+        }
+        DISPATCH();
+        TARGET(POP_JUMP_IF_TRUE) {
+            if (truthy(pop())) ip = begin + instr->arg;
+        }
+        DISPATCH();
+        TARGET(LOAD_GLOBAL) {
+            stack.push_back(lookupGlobal(program.names[instr->arg]));
+        }
+        DISPATCH();
+        TARGET(IS_OP) {
+            PyObj right = pop();
+            PyObj left = pop();
+            stack.push_back(PyObj::fromBool(identical(left, right) != (instr->arg == 1)));
+        }
+        DISPATCH();
+        TARGET(CONTAINS_OP) {
+            PyObj container = pop();
+            PyObj item = pop();
+            stack.push_back(PyObj::fromBool(contains(container, item) != (instr->arg == 1)));
+        }
+        DISPATCH();
+        TARGET(LOAD_FAST) {
+            pushFast(instr->arg);
+        }
+        DISPATCH();
+        TARGET(STORE_FAST) {
+            frame.fast[instr->arg] = pop();
+        }
+        DISPATCH();
+        TARGET(CALL_FUNCTION)
+        TARGET(CALL_METHOD) {
+            std::vector<PyObj> args = popArgs(instr->arg);
+            PyObj callable = pop();
+            stack.push_back(call(callable, args));
+        }
+        DISPATCH();
+        TARGET(CALL_FUNCTION_KW) {
+            // Nomes dos argumentos nomeados no topo, numa tupla constante; os valores são
+            // os últimos argumentos
+            PyObj names = pop();
+            const bool valid = names.is(ObjectKind::Tuple) && as<TupleObject>(names).items.size() <= instr->arg &&
+                               std::all_of(as<TupleObject>(names).items.begin(), as<TupleObject>(names).items.end(),
+                                           [](const PyObj& name) { return name.is(ObjectKind::Str); });
+            if (!valid) raise("SystemError", "CALL_FUNCTION_KW sem a tupla de nomes");
+            std::vector<PyObj> args = popArgs(instr->arg);
+            PyObj callable = pop();
+            stack.push_back(call(callable, args, &as<TupleObject>(names).items));
+        }
+        DISPATCH();
+        TARGET(MAKE_FUNCTION) {
+            PyObj qualname = pop();
+            PyObj code = pop();
+            if (code.kind != PyObj::Kind::Code) {
+                raise("SystemError", "MAKE_FUNCTION sem objeto-código");
+            }
+            auto function = std::make_shared<FunctionObject>();
+            function->code = code.code;
+            function->name = qualname.is(ObjectKind::Str) ? as<StrObject>(qualname).text : std::string("<lambda>");
+            if (instr->arg & 0x08) {
+                PyObj closure = pop();
+                if (closure.is(ObjectKind::Tuple)) {
+                    for (const PyObj& cell : as<TupleObject>(closure).items) {
+                        if (cell.is(ObjectKind::Cell)) {
+                            function->closure.push_back(std::static_pointer_cast<CellObject>(cell.object));
+                        }
+                    }
+                }
+            }
+            // Anotações e defaults de argumentos keyword-only são descartados: nomeados só
+            // são passados a parâmetros posicionais
+            for (uint32_t flag : {0x04u, 0x02u}) {
+                if (instr->arg & flag) pop();
+            }
+            if (instr->arg & 0x01) {
+                PyObj defaults = pop();
+                if (!defaults.is(ObjectKind::Tuple)) {
+                    raise("SystemError", "MAKE_FUNCTION com defaults que não são uma tupla");
+                }
+                function->defaults = as<TupleObject>(defaults).items;
+            }
+            stack.push_back(PyObj::fromObject(std::move(function)));
+        }
+        DISPATCH();
+        TARGET(LOAD_CLOSURE) {
+            stack.push_back(PyObj::fromObject(frame.cells[instr->arg]));
+        }
+        DISPATCH();
+        TARGET(LOAD_DEREF) {
+            const PyObj& value = frame.cells[instr->arg]->value;
+            if (value.kind == PyObj::Kind::Unbound) {
+                raise("NameError", "free variable '" + program.cellNames[instr->arg] +
+                                       "' referenced before assignment in enclosing scope");
+            }
+            stack.push_back(value);
+        }
+        DISPATCH();
+        TARGET(STORE_DEREF) {
+            frame.cells[instr->arg]->value = pop();
+        }
+        DISPATCH();
+        TARGET(FORMAT_VALUE) {
+            if (instr->arg & 0x04) {
+                PyObj spec = pop();
+                if (!spec.is(ObjectKind::Str) || !as<StrObject>(spec).text.empty()) {
+                    raise("NotImplementedError", "especificação de formato em f-string não suportada pelo emulador");
+                }
+            }
+            PyObj value = pop();
+            stack.push_back(makeStr((instr->arg & 0x03) == 2 ? repr(value) : toStr(value)));
+        }
+        DISPATCH();
+        TARGET(BUILD_STRING) {
+            std::vector<PyObj> parts = popArgs(instr->arg);
+            std::string text;
+            for (const PyObj& part : parts) {
+                text += toStr(part);
+            }
+            stack.push_back(makeStr(std::move(text)));
+        }
+        DISPATCH();
+        // Superinstruções: a segunda instrução do par é lida de ip, contada e pulada
+        TARGET(LOAD_FAST__LOAD_FAST) {
+            pushFast(instr->arg);
+            pushFast((ip++)->arg);
+            ++executed;
+        }
+        DISPATCH();
+        TARGET(LOAD_FAST__LOAD_CONST) {
+            pushFast(instr->arg);
+            stack.push_back(program.consts[(ip++)->arg]);
+            ++executed;
+        }
+        DISPATCH();
+        TARGET(STORE_FAST__LOAD_FAST) {
+            frame.fast[instr->arg] = pop();
+            pushFast((ip++)->arg);
+            ++executed;
+        }
+        DISPATCH();
+        TARGET(LOAD_CONST__RETURN_VALUE) {
+            ++executed;
+            return program.consts[instr->arg];
+        }
+        TARGET(COMPARE_OP__POP_JUMP_IF_FALSE) {
+            PyObj right = pop();
+            PyObj left = pop();
+            bool result = compare(instr->arg, left, right);
+            ++executed;
+            ip = result ? ip + 1 : begin + ip->arg;
+        }
+        DISPATCH();
+        default:
+#if EMULATOR_COMPUTED_GOTO
+        label_unknown:
+#endif
+            if (instr == begin + program.code.size() - 1) {
+                raise("SystemError", "co_code terminou sem RETURN_VALUE");
+            }
+            // Offset em bytes, como no dis do CPython
+            raise("SystemError", "opcode " + std::to_string(instr->opcode) + " não suportado pelo emulador no offset " +
+                                     std::to_string(2 * (instr - begin)) + " do co_code");
+    }
+    raise("SystemError", "co_code terminou sem RETURN_VALUE");
+
+#undef BINARY_TARGET
+#undef TARGET
+#undef DISPATCH
+}
+
+}
+
+void EmulatorReport::write(std::ostream& os) const {
+    os << "emulator: instructions=" << instructions << " calls=" << calls << " mirrored=" << mirroredCalls
+       << " records=" << records << std::endl;
+    if (!error.empty()) {
+        os << "emulator: " << error << std::endl;
+    }
+}
+
+EmulatorReport runMasterEmulator(Code& root, const RecordSink& sink, const EmulatorOptions& options) {
+    EmulatorReport report;
+    Interpreter interpreter(root, sink, options, report);
+    try {
+        interpreter.runModule();
+    } catch (const PythonError& error) {
+        report.error = error.what();
+    }
+    return report;
+}
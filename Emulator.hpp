@@ -0,0 +1,73 @@
+#ifndef EMULATOR_H
+#define EMULATOR_H
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "Code.hpp"
+#include "CodeTable.hpp"
+
+/*
+    * Mestre emulado: interpreta o bytecode CPython guardado em co_code e, enquanto executa
+    * o programa, emite os mesmos registros que o mestre real enviaria ao gerenciador:
+    * INIT no início, uma chamada para cada função Python entrada e RETURN na saída dela.
+    *
+    * O bytecode é o do CPython 3.10 (saltos contados em instruções), em .pyc ou no JSON de
+    * pyc_serializer.py rodado no 3.10; os nomes das variáveis vêm de Code::identifiers.
+    * Os valores são os do programa: inteiros de 64 bits, floats, strings, tuplas, listas,
+    * range, funções com closures, classes com atributos e métodos. As constantes passam por
+    * Value, e floats ficam com precisão simples; as que Value não representa (inteiros fora
+    * de int32, tuplas) vêm de CodeIdentifiers::literals. Uma constante sem equivalente no
+    * emulador (bytes, inteiro fora de 64 bits) encerra a execução com SystemError na carga
+    * do frame que a contém.
+    *
+    * Subconjunto suportado: aritmética, comparações, is, in; if, while e for (sobre tuplas,
+    * listas, range e strings); and/or; desempacotamento; subscrição sem fatias e atribuição
+    * a itens de lista; compreensões de lista; f-strings sem especificação de formato;
+    * chamadas posicionais e com argumentos nomeados de parâmetros posicionais, com valores
+    * padrão; closures; classes com métodos e classmethod. Builtins: print (com sep e end),
+    * len, range, list, tuple, max, min, abs, str, repr, int, float e bool. Os demais opcodes
+    * (dicionários, conjuntos, fatias, try, *args, keyword-only, ...) encerram a execução com
+    * SystemError, com o número do opcode e o offset dele no co_code.
+    * O co_code é executado na forma pré-decodificada de Bytecode.hpp, com superinstruções;
+    * cada superinstrução conta como as duas instruções que substitui.
+    *
+    * Chamadas enviadas ao gerenciador:
+    *   - CALL_FUNCTION quando a função chamada é um Code filho do frame atual e está em uma
+    *     das tabelas do frame; o payload leva as tabelas com essa posição valendo o índice
+    *     do Code em co_consts, como o gerenciador espera
+    *   - CALL_FRAME (modo por id de frame) para as demais, como métodos e corpos de classe
+    *   - sem tabela de frames, essas outras chamadas são executadas só no emulador, junto
+    *     com tudo o que for chamado a partir delas, para não dessincronizar a pilha do
+    *     gerenciador
+*/
+
+// Recebe cada registro já montado (instrução, argumentos e payload, sem o separador)
+using RecordSink = std::function<void(const std::vector<uint8_t>& record)>;
+
+struct EmulatorOptions {
+    const CodeTable* codeTable = nullptr;  // habilita CALL_FRAME
+    PayloadCodec codec = PayloadCodec::V1;
+    std::ostream* output = nullptr;        // saída de print(); nullptr descarta
+    unsigned recursionLimit = 1000;
+    bool superinstructions = true;         // usa o Bytecode em cache de cada Code (ver Bytecode.hpp)
+};
+
+struct EmulatorReport {
+    uint64_t instructions = 0;   // instruções de bytecode executadas
+    uint64_t calls = 0;          // chamadas a funções Python
+    uint64_t mirroredCalls = 0;  // chamadas enviadas ao gerenciador
+    uint64_t records = 0;
+    std::string error;           // exceção Python que encerrou o programa, se houver
+
+    void write(std::ostream& os) const;
+};
+
+// Executa o módulo root do início ao fim, entregando os registros a sink. Exceções do
+// programa emulado terminam a execução e ficam em EmulatorReport::error; erros de sink
+// (do gerenciador, por exemplo) são propagados
+EmulatorReport runMasterEmulator(Code& root, const RecordSink& sink, const EmulatorOptions& options = {});
+
+#endif
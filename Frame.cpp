@@ -0,0 +1,144 @@
+#include <stdexcept>
+#include <iterator>
+#include <algorithm>
+#include "Frame.hpp"
+
+void FrameStack::push(Code& code) {
+    Frame frame{&code, slots.size(),
+                static_cast<uint32_t>(code.co_names.size()), static_cast<uint32_t>(code.co_varnames.size()),
+                static_cast<uint32_t>(code.co_freevars.size()), static_cast<uint32_t>(code.co_cellvars.size()),
+                {}, CallCache{}};
+    // Crescimento geométrico: reservar o tamanho exato realocaria a pilha inteira a cada
+    // nível novo, e uma descida de n frames (como a de restoreSession) custaria O(n²)
+    size_t needed = slots.size() + frame.names + frame.varnames + frame.freevars + frame.cellvars;
+    if (needed > slots.capacity()) {
+        slots.reserve(std::max(needed, 2 * slots.capacity()));
+    }
+    slots.insert(slots.end(), code.co_names.begin(), code.co_names.end());
+    slots.insert(slots.end(), code.co_varnames.begin(), code.co_varnames.end());
+    slots.insert(slots.end(), code.co_freevars.begin(), code.co_freevars.end());
+    slots.insert(slots.end(), code.co_cellvars.begin(), code.co_cellvars.end());
+    frames.push_back(frame);
+}
+
+void FrameStack::pop() {
+    if (frames.empty()) {
+        throw std::runtime_error("Navigation stack is empty.");
+    }
+    slots.resize(frames.back().base);
+    frames.pop_back();
+}
+
+Code& FrameStack::topCode() const {
+    if (frames.empty()) {
+        throw std::runtime_error("Navigation stack is empty.");
+    }
+    return *frames.back().code;
+}
+
+FrameTables FrameStack::topTables() const {
+    if (frames.empty()) {
+        throw std::runtime_error("Navigation stack is empty.");
+    }
+    return tablesAt(frames.size() - 1);
+}
+
+FrameTables FrameStack::tablesAt(size_t i) const {
+    const Frame& frame = frames.at(i);
+    const VarType* base = slots.data() + frame.base;
+    return FrameTables{
+        {base, frame.names},
+        {base + frame.names, frame.varnames},
+        {base + frame.names + frame.varnames, frame.freevars},
+        {base + frame.names + frame.varnames + frame.freevars, frame.cellvars}
+    };
+}
+
+void FrameStack::updateTop(const std::string& payload, std::vector<VarType>& globals) {
+    FrameTables current = topTables();
+    std::span<const VarType> tables[4] = {current.names, current.varnames, current.freevars, current.cellvars};
+    for (size_t i = 0; i < 4; ++i) {
+        scratch[i].assign(tables[i].begin(), tables[i].end());
+    }
+    scratchGlobals.assign(globals.begin(), globals.end());
+
+    decodeFramePayload(payload, scratchGlobals, scratch[0], scratch[1], scratch[2], scratch[3], decodeOptions);
+    commitTop(globals);
+}
+
+void FrameStack::updateTop(DecodedPayload& decoded, std::vector<VarType>& globals) {
+    FrameTables current = topTables();
+    std::span<const VarType> tables[4] = {current.names, current.varnames, current.freevars, current.cellvars};
+    // Vetores ausentes do payload mantêm o conteúdo atual, como em decodeFramePayload
+    if (decoded.count > 0) {
+        scratchGlobals.swap(decoded.vectors[0]);
+    } else {
+        scratchGlobals.assign(globals.begin(), globals.end());
+    }
+    for (size_t i = 0; i < 4; ++i) {
+        if (decoded.count > i + 1) {
+            scratch[i].swap(decoded.vectors[i + 1]);
+        } else {
+            scratch[i].assign(tables[i].begin(), tables[i].end());
+        }
+    }
+    commitTop(globals);
+}
+
+void FrameStack::commitTop(std::vector<VarType>& globals) {
+    FrameTables current = topTables();
+    std::span<const VarType> tables[4] = {current.names, current.varnames, current.freevars, current.cellvars};
+
+    if (!std::ranges::equal(scratchGlobals, globals)) {
+        globals.swap(scratchGlobals);
+        invalidateGlobals();
+    }
+
+    Frame& frame = frames.back();
+    bool changed = false;
+    for (size_t i = 0; i < 4; ++i) {
+        if (!std::ranges::equal(scratch[i], tables[i])) {
+            frame.versions[i] = ++versionCounter;
+            changed = true;
+        }
+    }
+    if (!changed) {
+        return;  // O mestre reenviou as mesmas tabelas
+    }
+
+    // O frame do topo ocupa o fim de slots, então as tabelas podem mudar de tamanho
+    slots.resize(frame.base);
+    for (auto& table : scratch) {
+        slots.insert(slots.end(), std::make_move_iterator(table.begin()), std::make_move_iterator(table.end()));
+    }
+    frame.names = static_cast<uint32_t>(scratch[0].size());
+    frame.varnames = static_cast<uint32_t>(scratch[1].size());
+    frame.freevars = static_cast<uint32_t>(scratch[2].size());
+    frame.cellvars = static_cast<uint32_t>(scratch[3].size());
+}
+
+Code& FrameStack::resolveCall(const std::vector<VarType>& globals, size_t vector, size_t index) {
+    if (frames.empty()) {
+        throw std::runtime_error("Navigation stack is empty.");
+    }
+    Frame& frame = frames.back();
+    CallCache& cache = frame.callCache;
+    uint64_t version = vector == 0 ? globalsVersion : (vector <= 4 ? frame.versions[vector - 1] : 0);
+
+    if (cache.target && cache.vector == vector && cache.index == index && cache.version == version) {
+        ++cacheStats.hits;
+        lastHit = true;
+        return *cache.target;
+    }
+
+    ++cacheStats.misses;
+    lastHit = false;
+    Code& target = frame.code->getCodeFromVariable(globals, topTables(), vector, index);
+    cache = CallCache{&target, version, static_cast<uint32_t>(index), static_cast<uint8_t>(vector)};
+    return target;
+}
+
+void FrameStack::reserve(size_t frameCount, size_t slotCount) {
+    frames.reserve(frameCount);
+    slots.reserve(slotCount);
+}
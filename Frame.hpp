@@ -0,0 +1,106 @@
+#ifndef FRAME_H
+#define FRAME_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Code.hpp"
+
+// Última resolução de CALL_FUNCTION feita por uma ativação. Vale enquanto a tabela
+// indicada por vector mantiver a mesma versão
+struct CallCache {
+    Code* target = nullptr;
+    uint64_t version = 0;
+    uint32_t index = 0;
+    uint8_t vector = 0;
+};
+
+// Registro de ativação de uma chamada: referencia o Code compartilhado, que não é
+// alterado durante a execução (fora a carga adiada, feita uma vez por Code::materialize),
+// e localiza as tabelas desta ativação na FrameStack
+struct Frame {
+    Code* code;
+    size_t base;        // Posição da primeira tabela em FrameStack
+    uint32_t names;
+    uint32_t varnames;
+    uint32_t freevars;
+    uint32_t cellvars;
+    // Versão de cada tabela, na ordem do argumento vector (1 a 4) do CALL_FUNCTION
+    uint64_t versions[4];
+    CallCache callCache;
+};
+
+struct CallCacheStats {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+// Pilha contígua de ativações. As tabelas de cada frame ficam lado a lado em um único
+// vetor: CALL_FUNCTION acrescenta as do novo frame no topo e RETURN apenas recua o topo.
+// A memória é reaproveitada entre chamadas, e um Code chamado recursivamente ganha uma
+// ativação nova a cada chamada em vez de compartilhar o estado do chamador
+class FrameStack {
+public:
+    // Empilha uma ativação de code, com as tabelas iniciais carregadas do arquivo
+    void push(Code& code);
+    void pop();
+
+    bool empty() const { return frames.empty(); }
+    size_t depth() const { return frames.size(); }
+
+    Code& topCode() const;
+    FrameTables topTables() const;
+
+    // Ativação i, a partir do frame raiz (0), e as suas tabelas; usadas pelos checkpoints
+    const Frame& frameAt(size_t i) const { return frames.at(i); }
+    FrameTables tablesAt(size_t i) const;
+
+    // Aplica o payload de um CALL_FUNCTION às tabelas da ativação do topo. Só as tabelas
+    // (e as globais) cujo conteúdo mudou recebem uma versão nova
+    void updateTop(const std::string& payload, std::vector<VarType>& globals);
+
+    // Mesmo efeito, com o payload já decodificado fora da sessão. Os vetores de decoded
+    // são trocados pelos de trabalho da pilha, e voltam com memória para reaproveitar
+    void updateTop(DecodedPayload& decoded, std::vector<VarType>& globals);
+
+    // Codificação dos payloads recebidos por updateTop; com options.symbols, as strings
+    // recebidas são internadas nessa tabela
+    void setPayloadOptions(const PayloadOptions& options) { decodeOptions = options; }
+
+    // Resolve o Code chamado pela ativação do topo, como Code::getCodeFromVariable, mas
+    // responde pelo cache da ativação quando (vector, index, versão da tabela) se repete
+    Code& resolveCall(const std::vector<VarType>& globals, size_t vector, size_t index);
+
+    // As globais pertencem à sessão; alterações feitas fora de updateTop devem chamar
+    // invalidateGlobals para que o cache não devolva um Code antigo
+    void invalidateGlobals() { globalsVersion = ++versionCounter; }
+
+    // Muda a cada substituição (ou possível alteração) das globais
+    uint64_t globalsStamp() const { return globalsVersion; }
+
+    const CallCacheStats& callCacheStats() const { return cacheStats; }
+    bool lastCallHit() const { return lastHit; }
+
+    // Pré-aloca espaço para evitar realocações nas primeiras chamadas
+    void reserve(size_t frameCount, size_t slotCount);
+
+private:
+    std::vector<Frame> frames;
+    std::vector<VarType> slots;
+
+    // Vetores de trabalho de updateTop, mantidos para reaproveitar a memória
+    std::vector<VarType> scratch[4];
+    std::vector<VarType> scratchGlobals;
+
+    PayloadOptions decodeOptions;
+
+    // Substitui as tabelas do topo (e as globais) pelas de scratch que mudaram
+    void commitTop(std::vector<VarType>& globals);
+
+    uint64_t versionCounter = 0;
+    uint64_t globalsVersion = 0;
+    CallCacheStats cacheStats;
+    bool lastHit = false;
+};
+
+#endif
@@ -0,0 +1,179 @@
+#include <new>
+#include <cstddef>
+#include <stdexcept>
+#include "FrameExecutor.hpp"
+#include "Dispatcher.hpp"
+
+namespace {
+// Espaço antes de cada frame de corrotina para guardar o pool de origem
+const size_t FRAME_HEADER = alignof(std::max_align_t);
+}
+
+FramePool::~FramePool() {
+    for (void* block : freeBlocks) {
+        ::operator delete(block);
+    }
+}
+
+void* FramePool::allocate(size_t size) {
+    if (size == blockSize && !freeBlocks.empty()) {
+        void* block = freeBlocks.back();
+        freeBlocks.pop_back();
+        return block;
+    }
+    if (blockSize == 0) {
+        blockSize = size;
+    }
+    return ::operator new(size);
+}
+
+void FramePool::release(void* block, size_t size) {
+    if (size == blockSize) {
+        freeBlocks.push_back(block);
+    } else {
+        ::operator delete(block);
+    }
+}
+
+void* FrameTask::promise_type::operator new(size_t size, FrameExecutor& e, Code&) {
+    char* raw = static_cast<char*>(e.pool.allocate(size + FRAME_HEADER));
+    *reinterpret_cast<FramePool**>(raw) = &e.pool;
+    return raw + FRAME_HEADER;
+}
+
+void FrameTask::promise_type::operator delete(void* ptr, size_t size) {
+    char* raw = static_cast<char*>(ptr) - FRAME_HEADER;
+    FramePool* pool = *reinterpret_cast<FramePool**>(raw);
+    pool->release(raw, size + FRAME_HEADER);
+}
+
+std::coroutine_handle<> FrameTask::promise_type::FinalAwaiter::await_suspend(
+        std::coroutine_handle<promise_type> h) noexcept {
+    // RETURN: retoma o frame chamador, que voltará a aguardar instruções
+    if (h.promise().continuation) {
+        return h.promise().continuation;
+    }
+    // RETURN do frame raiz: a sessão terminou
+    h.promise().executor.done = true;
+    return std::noop_coroutine();
+}
+
+void FrameTask::promise_type::unhandled_exception() {
+    executor.error = std::current_exception();
+}
+
+FrameTask& FrameTask::operator=(FrameTask&& other) noexcept {
+    if (this != &other) {
+        if (handle) handle.destroy();
+        handle = other.handle;
+        other.handle = nullptr;
+    }
+    return *this;
+}
+
+FrameTask::~FrameTask() {
+    if (handle) {
+        handle.destroy();
+    }
+}
+
+FrameTask FrameExecutor::runFrame(FrameExecutor& executor, Code& code) {
+    for (;;) {
+        const std::vector<uint8_t>* record = co_await executor.nextInstruction(code);
+        if (!record) {
+            // Frame de um checkpoint (ver restore): empilhado sem payload nem resolução
+            Code& child = *executor.restoring;
+            executor.frames.push(child);
+            co_await runFrame(executor, child);
+            continue;
+        }
+        const std::vector<uint8_t>& segment = *record;
+        uint8_t instruction = segment[0];
+
+        if (instruction == INSTR_RETURN) {
+            executor.frames.pop();
+            if (executor.frames.empty()) {
+                // RETURN do frame raiz: encerra a sessão com o mesmo erro do Dispatcher
+                executor.error = std::make_exception_ptr(std::runtime_error("Navigation stack is empty."));
+            }
+            co_return;
+        } else if (instruction == INSTR_CALL_FUNCTION || instruction == INSTR_CALL_FRAME) {
+            // Erros de resolução mantêm o frame atual, como no Dispatcher
+            Code* child = nullptr;
+            try {
+                child = instruction == INSTR_CALL_FUNCTION
+                    ? &applyCallFunction(executor.frames, segment, executor.globals, executor.pendingDecoded)
+                    : &applyCallFrame(executor.frames, executor.codeTable, segment, executor.globals,
+                                      executor.pendingDecoded);
+            } catch (...) {
+                executor.error = std::current_exception();
+                continue;
+            }
+            executor.frames.push(*child);
+            if (executor.prefetcher) executor.prefetcher->call(*child);
+            co_await runFrame(executor, *child);
+        } else if (instruction != INSTR_INIT) {
+            executor.error = std::make_exception_ptr(std::runtime_error("Instrução desconhecida"));
+        }
+    }
+}
+
+FrameExecutor::FrameExecutor(Code& root) : globals(root.co_names), currCode(&root) {
+    frames.push(root);
+    this->root = runFrame(*this, root);
+    // Executa o frame raiz até ele aguardar a primeira instrução
+    this->root.handle.resume();
+}
+
+uint8_t FrameExecutor::dispatch(const std::vector<uint8_t>& segment, DecodedPayload* decoded) {
+    if (!metrics) {
+        return apply(segment, decoded);
+    }
+
+    // Apenas instruções aplicadas com sucesso entram no histograma
+    auto start = Metrics::Clock::now();
+    uint8_t instruction = apply(segment, decoded);
+    metrics->recordInstruction(instruction, Metrics::Clock::now() - start);
+    metrics->recordDecoded(segment.size());
+    if (instruction == INSTR_CALL_FUNCTION) {
+        metrics->recordCallCache(frames.lastCallHit());
+    }
+    if (prefetcher && (instruction == INSTR_CALL_FUNCTION || instruction == INSTR_CALL_FRAME)) {
+        metrics->recordPrefetch(prefetcher->lastCallHit());
+    }
+    return instruction;
+}
+
+uint8_t FrameExecutor::apply(const std::vector<uint8_t>& segment, DecodedPayload* decoded) {
+    if (segment.empty()) {
+        throw std::runtime_error("Registro vazio");
+    }
+    if (done) {
+        throw std::runtime_error("Navigation stack is empty.");
+    }
+
+    pending = &segment;
+    pendingDecoded = decoded;
+    waiting.resume();
+    pending = nullptr;
+    pendingDecoded = nullptr;
+
+    if (error) {
+        std::exception_ptr e = error;
+        error = nullptr;
+        std::rethrow_exception(e);
+    }
+    return segment[0];
+}
+
+void FrameExecutor::restore(SavedSession& saved) {
+    if (done) {
+        throw std::runtime_error("Navigation stack is empty.");
+    }
+    restoreSession(saved, frames, globals, symbols.get(), [this](Code& code) {
+        restoring = &code;
+        waiting.resume();
+        restoring = nullptr;
+        if (prefetcher) prefetcher->call(code);
+    });
+}
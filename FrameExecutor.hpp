@@ -0,0 +1,203 @@
+#ifndef FRAME_EXECUTOR_H
+#define FRAME_EXECUTOR_H
+
+#include <coroutine>
+#include <exception>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "Code.hpp"
+#include "Frame.hpp"
+#include "CodeTable.hpp"
+#include "Prefetch.hpp"
+#include "Metrics.hpp"
+#include "Checkpoint.hpp"
+
+class FrameExecutor;
+
+// Reaproveita a memória dos frames de corrotina encerrados. Todos os frames de uma
+// sessão têm o mesmo tamanho, então uma lista livre simples basta
+class FramePool {
+public:
+    FramePool() = default;
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+    ~FramePool();
+
+    void* allocate(size_t size);
+    void release(void* block, size_t size);
+
+private:
+    std::vector<void*> freeBlocks;
+    size_t blockSize = 0;
+};
+
+// Corrotina de um frame: fica suspensa aguardando a próxima instrução do mestre,
+// suspende-se novamente dentro do frame filho a cada CALL_FUNCTION e termina no RETURN
+class FrameTask {
+public:
+    struct promise_type {
+        FrameExecutor& executor;
+        std::coroutine_handle<> continuation;
+
+        promise_type(FrameExecutor& e, Code&) : executor(e) {}
+
+        // Frames alocados no FramePool da sessão
+        static void* operator new(size_t size, FrameExecutor& e, Code&);
+        static void operator delete(void* ptr, size_t size);
+
+        struct FinalAwaiter {
+            bool await_ready() const noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept;
+            void await_resume() const noexcept {}
+        };
+
+        FrameTask get_return_object() {
+            return FrameTask(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception();
+    };
+
+    FrameTask() = default;
+    FrameTask(FrameTask&& other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    FrameTask& operator=(FrameTask&& other) noexcept;
+    FrameTask(const FrameTask&) = delete;
+    FrameTask& operator=(const FrameTask&) = delete;
+    ~FrameTask();
+
+    // co_await de um frame filho: transfere o controle para ele e retoma o chamador no RETURN
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> parent) noexcept {
+        handle.promise().continuation = parent;
+        return handle;
+    }
+    void await_resume() const noexcept {}
+
+private:
+    explicit FrameTask(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+
+    friend class FrameExecutor;
+};
+
+// Executor de uma sessão baseado em corrotinas: cada frame empilhado é uma corrotina
+// suspensa, e dispatch() apenas entrega o registro e retoma a corrotina em espera.
+// Muitas sessões podem ser multiplexadas em uma mesma thread, cada uma custando
+// apenas os frames de corrotina das chamadas em andamento
+class FrameExecutor {
+public:
+    // Mesmo ponto de partida do Dispatcher: globais iniciadas com co_names do frame raiz
+    explicit FrameExecutor(Code& root);
+    FrameExecutor(const FrameExecutor&) = delete;
+    FrameExecutor& operator=(const FrameExecutor&) = delete;
+
+    // Processa um registro já separado por splitByDelimiters e retorna a instrução aplicada.
+    // decoded: payload do registro já decodificado com decodeOptions() (ver Pipeline.hpp)
+    uint8_t dispatch(const std::vector<uint8_t>& segment, DecodedPayload* decoded = nullptr);
+
+    // Ativa a coleta de métricas por instrução (nullptr desativa)
+    void setMetrics(Metrics* m) { metrics = m; }
+
+    // Liga o modo por id de frame: aceita CALL_FRAME e responde só com id e tabelas
+    void setCodeTable(const CodeTable* table) { codeTable = table; }
+
+    // Liga o modo de símbolos (ver Symbols.hpp) nas duas direções da sessão
+    void enableSymbols() {
+        symbols = std::make_unique<SessionSymbols>();
+        frames.setPayloadOptions(incomingOptions());
+    }
+
+    // Opções com que os payloads recebidos são decodificados (ver Dispatcher::decodeOptions)
+    PayloadOptions decodeOptions() const { return incomingOptions(); }
+
+    // Revisão da codificação dos payloads, nas duas direções da sessão
+    void setCodec(PayloadCodec value) {
+        codec = value;
+        frames.setPayloadOptions(incomingOptions());
+    }
+
+    // Liga a pré-busca dos possíveis filhos de cada frame empilhado (nullptr desativa)
+    void setPrefetcher(Prefetcher* p) {
+        prefetcher = p;
+        if (prefetcher && !done) prefetcher->enter(*currCode);
+    }
+
+    // Embute até depth níveis de Codes aninhados nas respostas (ver NestedCodeTag)
+    void setInlineDepth(unsigned depth) { inlineDepth = depth; }
+
+    Code* current() { return currCode; }
+    // Após o RETURN do frame raiz não há ativação; restam as tabelas iniciais do Code
+    FrameTables currentTables() const { return frames.empty() ? currCode->tables() : frames.topTables(); }
+    std::vector<VarType>& getGlobals() {
+        frames.invalidateGlobals();
+        return globals;
+    }
+    const CallCacheStats& callCacheStats() const { return frames.callCacheStats(); }
+    // Altera a tabela de símbolos de saída, como no Dispatcher
+    std::string currentPayload() {
+        PayloadOptions outgoing{symbols ? &symbols->outgoing : nullptr, codec, inlineDepth};
+        if (codeTable) {
+            return codeTable->framePayload(*currCode, globals, currentTables(), outgoing);
+        }
+        return currCode->generatePayload(globals, currentTables(), outgoing);
+    }
+    bool finished() { return done; }
+
+    // Checkpoints, como no Dispatcher. restore recria a corrotina de cada frame salvo
+    SessionState state() const { return SessionState{frames, globals, symbols.get()}; }
+    void restore(SavedSession& saved);
+
+private:
+    // Declarado antes de root: os frames precisam ser destruídos antes do pool
+    FramePool pool;
+    std::unique_ptr<SessionSymbols> symbols;
+    PayloadCodec codec = PayloadCodec::V1;
+    unsigned inlineDepth = 0;
+    FrameStack frames;
+    std::vector<VarType> globals;
+    Code* currCode;
+    Metrics* metrics = nullptr;
+    const CodeTable* codeTable = nullptr;
+    Prefetcher* prefetcher = nullptr;
+
+    // Estado da troca entre dispatch() e a corrotina em espera
+    const std::vector<uint8_t>* pending = nullptr;
+    DecodedPayload* pendingDecoded = nullptr;
+    std::coroutine_handle<> waiting;
+    std::exception_ptr error;
+    bool done = false;
+
+    // Code que a corrotina em espera empilha sem registro do mestre (ver restore)
+    Code* restoring = nullptr;
+
+    FrameTask root;
+
+    struct InstructionAwaiter {
+        FrameExecutor& executor;
+        Code& code;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h) noexcept {
+            executor.waiting = h;
+            executor.currCode = &code;
+        }
+        // nullptr: retomada por restore, sem registro
+        const std::vector<uint8_t>* await_resume() const noexcept { return executor.pending; }
+    };
+
+    InstructionAwaiter nextInstruction(Code& code) { return InstructionAwaiter{*this, code}; }
+    uint8_t apply(const std::vector<uint8_t>& segment, DecodedPayload* decoded);
+
+    PayloadOptions incomingOptions() const {
+        return PayloadOptions{symbols ? &symbols->incoming : nullptr, codec};
+    }
+
+    static FrameTask runFrame(FrameExecutor& executor, Code& code);
+
+    friend struct FrameTask::promise_type;
+};
+
+#endif
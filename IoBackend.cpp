@@ -0,0 +1,631 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include "IoBackend.hpp"
+
+namespace {
+// Blocos de 128 KiB, até 8 em voo; a fila de submissão comporta todos com folga
+const size_t IO_BLOCK_SIZE = 128 * 1024;
+const unsigned IO_BLOCK_COUNT = 8;
+const unsigned QUEUE_DEPTH = 16;
+
+// Escritas acumuladas antes de um io_uring_enter sem espera
+const unsigned WRITE_BATCH = 4;
+
+[[noreturn]] void throwErrno(const std::string& what, int error = errno) {
+    throw std::runtime_error(what + ": " + std::strerror(error));
+}
+
+IoBackend effectiveBackend(IoBackend requested) {
+    return requested == IoBackend::Uring && !uringAvailable() ? IoBackend::Posix : requested;
+}
+}
+
+// Anel de io_uring montado diretamente sobre io_uring_setup/io_uring_enter/io_uring_register
+class IoUring {
+public:
+    explicit IoUring(unsigned entries) {
+        io_uring_params params{};
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd < 0) {
+            throwErrno("io_uring_setup");
+        }
+        try {
+            map(params);
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    ~IoUring() { release(); }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // false se o kernel recusar (limite de memória travada, por exemplo)
+    bool registerBuffers(std::span<const iovec> buffers) {
+        return syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, buffers.data(),
+                       static_cast<unsigned>(buffers.size())) == 0;
+    }
+
+    // Próxima entrada livre da fila de submissão, zerada; nullptr se a fila estiver cheia
+    io_uring_sqe* prepare() {
+        unsigned head = std::atomic_ref<unsigned>(*sqHead).load(std::memory_order_acquire);
+        if (localTail - head >= sqEntries) {
+            return nullptr;
+        }
+        unsigned index = localTail & sqMask;
+        sqArray[index] = index;
+        io_uring_sqe* sqe = &sqes[index];
+        std::memset(sqe, 0, sizeof(*sqe));
+        ++localTail;
+        ++pending;
+        return sqe;
+    }
+
+    // Submete o que foi preparado e, com waitFor, espera essa quantidade de conclusões.
+    // Retorna a quantidade de chamadas de sistema feitas
+    unsigned submit(unsigned waitFor) {
+        std::atomic_ref<unsigned>(*sqTail).store(localTail, std::memory_order_release);
+        if (pending == 0 && waitFor == 0) {
+            return 0;
+        }
+        unsigned calls = 0;
+        while (true) {
+            long submitted = syscall(__NR_io_uring_enter, fd, pending, waitFor,
+                                     waitFor ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            ++calls;
+            if (submitted >= 0) {
+                pending -= std::min(pending, static_cast<unsigned>(submitted));
+                return calls;
+            }
+            if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+                throwErrno("io_uring_enter");
+            }
+        }
+    }
+
+    bool complete(io_uring_cqe& cqe) {
+        unsigned head = *cqHead;
+        if (head == std::atomic_ref<unsigned>(*cqTail).load(std::memory_order_acquire)) {
+            return false;
+        }
+        cqe = cqes[head & cqMask];
+        std::atomic_ref<unsigned>(*cqHead).store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    int fd = -1;
+    unsigned sqEntries = 0;
+    void* sqRing = nullptr;
+    size_t sqRingSize = 0;
+    void* cqRing = nullptr;
+    size_t cqRingSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned* sqArray = nullptr;
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    unsigned localTail = 0;
+    unsigned pending = 0;
+
+    void* mapRegion(size_t size, off_t offset) {
+        void* region = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        if (region == MAP_FAILED) {
+            throwErrno("mmap do io_uring");
+        }
+        return region;
+    }
+
+    void map(const io_uring_params& params) {
+        sqEntries = params.sq_entries;
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+        sqRing = mapRegion(sqRingSize, IORING_OFF_SQ_RING);
+        cqRing = single ? sqRing : mapRegion(cqRingSize, IORING_OFF_CQ_RING);
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mapRegion(sqesSize, IORING_OFF_SQES));
+
+        auto* sq = static_cast<uint8_t*>(sqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        localTail = *sqTail;
+
+        auto* cq = static_cast<uint8_t*>(cqRing);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    void release() {
+        if (sqes) munmap(sqes, sqesSize);
+        if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing) munmap(sqRing, sqRingSize);
+        if (fd >= 0) ::close(fd);
+        sqes = nullptr;
+        sqRing = cqRing = nullptr;
+        fd = -1;
+    }
+};
+
+namespace {
+void addStats(IoStats* stats, IoBackend backend, uint64_t bytes, uint64_t operations, uint64_t syscalls) {
+    if (stats) {
+        stats->backend = backend;
+        stats->bytes += bytes;
+        stats->operations += operations;
+        stats->syscalls += syscalls;
+    }
+}
+
+std::vector<uint8_t> readStream(const std::string& path, IoStats* stats) {
+    std::vector<uint8_t> data;
+    if (path == "-") {
+        data.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+    } else {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    addStats(stats, IoBackend::Stream, data.size(), 0, 0);
+    return data;
+}
+
+// Arquivo regular com read: o tamanho é conhecido, e o vetor é preenchido no lugar
+void readRegularPosix(int fd, size_t size, std::vector<uint8_t>& data, IoStats* stats) {
+    data.resize(size);
+    size_t done = 0;
+    uint64_t calls = 0;
+    while (done < size) {
+        ssize_t result = ::read(fd, data.data() + done, std::min(size - done, IO_BLOCK_SIZE));
+        ++calls;
+        if (result < 0) {
+            if (errno == EINTR) continue;
+            throwErrno("read");
+        }
+        if (result == 0) break;  // o arquivo encolheu
+        done += static_cast<size_t>(result);
+    }
+    data.resize(done);
+    addStats(stats, IoBackend::Posix, done, calls, calls);
+}
+
+// Pipe ou socket: leitura sem bloqueio, esperando dados com epoll
+void readStreamingPosix(int fd, std::vector<uint8_t>& data, IoStats* stats) {
+    int flags = fcntl(fd, F_GETFL);
+    bool restore = flags >= 0 && !(flags & O_NONBLOCK) && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+    int epoll = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll < 0) {
+        throwErrno("epoll_create1");
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, fd, &event);
+
+    uint64_t calls = 0;
+    uint64_t reads = 0;
+    try {
+        while (true) {
+            size_t size = data.size();
+            data.resize(size + IO_BLOCK_SIZE);
+            ssize_t result = ::read(fd, data.data() + size, IO_BLOCK_SIZE);
+            ++calls;
+            data.resize(size + static_cast<size_t>(std::max<ssize_t>(result, 0)));
+            if (result > 0) {
+                ++reads;
+                continue;
+            }
+            if (result == 0) break;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                epoll_event ready{};
+                epoll_wait(epoll, &ready, 1, -1);
+                ++calls;
+            } else if (errno != EINTR) {
+                throwErrno("read");
+            }
+        }
+    } catch (...) {
+        ::close(epoll);
+        if (restore) fcntl(fd, F_SETFL, flags);
+        throw;
+    }
+    ::close(epoll);
+    if (restore) fcntl(fd, F_SETFL, flags);
+    addStats(stats, IoBackend::Posix, data.size(), reads, calls);
+}
+
+// Arquivo regular com io_uring: até IO_BLOCK_COUNT blocos em voo, cada um em um buffer
+// registrado e copiado para o vetor ao concluir. Sem buffers registrados, as leituras vão
+// direto para o vetor
+void readRegularUring(int fd, size_t size, std::vector<uint8_t>& data, IoStats* stats) {
+    IoUring ring(QUEUE_DEPTH);
+    std::vector<uint8_t> buffer(IO_BLOCK_SIZE * IO_BLOCK_COUNT);
+    std::vector<iovec> iovecs(IO_BLOCK_COUNT);
+    for (unsigned i = 0; i < IO_BLOCK_COUNT; ++i) {
+        iovecs[i] = iovec{buffer.data() + i * IO_BLOCK_SIZE, IO_BLOCK_SIZE};
+    }
+    bool fixed = ring.registerBuffers(iovecs);
+
+    struct Block {
+        uint64_t offset = 0;
+        size_t length = 0;
+        size_t done = 0;
+        bool busy = false;
+    };
+    std::vector<Block> blocks(IO_BLOCK_COUNT);
+    data.resize(size);
+    uint64_t next = 0;
+    uint64_t end = size;  // menor se o arquivo encolher durante a leitura
+    unsigned inflight = 0;
+    uint64_t operations = 0;
+    uint64_t calls = 0;
+
+    auto queue = [&](unsigned index) {
+        Block& block = blocks[index];
+        io_uring_sqe* sqe = ring.prepare();
+        sqe->fd = fd;
+        sqe->off = block.offset + block.done;
+        sqe->len = static_cast<uint32_t>(block.length - block.done);
+        sqe->user_data = index;
+        if (fixed) {
+            sqe->opcode = IORING_OP_READ_FIXED;
+            sqe->addr = reinterpret_cast<uint64_t>(buffer.data() + index * IO_BLOCK_SIZE + block.done);
+            sqe->buf_index = static_cast<uint16_t>(index);
+        } else {
+            sqe->opcode = IORING_OP_READ;
+            sqe->addr = reinterpret_cast<uint64_t>(data.data() + block.offset + block.done);
+        }
+        ++operations;
+    };
+
+    while (next < end || inflight > 0) {
+        for (unsigned i = 0; i < IO_BLOCK_COUNT && next < end; ++i) {
+            if (blocks[i].busy) continue;
+            blocks[i] = Block{next, static_cast<size_t>(std::min<uint64_t>(IO_BLOCK_SIZE, end - next)), 0, true};
+            next += blocks[i].length;
+            queue(i);
+            ++inflight;
+        }
+        calls += ring.submit(1);
+
+        io_uring_cqe cqe{};
+        while (ring.complete(cqe)) {
+            unsigned index = static_cast<unsigned>(cqe.user_data);
+            Block& block = blocks[index];
+            if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+                queue(index);
+                continue;
+            }
+            if (cqe.res < 0) {
+                throwErrno("leitura pelo io_uring", -cqe.res);
+            }
+            block.done += static_cast<size_t>(cqe.res);
+            if (cqe.res > 0 && block.done < block.length) {
+                queue(index);
+                continue;
+            }
+            if (block.done < block.length) {
+                end = std::min<uint64_t>(end, block.offset + block.done);
+                next = std::min(next, end);
+            }
+            if (fixed) {
+                std::memcpy(data.data() + block.offset, buffer.data() + index * IO_BLOCK_SIZE, block.done);
+            }
+            block.busy = false;
+            --inflight;
+        }
+    }
+    data.resize(end);
+    addStats(stats, IoBackend::Uring, end, operations, calls);
+}
+
+// Pipe ou socket com io_uring: uma leitura em voo por vez, na posição corrente, para
+// manter a ordem dos dados
+void readStreamingUring(int fd, std::vector<uint8_t>& data, IoStats* stats) {
+    IoUring ring(2);
+    std::vector<uint8_t> buffer(IO_BLOCK_SIZE);
+    iovec iov{buffer.data(), IO_BLOCK_SIZE};
+    bool fixed = ring.registerBuffers(std::span<const iovec>(&iov, 1));
+    uint64_t operations = 0;
+    uint64_t calls = 0;
+
+    while (true) {
+        io_uring_sqe* sqe = ring.prepare();
+        sqe->opcode = fixed ? IORING_OP_READ_FIXED : IORING_OP_READ;
+        sqe->fd = fd;
+        sqe->off = static_cast<uint64_t>(-1);
+        sqe->addr = reinterpret_cast<uint64_t>(buffer.data());
+        sqe->len = static_cast<uint32_t>(IO_BLOCK_SIZE);
+        ++operations;
+        calls += ring.submit(1);
+
+        io_uring_cqe cqe{};
+        while (!ring.complete(cqe)) {
+            calls += ring.submit(1);
+        }
+        if (cqe.res == -EINTR || cqe.res == -EAGAIN) continue;
+        if (cqe.res < 0) {
+            throwErrno("leitura pelo io_uring", -cqe.res);
+        }
+        if (cqe.res == 0) break;
+        data.insert(data.end(), buffer.begin(), buffer.begin() + cqe.res);
+    }
+    addStats(stats, IoBackend::Uring, data.size(), operations, calls);
+}
+}
+
+IoBackend parseIoBackend(const std::string& text) {
+    if (text == "stream") return IoBackend::Stream;
+    if (text == "posix") return IoBackend::Posix;
+    if (text == "uring") return IoBackend::Uring;
+    throw std::runtime_error("backend de E/S desconhecido: " + text + " (use stream, posix ou uring)");
+}
+
+const char* ioBackendName(IoBackend backend) {
+    switch (backend) {
+        case IoBackend::Stream: return "stream";
+        case IoBackend::Posix: return "posix";
+        case IoBackend::Uring: return "uring";
+    }
+    return "?";
+}
+
+bool uringAvailable() {
+    static const bool available = []() {
+        try {
+            IoUring ring(2);
+            return true;
+        } catch (const std::runtime_error&) {
+            return false;
+        }
+    }();
+    return available;
+}
+
+std::vector<uint8_t> readInput(const std::string& path, IoBackend backend, IoStats* stats) {
+    backend = effectiveBackend(backend);
+    if (backend == IoBackend::Stream) {
+        return readStream(path, stats);
+    }
+
+    bool standardInput = path == "-";
+    int fd = standardInput ? STDIN_FILENO : ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+    std::vector<uint8_t> data;
+    try {
+        struct stat info {};
+        if (fstat(fd, &info) != 0) {
+            throwErrno("fstat " + path);
+        }
+        bool regular = S_ISREG(info.st_mode);
+        if (regular && standardInput) {
+            // Entrada padrão redirecionada de um arquivo: lê a partir da posição atual
+            off_t position = lseek(fd, 0, SEEK_CUR);
+            regular = position == 0;
+        }
+        if (backend == IoBackend::Uring) {
+            regular ? readRegularUring(fd, static_cast<size_t>(info.st_size), data, stats)
+                    : readStreamingUring(fd, data, stats);
+        } else {
+            regular ? readRegularPosix(fd, static_cast<size_t>(info.st_size), data, stats)
+                    : readStreamingPosix(fd, data, stats);
+        }
+    } catch (...) {
+        if (!standardInput) ::close(fd);
+        throw;
+    }
+    if (!standardInput) ::close(fd);
+    return data;
+}
+
+OutputFile::OutputFile(const std::string& path, IoBackend backend) : path(path) {
+    counters.backend = effectiveBackend(backend);
+    if (counters.backend == IoBackend::Stream) {
+        stream.open(path, std::ios::binary);
+        if (!stream) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+        return;
+    }
+
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+    struct stat info {};
+    seekable = fstat(fd, &info) == 0 && S_ISREG(info.st_mode);
+
+    if (counters.backend == IoBackend::Uring) {
+        ring = std::make_unique<IoUring>(QUEUE_DEPTH);
+        buffer.resize(IO_BLOCK_SIZE * IO_BLOCK_COUNT);
+        slots.resize(IO_BLOCK_COUNT);
+        std::vector<iovec> iovecs(IO_BLOCK_COUNT);
+        for (unsigned i = 0; i < IO_BLOCK_COUNT; ++i) {
+            iovecs[i] = iovec{slotData(i), IO_BLOCK_SIZE};
+        }
+        fixedBuffers = ring->registerBuffers(iovecs);
+    } else {
+        buffer.resize(IO_BLOCK_SIZE);
+        slots.resize(1);
+    }
+}
+
+OutputFile::~OutputFile() {
+    try {
+        flush();
+    } catch (const std::exception& error) {
+        std::cerr << "Failed to write file " << path << ": " << error.what() << std::endl;
+    }
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+size_t OutputFile::blockSize() const {
+    return IO_BLOCK_SIZE;
+}
+
+void OutputFile::write(std::span<const uint8_t> data) {
+    counters.bytes += data.size();
+    if (counters.backend == IoBackend::Stream) {
+        stream.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        return;
+    }
+    while (!data.empty()) {
+        if (current < 0) {
+            takeSlot();
+        }
+        size_t count = std::min(data.size(), IO_BLOCK_SIZE - fill);
+        std::memcpy(slotData(static_cast<size_t>(current)) + fill, data.data(), count);
+        fill += count;
+        data = data.subspan(count);
+        if (fill == IO_BLOCK_SIZE) {
+            queueSlot(static_cast<size_t>(current));
+        }
+    }
+}
+
+void OutputFile::flush() {
+    if (counters.backend == IoBackend::Stream) {
+        stream.flush();
+        return;
+    }
+    if (current >= 0 && fill > 0) {
+        queueSlot(static_cast<size_t>(current));
+    }
+    if (ring) {
+        while (inflight > 0 || queued > 0) {
+            reap(1);
+        }
+    }
+}
+
+void OutputFile::takeSlot() {
+    while (true) {
+        for (size_t i = 0; i < slots.size(); ++i) {
+            if (!slots[i].busy) {
+                current = static_cast<int>(i);
+                fill = 0;
+                return;
+            }
+        }
+        reap(1);  // todos os blocos em voo: espera o primeiro concluir
+    }
+}
+
+void OutputFile::queueSlot(size_t slot) {
+    slots[slot] = Slot{fileOffset, fill, 0, true};
+    fileOffset += fill;
+    current = -1;
+    fill = 0;
+
+    if (!ring) {
+        writeAll(slotData(slot), slots[slot].length);
+        slots[slot].busy = false;
+        return;
+    }
+    prepareWrite(slot);
+    ++inflight;
+    // Fora de arquivos regulares a posição é a corrente, então só um bloco fica em voo
+    if (!seekable) {
+        while (inflight > 0) reap(1);
+    } else if (queued >= WRITE_BATCH) {
+        reap(0);
+    }
+}
+
+void OutputFile::prepareWrite(size_t slot) {
+    Slot& state = slots[slot];
+    io_uring_sqe* sqe = ring->prepare();
+    sqe->fd = fd;
+    sqe->off = seekable ? state.offset + state.done : static_cast<uint64_t>(-1);
+    sqe->addr = reinterpret_cast<uint64_t>(slotData(slot) + state.done);
+    sqe->len = static_cast<uint32_t>(state.length - state.done);
+    sqe->user_data = slot;
+    if (fixedBuffers) {
+        sqe->opcode = IORING_OP_WRITE_FIXED;
+        sqe->buf_index = static_cast<uint16_t>(slot);
+    } else {
+        sqe->opcode = IORING_OP_WRITE;
+    }
+    ++queued;
+    ++counters.operations;
+}
+
+void OutputFile::reap(unsigned waitFor) {
+    counters.syscalls += ring->submit(waitFor);
+    queued = 0;
+
+    io_uring_cqe cqe{};
+    while (ring->complete(cqe)) {
+        size_t slot = static_cast<size_t>(cqe.user_data);
+        Slot& state = slots[slot];
+        if (cqe.res == -EINTR || cqe.res == -EAGAIN) {
+            prepareWrite(slot);
+            continue;
+        }
+        if (cqe.res <= 0) {
+            throwErrno("escrita pelo io_uring em " + path, cqe.res < 0 ? -cqe.res : EIO);
+        }
+        state.done += static_cast<size_t>(cqe.res);
+        if (state.done < state.length) {
+            prepareWrite(slot);  // escrita parcial: o resto volta para a fila
+            continue;
+        }
+        state.busy = false;
+        --inflight;
+    }
+}
+
+void OutputFile::writeAll(const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(fd, data, size);
+        ++counters.syscalls;
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throwErrno("write " + path);
+        }
+        ++counters.operations;
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+void writeOutput(const std::string& path, std::span<const uint8_t> data, IoBackend backend) {
+    OutputFile file(path, backend);
+    file.write(data);
+    file.flush();
+}
@@ -0,0 +1,102 @@
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*
+    * Backends de E/S para o fluxo de instruções lido pelo gerenciador e para os arquivos
+    * gravados por ele e pelo emulador:
+    *
+    *   - Stream: iostreams, o caminho original
+    *   - Posix:  read/write direto no descritor, com buffer próprio. Entradas que não são
+    *             arquivos regulares (pipes, sockets) são lidas sem bloquear, esperando com epoll
+    *   - Uring:  io_uring pelas chamadas de sistema (sem liburing). Vários blocos ficam em voo
+    *             ao mesmo tempo, em buffers registrados no kernel (READ_FIXED/WRITE_FIXED), e
+    *             cada io_uring_enter submete o lote de operações acumulado. Se o kernel não
+    *             oferecer io_uring, ou se ele estiver desativado, o Posix é usado no lugar
+*/
+
+enum class IoBackend : uint8_t { Stream, Posix, Uring };
+
+// "stream", "posix" ou "uring"; lança std::runtime_error para outros valores
+IoBackend parseIoBackend(const std::string& text);
+const char* ioBackendName(IoBackend backend);
+
+// Se io_uring pode ser usado neste processo (testado uma vez)
+bool uringAvailable();
+
+struct IoStats {
+    IoBackend backend = IoBackend::Stream;  // o backend efetivamente usado
+    uint64_t bytes = 0;
+    uint64_t operations = 0;   // leituras ou escritas de bloco
+    uint64_t syscalls = 0;     // read/write ou io_uring_enter
+};
+
+// Lê o arquivo inteiro; "-" é a entrada padrão
+std::vector<uint8_t> readInput(const std::string& path, IoBackend backend = IoBackend::Stream,
+                               IoStats* stats = nullptr);
+
+class IoUring;
+
+// Arquivo de saída, truncado na abertura. write só copia para os buffers; os blocos
+// cheios são gravados em lote, e flush (ou o destrutor) espera a gravação de todos
+class OutputFile {
+public:
+    explicit OutputFile(const std::string& path, IoBackend backend = IoBackend::Stream);
+    ~OutputFile();
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    void write(std::span<const uint8_t> data);
+    void write(std::string_view data) {
+        write(std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(data.data()), data.size()));
+    }
+    void flush();
+
+    const IoStats& stats() const { return counters; }
+
+private:
+    struct Slot {
+        uint64_t offset = 0;
+        size_t length = 0;
+        size_t done = 0;
+        bool busy = false;
+    };
+
+    std::string path;
+    IoStats counters;
+    std::ofstream stream;
+    int fd = -1;
+    bool seekable = true;
+
+    // Posix e Uring: blocos de buffer, um por operação em voo (só um no Posix)
+    std::vector<uint8_t> buffer;
+    std::vector<Slot> slots;
+    int current = -1;   // bloco sendo preenchido
+    size_t fill = 0;
+    uint64_t fileOffset = 0;
+
+    std::unique_ptr<IoUring> ring;
+    bool fixedBuffers = false;
+    unsigned queued = 0;    // preparadas e ainda não submetidas
+    unsigned inflight = 0;
+
+    uint8_t* slotData(size_t slot) { return buffer.data() + slot * blockSize(); }
+    size_t blockSize() const;
+    void takeSlot();
+    void queueSlot(size_t slot);
+    void prepareWrite(size_t slot);
+    void reap(unsigned waitFor);
+    void writeAll(const uint8_t* data, size_t size);
+};
+
+// Grava data em path de uma vez, substituindo o conteúdo
+void writeOutput(const std::string& path, std::span<const uint8_t> data, IoBackend backend = IoBackend::Stream);
+
+#endif
@@ -0,0 +1,389 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <cstring>
+#include <cstdint>
+#include "include/json.hpp"
+#include "Loader.hpp"
+#include "Marshal.hpp"
+
+namespace {
+// Constante do JSON sem representação em Value, para CodeIdentifiers::literals
+ConstantLiteral jsonLiteral(const nlohmann::json& item) {
+    ConstantLiteral literal;
+    if (item.is_string()) {
+        literal.kind = ConstantLiteral::Kind::Str;
+        literal.text = item.get<std::string>();
+    } else if (item.is_boolean()) {
+        literal.kind = ConstantLiteral::Kind::Bool;
+        literal.integer = item.get<bool>();
+    } else if (item.is_number_unsigned() && item.get<uint64_t>() > static_cast<uint64_t>(INT64_MAX)) {
+        literal.kind = ConstantLiteral::Kind::Unsupported;
+        literal.text = "inteiro fora de 64 bits";
+    } else if (item.is_number_integer()) {
+        literal.kind = ConstantLiteral::Kind::Int;
+        literal.integer = item.get<int64_t>();
+    } else if (item.is_number_float()) {
+        literal.kind = ConstantLiteral::Kind::Float;
+        literal.real = item.get<double>();
+    } else if (item.is_array()) {
+        literal.kind = ConstantLiteral::Kind::Tuple;
+        for (const auto& element : item) {
+            literal.items.push_back(jsonLiteral(element));
+        }
+    } else if (!item.is_null()) {
+        literal.kind = ConstantLiteral::Kind::Unsupported;
+        literal.text = "objeto JSON";
+    }
+    return literal;
+}
+
+bool jsonFitsInt32(const nlohmann::json& item) {
+    if (item.is_number_unsigned()) {
+        return item.get<uint64_t>() <= static_cast<uint64_t>(INT32_MAX);
+    }
+    return item.get<int64_t>() >= INT32_MIN && item.get<int64_t>() <= INT32_MAX;
+}
+
+// Converte uma constante do JSON. Arrays (tuplas) e inteiros fora de int32 não têm
+// representação em Value e viram null, como no leitor de .pyc, para que os índices de
+// LOAD_CONST continuem valendo; o valor fica em literals
+void appendJsonConst(std::vector<VarType>& consts, const nlohmann::json& item, CodeIdentifiers& identifiers) {
+    if (item.is_string()) {
+        consts.push_back(item.get<std::string>());
+    } else if (item.is_number_integer() && jsonFitsInt32(item)) {
+        consts.push_back(item.get<int>());
+    } else if (item.is_boolean()) {
+        consts.push_back(item.get<bool>());
+    } else if (item.is_null()) {
+        consts.push_back(nullptr);
+    } else if (item.is_number_float()) {
+        consts.push_back(item.get<float>());
+    } else {
+        identifiers.literals.emplace_back(static_cast<uint32_t>(consts.size()), jsonLiteral(item));
+        consts.push_back(nullptr);
+    }
+}
+
+std::vector<std::string> jsonNames(const nlohmann::json& names) {
+    std::vector<std::string> result;
+    for (const auto& name : names) {
+        result.push_back(name.is_string() ? name.get<std::string>() : std::string());
+    }
+    return result;
+}
+
+// Identificadores de um objeto-código do JSON; co_argcount é opcional (pyc_serializer.py
+// o grava a partir desta versão). Os literais vêm depois, com co_consts
+std::shared_ptr<CodeIdentifiers> jsonIdentifiers(const nlohmann::json& jsonData) {
+    auto identifiers = std::make_shared<CodeIdentifiers>();
+    identifiers->names = jsonNames(jsonData["co_names"]);
+    identifiers->varnames = jsonNames(jsonData["co_varnames"]);
+    identifiers->freevars = jsonNames(jsonData["co_freevars"]);
+    identifiers->cellvars = jsonNames(jsonData["co_cellvars"]);
+    if (jsonData.contains("co_argcount") && jsonData["co_argcount"].is_number_integer()) {
+        identifiers->argcount = jsonData["co_argcount"].get<int>();
+    }
+    return identifiers;
+}
+}
+
+// Função para ler o JSON e criar o objeto Code
+Code readCodeFromJson(const nlohmann::json& jsonData) {
+    Code codeObj;
+
+    codeObj.setCoCode(jsonData["co_code"].get<std::string>());
+
+    size_t namesSize = jsonData["co_names"].size();
+    size_t varnamesSize = jsonData["co_varnames"].size();
+    size_t freevarsSize = jsonData["co_freevars"].size();
+    size_t cellvarsSize = jsonData["co_cellvars"].size();
+
+    codeObj.setCoNames(std::vector<VarType>(namesSize, nullptr));
+    codeObj.setCoVarnames(std::vector<VarType>(varnamesSize, nullptr));
+    codeObj.setCoFreevars(std::vector<VarType>(freevarsSize, nullptr));
+    codeObj.setCoCellvars(std::vector<VarType>(cellvarsSize, nullptr));
+    auto identifiers = jsonIdentifiers(jsonData);
+
+    std::vector<VarType> consts;
+    for (const auto& item : jsonData["co_consts"]) {
+        if (item.is_object()) {
+            consts.push_back(codeObj.addChild(readCodeFromJson(item))); // Chamada recursiva
+        } else {
+            appendJsonConst(consts, item, *identifiers);
+        }
+    }
+    codeObj.setCoConsts(consts);
+    codeObj.identifiers = std::move(identifiers);
+
+    return codeObj;
+}
+
+namespace {
+// Percorre o texto JSON sem montar a árvore: só localiza os limites de cada valor,
+// para que objetos aninhados possam ser guardados como intervalos ainda não lidos
+class JsonScanner {
+public:
+    explicit JsonScanner(const std::string& text) : text(text) {}
+
+    size_t skipWhitespace(size_t pos) const {
+        while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r')) {
+            ++pos;
+        }
+        return pos;
+    }
+
+    // Retorna a posição logo após o valor que começa em pos
+    size_t skipValue(size_t pos) const {
+        pos = skipWhitespace(pos);
+        if (pos >= text.size()) {
+            throw std::runtime_error("JSON truncado");
+        }
+        char c = text[pos];
+        if (c == '"') {
+            return skipString(pos);
+        }
+        if (c == '{' || c == '[') {
+            size_t depth = 0;
+            while (pos < text.size()) {
+                c = text[pos];
+                if (c == '"') {
+                    pos = skipString(pos);
+                    continue;
+                }
+                if (c == '{' || c == '[') {
+                    ++depth;
+                } else if (c == '}' || c == ']') {
+                    if (--depth == 0) {
+                        return pos + 1;
+                    }
+                }
+                ++pos;
+            }
+            throw std::runtime_error("JSON truncado");
+        }
+        // Número, true, false ou null
+        while (pos < text.size() && text[pos] != ',' && text[pos] != '}' && text[pos] != ']' &&
+               text[pos] != ' ' && text[pos] != '\t' && text[pos] != '\n' && text[pos] != '\r') {
+            ++pos;
+        }
+        return pos;
+    }
+
+    // Chama fn(chave, início, fim) para cada membro do objeto que começa em pos
+    template <typename Fn>
+    void forEachMember(size_t pos, Fn&& fn) const {
+        pos = expect(skipWhitespace(pos), '{');
+        pos = skipWhitespace(pos);
+        if (pos < text.size() && text[pos] == '}') {
+            return;
+        }
+        while (true) {
+            pos = skipWhitespace(pos);
+            size_t keyEnd = skipString(pos);
+            std::string key = text.substr(pos + 1, keyEnd - pos - 2);
+            pos = expect(skipWhitespace(keyEnd), ':');
+            size_t valueBegin = skipWhitespace(pos);
+            size_t valueEnd = skipValue(valueBegin);
+            fn(key, valueBegin, valueEnd);
+            pos = skipWhitespace(valueEnd);
+            if (pos < text.size() && text[pos] == ',') {
+                ++pos;
+                continue;
+            }
+            expect(pos, '}');
+            return;
+        }
+    }
+
+    // Chama fn(início, fim) para cada elemento do array que começa em pos
+    template <typename Fn>
+    void forEachElement(size_t pos, Fn&& fn) const {
+        pos = expect(skipWhitespace(pos), '[');
+        pos = skipWhitespace(pos);
+        if (pos < text.size() && text[pos] == ']') {
+            return;
+        }
+        while (true) {
+            size_t valueBegin = skipWhitespace(pos);
+            size_t valueEnd = skipValue(valueBegin);
+            fn(valueBegin, valueEnd);
+            pos = skipWhitespace(valueEnd);
+            if (pos < text.size() && text[pos] == ',') {
+                ++pos;
+                continue;
+            }
+            expect(pos, ']');
+            return;
+        }
+    }
+
+private:
+    const std::string& text;
+
+    size_t skipString(size_t pos) const {
+        expect(pos, '"');
+        for (++pos; pos < text.size(); ++pos) {
+            if (text[pos] == '\\') {
+                ++pos;  // Pula o caractere escapado
+            } else if (text[pos] == '"') {
+                return pos + 1;
+            }
+        }
+        throw std::runtime_error("JSON truncado: string sem fechamento");
+    }
+
+    size_t expect(size_t pos, char c) const {
+        if (pos >= text.size() || text[pos] != c) {
+            throw std::runtime_error(std::string("JSON inválido: esperado '") + c + "' na posição " + std::to_string(pos));
+        }
+        return pos + 1;
+    }
+};
+
+// Preenche codeObj a partir do objeto JSON em text[begin]; objetos aninhados em co_consts
+// viram filhos com pendingLoad apontando para o próprio intervalo, lidos só quando chamados
+void fillCodeFromJsonRange(Code& codeObj, const std::shared_ptr<const std::string>& text, size_t begin) {
+    JsonScanner scanner(*text);
+    auto parseRange = [&](size_t valueBegin, size_t valueEnd) {
+        return nlohmann::json::parse(text->begin() + valueBegin, text->begin() + valueEnd);
+    };
+    // Tabelas com um null por nome; os nomes vão para CodeIdentifiers
+    auto identifiers = std::make_shared<CodeIdentifiers>();
+    auto readNames = [&](size_t valueBegin, size_t valueEnd, std::vector<std::string>& names) {
+        names = jsonNames(parseRange(valueBegin, valueEnd));
+        return std::vector<VarType>(names.size(), nullptr);
+    };
+
+    std::vector<VarType> consts;
+    scanner.forEachMember(begin, [&](const std::string& key, size_t valueBegin, size_t valueEnd) {
+        if (key == "co_code") {
+            codeObj.setCoCode(parseRange(valueBegin, valueEnd).get<std::string>());
+        } else if (key == "co_names") {
+            codeObj.setCoNames(readNames(valueBegin, valueEnd, identifiers->names));
+        } else if (key == "co_varnames") {
+            codeObj.setCoVarnames(readNames(valueBegin, valueEnd, identifiers->varnames));
+        } else if (key == "co_freevars") {
+            codeObj.setCoFreevars(readNames(valueBegin, valueEnd, identifiers->freevars));
+        } else if (key == "co_cellvars") {
+            codeObj.setCoCellvars(readNames(valueBegin, valueEnd, identifiers->cellvars));
+        } else if (key == "co_argcount") {
+            auto argcount = parseRange(valueBegin, valueEnd);
+            if (argcount.is_number_integer()) identifiers->argcount = argcount.get<int>();
+        } else if (key == "co_consts") {
+            scanner.forEachElement(valueBegin, [&](size_t itemBegin, size_t itemEnd) {
+                if ((*text)[itemBegin] == '{') {
+                    Code child;
+                    child.pendingLoad = std::make_unique<Code::PendingLoad>();
+                    child.pendingLoad->load = [text, itemBegin](Code& target) {
+                        fillCodeFromJsonRange(target, text, itemBegin);
+                    };
+                    consts.push_back(codeObj.addChild(std::move(child)));
+                } else {
+                    appendJsonConst(consts, parseRange(itemBegin, itemEnd), *identifiers);
+                }
+            });
+        }
+    });
+    codeObj.setCoConsts(consts);
+    codeObj.identifiers = std::move(identifiers);
+}
+}
+
+Code readCodeFromJsonLazy(std::shared_ptr<const std::string> text) {
+    Code codeObj;
+    fillCodeFromJsonRange(codeObj, text, 0);
+    return codeObj;
+}
+
+Code readCodeFromJsonFileLazy(const std::string& filename) {
+    std::ifstream inputFile(filename, std::ios::binary);
+    if (!inputFile.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+
+    // O texto fica vivo enquanto algum filho ainda não tiver sido materializado
+    auto text = std::make_shared<std::string>(std::istreambuf_iterator<char>(inputFile), std::istreambuf_iterator<char>());
+    return readCodeFromJsonLazy(std::move(text));
+}
+
+Code readCodeFromJsonFile(const std::string& filename) {
+    std::ifstream inputFile(filename);
+    nlohmann::json jsonData;
+
+    if (!inputFile.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+
+    inputFile >> jsonData;  // Lê o JSON do arquivo
+    return readCodeFromJson(jsonData); // Lê o primeiro Frame e retorna
+}
+
+Code readCodeFromFile(const std::string& filename, bool lazy) {
+    const std::string pycExtension = ".pyc";
+    if (filename.size() >= pycExtension.size() &&
+        filename.compare(filename.size() - pycExtension.size(), pycExtension.size(), pycExtension) == 0) {
+        return readCodeFromPyc(filename);
+    }
+    return lazy ? readCodeFromJsonFileLazy(filename) : readCodeFromJsonFile(filename);
+}
+
+std::string readPayloadFromFile(const std::string& filename) {
+    std::ifstream inputFile(filename, std::ios::binary);
+    if (!inputFile) {
+        throw std::runtime_error("Erro ao abrir o arquivo para leitura.");
+    }
+
+    // Move o ponteiro de leitura para o final do arquivo para obter o tamanho
+    inputFile.seekg(0, std::ios::end);
+    std::streamsize fileSize = inputFile.tellg();
+    inputFile.seekg(0, std::ios::beg);
+
+    // Lê o conteúdo do arquivo para uma string
+    std::string payload(fileSize, '\0');
+    if (!inputFile.read(&payload[0], fileSize)) {
+        throw std::runtime_error("Erro ao ler o conteúdo do arquivo.");
+    }
+
+    return payload;
+}
+
+size_t findRecordSeparator(std::span<const uint8_t> data, size_t from) {
+    while (from < data.size()) {
+        const void* found = std::memchr(data.data() + from, 0x03, data.size() - from);
+        if (!found) break;
+        size_t index = static_cast<const uint8_t*>(found) - data.data();
+        if (index + 1 < data.size() && data[index + 1] == 0x02) {
+            return index;
+        }
+        from = index + 1;
+    }
+    return data.size();
+}
+
+std::vector<std::vector<uint8_t>> splitByDelimiters(const std::vector<uint8_t>& data, uint8_t delimiter1, uint8_t delimiter2) {
+    std::vector<std::vector<uint8_t>> result;
+    std::vector<uint8_t> currentSegment;
+
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (i + 1 < data.size() && data[i] == delimiter1 && data[i + 1] == delimiter2) {
+            // Encontrei os delimitadores (0x03 seguido de 0x02), salvei o segmento atual
+            if (!currentSegment.empty()) {
+                result.push_back(currentSegment);
+                currentSegment.clear();
+            }
+            ++i; // Skip the second delimiter
+        } else {
+            currentSegment.push_back(data[i]);
+        }
+    }
+    // Adiciono o último segmento, se existir
+    if (!currentSegment.empty()) {
+        result.push_back(currentSegment);
+    }
+
+    return result;
+}
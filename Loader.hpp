@@ -0,0 +1,86 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <thread>
+#include <algorithm>
+#include "include/json.hpp"
+#include "Code.hpp"
+
+// Leitura do JSON gerado por pyc_serializer.py
+Code readCodeFromJson(const nlohmann::json& jsonData);
+Code readCodeFromJsonFile(const std::string& filename);
+
+// Carga preguiçosa: só o Code raiz é lido; cada função aninhada fica como um intervalo do
+// texto e é materializada na primeira vez que getCodeFromVariable a resolve
+Code readCodeFromJsonLazy(std::shared_ptr<const std::string> text);
+Code readCodeFromJsonFileLazy(const std::string& filename);
+
+// Escolhe o leitor pela extensão: .pyc é lido diretamente (ver Marshal.hpp), o resto como JSON.
+// lazy só vale para JSON; o marshal precisa ser lido em ordem por causa da tabela de referências
+Code readCodeFromFile(const std::string& filename, bool lazy = false);
+
+// Leitura e divisão do fluxo de instruções do mestre
+std::string readPayloadFromFile(const std::string& filename);
+std::vector<std::vector<uint8_t>> splitByDelimiters(const std::vector<uint8_t>& data, uint8_t delimiter1, uint8_t delimiter2);
+
+// Posição do próximo separador de registros (0x03 0x02) a partir de from, ou data.size().
+// Como 0x03 nunca é o segundo byte de um separador, todo par 0x03 0x02 é um separador, e
+// a busca pode começar em qualquer ponto do fluxo com o mesmo corte de splitByDelimiters
+size_t findRecordSeparator(std::span<const uint8_t> data, size_t from);
+
+// Chama visit(offset, length) para cada registro não vazio que começa em [begin, end) de
+// data, na ordem. Fatias vizinhas cobrem cada registro uma única vez, o que permite
+// percorrer o fluxo em várias threads (ver Validation.hpp e TraceIndex.hpp)
+template <typename Visit>
+void forEachRecord(std::span<const uint8_t> data, size_t begin, size_t end, Visit visit) {
+    // Registros que começam na fatia: o início do fluxo ou o byte após um separador
+    size_t start = begin;
+    if (begin > 0) {
+        size_t separator = findRecordSeparator(data, begin - (begin < 2 ? begin : 2));
+        start = separator == data.size() ? data.size() : separator + 2;
+    }
+    while (start < end) {
+        size_t stop = findRecordSeparator(data, start);
+        if (stop > start) {
+            visit(start, stop - start);
+        }
+        if (stop == data.size()) break;
+        start = stop + 2;
+    }
+}
+
+// Menor fatia por thread: abaixo disso, criar a thread custa mais que percorrer a fatia
+const size_t MIN_SHARD_BYTES = 256 * 1024;
+
+// Divide data em fatias contíguas, uma por thread (threads 0: uma por núcleo), sem fatias
+// menores que MIN_SHARD_BYTES, e chama scan(shard, begin, end) para cada uma em paralelo,
+// a primeira na thread chamadora. Com forEachRecord, cada registro cai em uma só fatia.
+// Retorna os Shards na ordem do fluxo
+template <typename Shard, typename Scan>
+std::vector<Shard> forEachShard(std::span<const uint8_t> data, unsigned threads, Scan scan) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::clamp<size_t>(data.size() / MIN_SHARD_BYTES, 1, threads));
+
+    std::vector<Shard> shards(threads);
+    auto run = [&](unsigned i) {
+        scan(shards[i], data.size() * i / threads, data.size() * (i + 1) / threads);
+    };
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; ++i) {
+        workers.emplace_back(run, i);
+    }
+    run(0);
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    return shards;
+}
+
+#endif
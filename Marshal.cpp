@@ -0,0 +1,490 @@
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include "Marshal.hpp"
+
+namespace {
+
+// Números mágicos que marcam a mudança de layout do objeto-código
+const uint16_t MAGIC_PYTHON_37 = 3390;
+const uint16_t MAGIC_PYTHON_38 = 3400;
+const uint16_t MAGIC_PYTHON_311 = 3450;
+
+const size_t PYC_HEADER_SIZE = 16;
+const uint8_t FLAG_REF = 0x80;
+
+// Tipos de localspluskinds (Python 3.11+)
+const uint8_t CO_FAST_LOCAL = 0x20;
+const uint8_t CO_FAST_CELL = 0x40;
+const uint8_t CO_FAST_FREE = 0x80;
+
+struct PyObject;
+using PyRef = std::shared_ptr<PyObject>;
+
+struct PyCode {
+    std::string code;               // co_code em bytes
+    std::vector<PyRef> consts;
+    size_t namesCount = 0;
+    size_t varnamesCount = 0;
+    size_t freevarsCount = 0;
+    size_t cellvarsCount = 0;
+    CodeIdentifiers identifiers;
+};
+
+// Objeto marshal com apenas o que a conversão para Code precisa
+struct PyObject {
+    enum class Kind { None, Bool, Int, Float, Str, Bytes, Tuple, Code, Other };
+
+    Kind kind = Kind::None;
+    bool boolean = false;
+    int64_t integer = 0;
+    bool fitsInt64 = true;
+    double real = 0.0;
+    std::string text;               // Str ou Bytes
+    std::vector<PyRef> items;       // Tuple, lista e conjuntos
+    std::shared_ptr<PyCode> code;
+};
+
+class MarshalReader {
+public:
+    MarshalReader(const std::string& data, uint16_t magicNumber) : data(data), magic(magicNumber) {}
+
+    PyRef readObject();
+
+private:
+    const std::string& data;
+    size_t pos = 0;
+    uint16_t magic;
+    std::vector<PyRef> refs;
+
+    uint8_t readByte() {
+        if (pos >= data.size()) {
+            throw std::runtime_error("Fluxo marshal truncado");
+        }
+        return static_cast<uint8_t>(data[pos++]);
+    }
+
+    int32_t readInt32() {
+        if (pos + 4 > data.size()) {
+            throw std::runtime_error("Fluxo marshal truncado");
+        }
+        uint32_t value = static_cast<uint8_t>(data[pos])
+                       | static_cast<uint32_t>(static_cast<uint8_t>(data[pos + 1])) << 8
+                       | static_cast<uint32_t>(static_cast<uint8_t>(data[pos + 2])) << 16
+                       | static_cast<uint32_t>(static_cast<uint8_t>(data[pos + 3])) << 24;
+        pos += 4;
+        return static_cast<int32_t>(value);
+    }
+
+    std::string readBytes(size_t size) {
+        if (pos + size > data.size()) {
+            throw std::runtime_error("Fluxo marshal truncado");
+        }
+        std::string bytes = data.substr(pos, size);
+        pos += size;
+        return bytes;
+    }
+
+    size_t readSize() {
+        int32_t size = readInt32();
+        if (size < 0) {
+            throw std::runtime_error("Tamanho negativo no fluxo marshal");
+        }
+        return static_cast<size_t>(size);
+    }
+
+    // Reserva a posição do objeto na tabela de referências antes de ler o conteúdo,
+    // pois objetos aninhados podem apontar para ele
+    size_t reserveRef(bool flagged) {
+        if (!flagged) return SIZE_MAX;
+        refs.push_back(nullptr);
+        return refs.size() - 1;
+    }
+
+    PyRef finish(PyRef object, size_t refIndex) {
+        if (refIndex != SIZE_MAX) refs[refIndex] = object;
+        return object;
+    }
+
+    PyRef readSequence(size_t count, size_t refIndex);
+    PyRef readCode(size_t refIndex);
+    std::vector<std::string> readNames();
+};
+
+PyRef makeObject(PyObject::Kind kind) {
+    auto object = std::make_shared<PyObject>();
+    object->kind = kind;
+    return object;
+}
+
+PyRef MarshalReader::readSequence(size_t count, size_t refIndex) {
+    PyRef tuple = makeObject(PyObject::Kind::Tuple);
+    finish(tuple, refIndex);
+    tuple->items.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        tuple->items.push_back(readObject());
+    }
+    return tuple;
+}
+
+// co_names e semelhantes: as tabelas do Code só usam a quantidade; os nomes vão para
+// CodeIdentifiers
+std::vector<std::string> MarshalReader::readNames() {
+    PyRef names = readObject();
+    if (!names || names->kind != PyObject::Kind::Tuple) {
+        throw std::runtime_error("Tabela de nomes inválida no objeto-código");
+    }
+    std::vector<std::string> result;
+    result.reserve(names->items.size());
+    for (const PyRef& name : names->items) {
+        result.push_back(name && name->kind == PyObject::Kind::Str ? name->text : std::string());
+    }
+    return result;
+}
+
+PyRef MarshalReader::readCode(size_t refIndex) {
+    PyRef object = makeObject(PyObject::Kind::Code);
+    finish(object, refIndex);
+    auto code = std::make_shared<PyCode>();
+    object->code = code;
+
+    code->identifiers.argcount = readInt32();
+    if (magic >= MAGIC_PYTHON_38) readInt32();  // posonlyargcount
+    readInt32();                                // kwonlyargcount
+    if (magic < MAGIC_PYTHON_311) readInt32();  // nlocals
+    readInt32();                                // stacksize
+    readInt32();                                // flags
+
+    PyRef bytecode = readObject();
+    if (!bytecode || bytecode->kind != PyObject::Kind::Bytes) {
+        throw std::runtime_error("co_code inválido no objeto-código");
+    }
+    code->code = bytecode->text;
+
+    PyRef consts = readObject();
+    if (!consts || consts->kind != PyObject::Kind::Tuple) {
+        throw std::runtime_error("co_consts inválido no objeto-código");
+    }
+    code->consts = consts->items;
+    code->identifiers.names = readNames();
+    code->namesCount = code->identifiers.names.size();
+
+    if (magic >= MAGIC_PYTHON_311) {
+        PyRef localsNames = readObject();
+        PyRef localsKinds = readObject();
+        if (!localsNames || localsNames->kind != PyObject::Kind::Tuple ||
+            !localsKinds || localsKinds->kind != PyObject::Kind::Bytes ||
+            localsNames->items.size() != localsKinds->text.size()) {
+            throw std::runtime_error("localsplus inválido no objeto-código");
+        }
+        for (size_t i = 0; i < localsKinds->text.size(); ++i) {
+            uint8_t k = static_cast<uint8_t>(localsKinds->text[i]);
+            const PyRef& name = localsNames->items[i];
+            std::string text = name && name->kind == PyObject::Kind::Str ? name->text : std::string();
+            if (k & CO_FAST_LOCAL) {
+                ++code->varnamesCount;
+                code->identifiers.varnames.push_back(text);
+            }
+            if (k & CO_FAST_CELL) {
+                ++code->cellvarsCount;
+                code->identifiers.cellvars.push_back(text);
+            }
+            if (k & CO_FAST_FREE) {
+                ++code->freevarsCount;
+                code->identifiers.freevars.push_back(text);
+            }
+        }
+        readObject();   // filename
+        readObject();   // name
+        readObject();   // qualname
+        readInt32();    // firstlineno
+        readObject();   // linetable
+        readObject();   // exceptiontable
+    } else {
+        code->identifiers.varnames = readNames();
+        code->identifiers.freevars = readNames();
+        code->identifiers.cellvars = readNames();
+        code->varnamesCount = code->identifiers.varnames.size();
+        code->freevarsCount = code->identifiers.freevars.size();
+        code->cellvarsCount = code->identifiers.cellvars.size();
+        readObject();   // filename
+        readObject();   // name
+        readInt32();    // firstlineno
+        readObject();   // lnotab
+    }
+
+    return object;
+}
+
+PyRef MarshalReader::readObject() {
+    uint8_t byte = readByte();
+    bool flagged = (byte & FLAG_REF) != 0;
+    char type = static_cast<char>(byte & ~FLAG_REF);
+
+    switch (type) {
+        case '0':   // NULL: só aparece como terminador de dicionários
+            return nullptr;
+        case 'N':
+            return makeObject(PyObject::Kind::None);
+        case 'F':
+        case 'T': {
+            PyRef object = makeObject(PyObject::Kind::Bool);
+            object->boolean = (type == 'T');
+            return object;
+        }
+        case 'S':   // StopIteration
+        case '.':   // Ellipsis
+            return makeObject(PyObject::Kind::Other);
+        case 'i': {
+            size_t refIndex = reserveRef(flagged);
+            PyRef object = makeObject(PyObject::Kind::Int);
+            object->integer = readInt32();
+            return finish(object, refIndex);
+        }
+        case 'l': {
+            // Inteiro longo: dígitos de 15 bits, sinal no contador
+            size_t refIndex = reserveRef(flagged);
+            int32_t count = readInt32();
+            size_t digits = static_cast<size_t>(count < 0 ? -static_cast<int64_t>(count) : count);
+            PyRef object = makeObject(PyObject::Kind::Int);
+            uint64_t magnitude = 0;
+            bool overflow = false;
+            for (size_t i = 0; i < digits; ++i) {
+                uint32_t low = readByte();
+                uint32_t digit = low | static_cast<uint32_t>(readByte()) << 8;
+                size_t shift = 15 * i;
+                if (shift >= 64 || (shift > 49 && (digit >> (64 - shift)) != 0)) {
+                    overflow = overflow || digit != 0;
+                } else {
+                    magnitude |= static_cast<uint64_t>(digit) << shift;
+                }
+            }
+            const uint64_t limit = static_cast<uint64_t>(INT64_MAX) + (count < 0 ? 1 : 0);
+            overflow = overflow || magnitude > limit;
+            if (overflow) {
+                object->fitsInt64 = false;
+            } else {
+                object->integer = count < 0 ? static_cast<int64_t>(0 - magnitude) : static_cast<int64_t>(magnitude);
+            }
+            return finish(object, refIndex);
+        }
+        case 'g': {
+            size_t refIndex = reserveRef(flagged);
+            std::string bytes = readBytes(8);
+            PyRef object = makeObject(PyObject::Kind::Float);
+            std::memcpy(&object->real, bytes.data(), sizeof(double));
+            return finish(object, refIndex);
+        }
+        case 'f': {
+            size_t refIndex = reserveRef(flagged);
+            PyRef object = makeObject(PyObject::Kind::Float);
+            object->real = std::stod(readBytes(readByte()));
+            return finish(object, refIndex);
+        }
+        case 'y':   // complexo binário
+        case 'x': { // complexo em texto
+            size_t refIndex = reserveRef(flagged);
+            if (type == 'y') {
+                readBytes(16);
+            } else {
+                readBytes(readByte());
+                readBytes(readByte());
+            }
+            return finish(makeObject(PyObject::Kind::Other), refIndex);
+        }
+        case 's': {
+            size_t refIndex = reserveRef(flagged);
+            PyRef object = makeObject(PyObject::Kind::Bytes);
+            object->text = readBytes(readSize());
+            return finish(object, refIndex);
+        }
+        case 't':
+        case 'u':
+        case 'a':
+        case 'A': {
+            size_t refIndex = reserveRef(flagged);
+            PyRef object = makeObject(PyObject::Kind::Str);
+            object->text = readBytes(readSize());
+            return finish(object, refIndex);
+        }
+        case 'z':
+        case 'Z': {
+            size_t refIndex = reserveRef(flagged);
+            PyRef object = makeObject(PyObject::Kind::Str);
+            object->text = readBytes(readByte());
+            return finish(object, refIndex);
+        }
+        case '(':
+        case '[':
+        case '<':
+        case '>': {
+            size_t refIndex = reserveRef(flagged);
+            return readSequence(readSize(), refIndex);
+        }
+        case ')': {
+            size_t refIndex = reserveRef(flagged);
+            return readSequence(readByte(), refIndex);
+        }
+        case '{': {
+            size_t refIndex = reserveRef(flagged);
+            PyRef dict = makeObject(PyObject::Kind::Other);
+            finish(dict, refIndex);
+            while (readObject()) {
+                readObject();
+            }
+            return dict;
+        }
+        case 'c':
+            return readCode(reserveRef(flagged));
+        case 'r': {
+            size_t index = readSize();
+            if (index >= refs.size() || !refs[index]) {
+                throw std::runtime_error("Referência inválida no fluxo marshal");
+            }
+            return refs[index];
+        }
+        default:
+            throw std::runtime_error(std::string("Tipo marshal desconhecido: ") + type);
+    }
+}
+
+std::string toHex(const std::string& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    hex.reserve(bytes.size() * 2);
+    for (unsigned char c : bytes) {
+        hex.push_back(digits[c >> 4]);
+        hex.push_back(digits[c & 0x0F]);
+    }
+    return hex;
+}
+
+// Constante sem representação em Value, para CodeIdentifiers::literals
+ConstantLiteral toLiteral(const PyRef& item) {
+    ConstantLiteral literal;
+    switch (item ? item->kind : PyObject::Kind::Other) {
+        case PyObject::Kind::None:
+            break;
+        case PyObject::Kind::Bool:
+            literal.kind = ConstantLiteral::Kind::Bool;
+            literal.integer = item->boolean;
+            break;
+        case PyObject::Kind::Int:
+            if (item->fitsInt64) {
+                literal.kind = ConstantLiteral::Kind::Int;
+                literal.integer = item->integer;
+            } else {
+                literal.kind = ConstantLiteral::Kind::Unsupported;
+                literal.text = "inteiro fora de 64 bits";
+            }
+            break;
+        case PyObject::Kind::Float:
+            literal.kind = ConstantLiteral::Kind::Float;
+            literal.real = item->real;
+            break;
+        case PyObject::Kind::Str:
+            literal.kind = ConstantLiteral::Kind::Str;
+            literal.text = item->text;
+            break;
+        case PyObject::Kind::Tuple:
+            literal.kind = ConstantLiteral::Kind::Tuple;
+            literal.items.reserve(item->items.size());
+            for (const PyRef& element : item->items) {
+                literal.items.push_back(toLiteral(element));
+            }
+            break;
+        case PyObject::Kind::Bytes:
+            literal.kind = ConstantLiteral::Kind::Unsupported;
+            literal.text = "bytes";
+            break;
+        default:
+            literal.kind = ConstantLiteral::Kind::Unsupported;
+            literal.text = item && item->kind == PyObject::Kind::Code ? "código dentro de tupla" : "objeto marshal";
+            break;
+    }
+    return literal;
+}
+
+// Converte o objeto-código lido do marshal no mesmo formato produzido por readCodeFromJson
+Code toCode(const PyCode& pyCode) {
+    Code codeObj(toHex(pyCode.code));
+
+    codeObj.setCoNames(std::vector<VarType>(pyCode.namesCount, nullptr));
+    codeObj.setCoVarnames(std::vector<VarType>(pyCode.varnamesCount, nullptr));
+    codeObj.setCoFreevars(std::vector<VarType>(pyCode.freevarsCount, nullptr));
+    codeObj.setCoCellvars(std::vector<VarType>(pyCode.cellvarsCount, nullptr));
+    auto identifiers = std::make_shared<CodeIdentifiers>(pyCode.identifiers);
+
+    std::vector<VarType> consts;
+    consts.reserve(pyCode.consts.size());
+    for (const PyRef& item : pyCode.consts) {
+        switch (item ? item->kind : PyObject::Kind::Other) {
+            case PyObject::Kind::None:
+                consts.emplace_back(nullptr);
+                break;
+            case PyObject::Kind::Bool:
+                consts.emplace_back(item->boolean);
+                break;
+            case PyObject::Kind::Float:
+                consts.emplace_back(static_cast<float>(item->real));
+                break;
+            case PyObject::Kind::Str:
+                consts.emplace_back(item->text);
+                break;
+            case PyObject::Kind::Code:
+                consts.push_back(codeObj.addChild(toCode(*item->code)));
+                break;
+            case PyObject::Kind::Int:
+                if (item->fitsInt64 && item->integer >= INT32_MIN && item->integer <= INT32_MAX) {
+                    consts.emplace_back(static_cast<int>(item->integer));
+                    break;
+                }
+                [[fallthrough]];
+            default:
+                // Sem representação em Value: None no lugar, e o valor nos identificadores
+                identifiers->literals.emplace_back(static_cast<uint32_t>(consts.size()), toLiteral(item));
+                consts.emplace_back(nullptr);
+                break;
+        }
+    }
+    codeObj.setCoConsts(consts);
+    codeObj.identifiers = std::move(identifiers);
+
+    return codeObj;
+}
+
+} // namespace
+
+Code readCodeFromMarshal(const std::string& data, uint16_t magicNumber) {
+    if (magicNumber < MAGIC_PYTHON_37) {
+        throw std::runtime_error("Versão de .pyc não suportada (requer Python 3.7+)");
+    }
+
+    MarshalReader reader(data, magicNumber);
+    PyRef object = reader.readObject();
+    if (!object || object->kind != PyObject::Kind::Code) {
+        throw std::runtime_error("O fluxo marshal não contém um objeto-código");
+    }
+    return toCode(*object->code);
+}
+
+Code readCodeFromPyc(const std::string& filename) {
+    std::ifstream inputFile(filename, std::ios::binary);
+    if (!inputFile.is_open()) {
+        throw std::runtime_error("Could not open file: " + filename);
+    }
+
+    std::string contents((std::istreambuf_iterator<char>(inputFile)), std::istreambuf_iterator<char>());
+    if (contents.size() < PYC_HEADER_SIZE || contents[2] != '\r' || contents[3] != '\n') {
+        throw std::runtime_error("Arquivo .pyc inválido: " + filename);
+    }
+
+    uint16_t magicNumber = static_cast<uint8_t>(contents[0]) | static_cast<uint16_t>(static_cast<uint8_t>(contents[1])) << 8;
+    return readCodeFromMarshal(contents.substr(PYC_HEADER_SIZE), magicNumber);
+}
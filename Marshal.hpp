@@ -0,0 +1,25 @@
+#ifndef MARSHAL_H
+#define MARSHAL_H
+
+#include <string>
+#include <cstdint>
+#include "Code.hpp"
+
+/*
+    * Leitura direta de módulos compilados (.pyc), sem processo Python nem JSON.
+    *
+    * Suporta o cabeçalho de 16 bytes do Python 3.7+ e os layouts de objeto-código
+    * do 3.7, do 3.8-3.10 e do 3.11+ (localsplusnames/localspluskinds). Constantes
+    * sem representação em Value (tuplas, bytes, complexos, inteiros fora de 32 bits,
+    * conjuntos) viram null, mantendo os índices de co_consts alinhados com o bytecode;
+    * o valor original fica em CodeIdentifiers::literals.
+*/
+
+// Lê um arquivo .pyc e retorna o objeto-código do módulo
+Code readCodeFromPyc(const std::string& filename);
+
+// Lê um fluxo marshal contendo um objeto-código. magicNumber identifica a versão
+// do Python que o gerou (dois primeiros bytes do .pyc, em little-endian)
+Code readCodeFromMarshal(const std::string& data, uint16_t magicNumber);
+
+#endif
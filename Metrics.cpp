@@ -0,0 +1,126 @@
+#include <cmath>
+#include <algorithm>
+#include <iomanip>
+#include "Metrics.hpp"
+#include "Dispatcher.hpp"
+
+size_t LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < SUB_BUCKETS) {
+        return static_cast<size_t>(value);  // Faixa linear para valores pequenos
+    }
+
+    // Potência de 2 do valor e os SUB_BUCKET_BITS bits seguintes ao bit mais alto
+    int magnitude = 63 - __builtin_clzll(value);
+    int shift = magnitude - SUB_BUCKET_BITS;
+    size_t sub = static_cast<size_t>(value >> shift) - SUB_BUCKETS;
+    return SUB_BUCKETS + static_cast<size_t>(shift) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index) {
+    if (index < static_cast<size_t>(SUB_BUCKETS)) {
+        return index;
+    }
+    size_t shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+    uint64_t sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    return ((SUB_BUCKETS + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    ++buckets[bucketIndex(value)];
+    ++total;
+    sum += value;
+    if (value < minValue) minValue = value;
+    if (value > maxValue) maxValue = value;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    if (total == 0) {
+        return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(std::ceil(p / 100.0 * total));
+    if (target == 0) target = 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        seen += buckets[i];
+        if (seen >= target) {
+            return std::min(bucketUpperBound(i), maxValue);
+        }
+    }
+    return maxValue;
+}
+
+void Metrics::recordInstruction(uint8_t instruction, Clock::duration elapsed) {
+    ++records;
+    ++counts[instruction];
+
+    if (!histograms[instruction]) {
+        histograms[instruction] = std::make_unique<LatencyHistogram>();
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+    histograms[instruction]->record(ns > 0 ? static_cast<uint64_t>(ns) : 0);
+}
+
+void Metrics::writeText(std::ostream& os) const {
+    os << "records: " << records
+       << "  bytes decoded: " << bytesDecoded
+       << "  bytes encoded: " << bytesEncoded << std::endl;
+    uint64_t lookups = callCacheHits + callCacheMisses;
+    os << "call cache: hits=" << callCacheHits << " misses=" << callCacheMisses
+       << " hit rate=" << (lookups ? 100.0 * callCacheHits / lookups : 0.0) << "%" << std::endl;
+    uint64_t prefetchCalls = prefetchHits + prefetchMisses;
+    if (prefetchCalls > 0) {
+        os << "prefetch: hits=" << prefetchHits << " misses=" << prefetchMisses
+           << " hit rate=" << 100.0 * prefetchHits / prefetchCalls << "%" << std::endl;
+    }
+
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (counts[i] == 0) continue;
+
+        os << "  0x" << std::hex << std::setfill('0') << std::setw(2) << i << std::dec
+           << " " << std::left << std::setfill(' ') << std::setw(14) << instructionName(static_cast<uint8_t>(i))
+           << std::right << " count=" << counts[i];
+
+        if (const LatencyHistogram* h = histograms[i].get()) {
+            os << " ns: min=" << h->min()
+               << " p50=" << h->percentile(50.0)
+               << " p99=" << h->percentile(99.0)
+               << " p999=" << h->percentile(99.9)
+               << " max=" << h->max();
+        }
+        os << std::endl;
+    }
+}
+
+void Metrics::writeJson(std::ostream& os) const {
+    os << "{\"records\":" << records
+       << ",\"bytes_decoded\":" << bytesDecoded
+       << ",\"bytes_encoded\":" << bytesEncoded
+       << ",\"call_cache\":{\"hits\":" << callCacheHits << ",\"misses\":" << callCacheMisses << "}"
+       << ",\"prefetch\":{\"hits\":" << prefetchHits << ",\"misses\":" << prefetchMisses << "}"
+       << ",\"instructions\":[";
+
+    bool first = true;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        if (counts[i] == 0) continue;
+
+        if (!first) os << ",";
+        first = false;
+
+        os << "{\"opcode\":" << i
+           << ",\"name\":\"" << instructionName(static_cast<uint8_t>(i)) << "\""
+           << ",\"count\":" << counts[i];
+
+        if (const LatencyHistogram* h = histograms[i].get()) {
+            os << ",\"latency_ns\":{\"min\":" << h->min()
+               << ",\"mean\":" << h->mean()
+               << ",\"p50\":" << h->percentile(50.0)
+               << ",\"p99\":" << h->percentile(99.0)
+               << ",\"p999\":" << h->percentile(99.9)
+               << ",\"max\":" << h->max() << "}";
+        }
+        os << "}";
+    }
+    os << "]}" << std::endl;
+}
@@ -0,0 +1,73 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <memory>
+#include <chrono>
+#include <ostream>
+#include <cstdint>
+
+// Histograma de latências no estilo HDR: escala log-linear com 16 sub-faixas por
+// potência de 2, o que limita o erro relativo de cada percentil a ~6%
+class LatencyHistogram {
+public:
+    static const int SUB_BUCKET_BITS = 4;
+    static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static const int BUCKET_COUNT = SUB_BUCKETS + (64 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    void record(uint64_t value);
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? minValue : 0; }
+    uint64_t max() const { return maxValue; }
+    double mean() const { return total ? static_cast<double>(sum) / total : 0.0; }
+
+    // Maior valor equivalente ao percentil pedido (0 < p <= 100)
+    uint64_t percentile(double p) const;
+
+private:
+    std::array<uint64_t, BUCKET_COUNT> buckets{};
+    uint64_t total = 0;
+    uint64_t sum = 0;
+    uint64_t minValue = UINT64_MAX;
+    uint64_t maxValue = 0;
+
+    static size_t bucketIndex(uint64_t value);
+    static uint64_t bucketUpperBound(size_t index);
+};
+
+// Contadores do laço de despacho: quantidade por instrução, bytes decodificados e
+// codificados e latência de cada instrução em nanossegundos
+class Metrics {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void recordInstruction(uint8_t instruction, Clock::duration elapsed);
+    void recordDecoded(size_t bytes) { bytesDecoded += bytes; }
+    void recordEncoded(size_t bytes) { bytesEncoded += bytes; }
+
+    // Resultado do cache de resolução de cada CALL_FUNCTION (ver FrameStack::resolveCall)
+    void recordCallCache(bool hit) { ++(hit ? callCacheHits : callCacheMisses); }
+
+    // Se o Code chamado já estava na fila de pré-busca da sessão (ver Prefetch.hpp)
+    void recordPrefetch(bool hit) { ++(hit ? prefetchHits : prefetchMisses); }
+
+    uint64_t instructionCount(uint8_t instruction) const { return counts[instruction]; }
+    const LatencyHistogram* latency(uint8_t instruction) const { return histograms[instruction].get(); }
+
+    void writeText(std::ostream& os) const;
+    void writeJson(std::ostream& os) const;
+
+private:
+    std::array<uint64_t, 256> counts{};
+    std::array<std::unique_ptr<LatencyHistogram>, 256> histograms;
+    uint64_t records = 0;
+    uint64_t bytesDecoded = 0;
+    uint64_t bytesEncoded = 0;
+    uint64_t callCacheHits = 0;
+    uint64_t callCacheMisses = 0;
+    uint64_t prefetchHits = 0;
+    uint64_t prefetchMisses = 0;
+};
+
+#endif
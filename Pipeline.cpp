@@ -0,0 +1,74 @@
+#include <exception>
+#include <string>
+#include <thread>
+#include "Pipeline.hpp"
+#include "Dispatcher.hpp"
+#include "Loader.hpp"
+
+namespace {
+// Mesmo corte de splitByDelimiters, com registros vazios descartados. false no fim de data
+bool nextSegment(std::span<const uint8_t> data, size_t& position, std::vector<uint8_t>& segment) {
+    while (position < data.size()) {
+        size_t start = position;
+        size_t end = findRecordSeparator(data, start);
+        position = end == data.size() ? end : end + 2;
+        if (end > start) {
+            segment.assign(data.begin() + start, data.begin() + end);
+            return true;
+        }
+    }
+    return false;
+}
+
+void decodeRecords(std::span<const uint8_t> data, const PayloadOptions& options, SpscQueue<DecodedRecord>& queue) {
+    DecodedRecord record;
+    size_t position = 0;
+    bool decoding = true;
+    while (nextSegment(data, position, record.segment)) {
+        const std::vector<uint8_t>& segment = record.segment;
+        record.decoded = false;
+        bool call = segment[0] == INSTR_CALL_FUNCTION || segment[0] == INSTR_CALL_FRAME;
+        if (decoding && call && segment.size() >= 4) {
+            try {
+                decodeFramePayload(std::string(segment.begin() + 4, segment.end()), record.payload, options);
+                record.decoded = true;
+            } catch (const std::exception&) {
+                // A sessão decodifica este e os próximos registros (ver Pipeline.hpp)
+                decoding = false;
+            }
+        }
+        if (!queue.push(record)) {
+            return;
+        }
+    }
+}
+}
+
+void runPipeline(std::span<const uint8_t> data, const PayloadOptions& options,
+                 const std::function<void(DecodedRecord&)>& apply, size_t depth) {
+    SpscQueue<DecodedRecord> queue(depth);
+    std::exception_ptr decodeError;
+    std::thread decoder([&]() {
+        try {
+            decodeRecords(data, options, queue);
+        } catch (...) {
+            decodeError = std::current_exception();
+        }
+        queue.close();
+    });
+
+    try {
+        DecodedRecord record;
+        while (queue.pop(record)) {
+            apply(record);
+        }
+    } catch (...) {
+        queue.cancel();
+        decoder.join();
+        throw;
+    }
+    decoder.join();
+    if (decodeError) {
+        std::rethrow_exception(decodeError);
+    }
+}
@@ -0,0 +1,129 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <vector>
+#include "Code.hpp"
+
+/*
+    * Processamento em duas etapas do fluxo de instruções do mestre:
+    *
+    *   - decodificação, em uma thread própria: separa o próximo registro nos 0x03 0x02 e
+    *     decodifica o payload dos CALL_FUNCTION/CALL_FRAME (decodeFramePayload)
+    *   - aplicação, na thread chamadora: empilha e desempilha frames e troca as tabelas
+    *     pelas já decodificadas (FrameStack::updateTop)
+    *
+    * Enquanto o registro N é aplicado, o N+1 já está sendo decodificado. As etapas trocam
+    * os registros por uma fila de um só produtor e um só consumidor sem travas; os
+    * registros voltam à fila depois de usados, e a memória dos vetores é reaproveitada.
+    *
+    * O resultado é o mesmo da execução em sequência: a thread de decodificação passa a ser
+    * a única usuária da tabela de símbolos de entrada da sessão. Se um payload não puder ser
+    * decodificado, o registro segue sem as tabelas e a sessão o decodifica de novo, lançando
+    * o mesmo erro no mesmo ponto; a partir dele, nenhum outro payload é decodificado fora
+*/
+
+// Registro em trânsito entre as etapas
+struct DecodedRecord {
+    std::vector<uint8_t> segment;   // instrução, argumentos e payload, como em splitByDelimiters
+    DecodedPayload payload;
+    bool decoded = false;           // payload preenchido (só CALL_FUNCTION e CALL_FRAME)
+
+    // Argumento decoded de Dispatcher::dispatch e FrameExecutor::dispatch
+    DecodedPayload* decodedPayload() { return decoded ? &payload : nullptr; }
+};
+
+// Fila circular de capacidade fixa entre um produtor e um consumidor, cada um em uma
+// única thread. push e pop trocam o conteúdo do item com o da posição da fila, então os
+// objetos nunca são copiados e cada lado recebe de volta um item já alocado. Quem encontra
+// a fila cheia ou vazia dorme com std::atomic::wait (futex no Linux) em um contador de
+// sinais, incrementado pelo outro lado a cada publicação, como em SharedRing
+template <typename T>
+class SpscQueue {
+public:
+    // capacity é arredondada para uma potência de 2
+    explicit SpscQueue(size_t capacity)
+        : items(std::bit_ceil(std::max<size_t>(capacity, 2))), mask(items.size() - 1) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Publica item, que volta com o conteúdo antigo da posição. false se a fila foi cancelada
+    bool push(T& item) {
+        uint32_t position = head.load(std::memory_order_relaxed);
+        while (true) {
+            uint32_t signal = spaceSignal.load(std::memory_order_acquire);
+            if (cancelled.load(std::memory_order_acquire)) return false;
+            if (position - tail.load(std::memory_order_acquire) < items.size()) break;
+            spaceSignal.wait(signal, std::memory_order_acquire);
+        }
+        std::swap(items[position & mask], item);
+        head.store(position + 1, std::memory_order_release);
+        dataSignal.fetch_add(1, std::memory_order_release);
+        dataSignal.notify_one();
+        return true;
+    }
+
+    // Retira o próximo item, deixando o conteúdo antigo de item na posição. false quando a
+    // fila foi fechada e esvaziada, ou cancelada
+    bool pop(T& item) {
+        uint32_t position = tail.load(std::memory_order_relaxed);
+        while (true) {
+            uint32_t signal = dataSignal.load(std::memory_order_acquire);
+            if (head.load(std::memory_order_acquire) != position) break;
+            if (closed.load(std::memory_order_acquire)) {
+                // O produtor pode ter publicado pouco antes de fechar
+                if (head.load(std::memory_order_acquire) == position) return false;
+                continue;
+            }
+            dataSignal.wait(signal, std::memory_order_acquire);
+        }
+        std::swap(items[position & mask], item);
+        tail.store(position + 1, std::memory_order_release);
+        spaceSignal.fetch_add(1, std::memory_order_release);
+        spaceSignal.notify_one();
+        return true;
+    }
+
+    // Fim do fluxo (produtor): pop devolve o que restar e depois false
+    void close() {
+        closed.store(true, std::memory_order_release);
+        dataSignal.fetch_add(1, std::memory_order_release);
+        dataSignal.notify_all();
+    }
+
+    // Abandono pelo consumidor: o produtor para no próximo push
+    void cancel() {
+        cancelled.store(true, std::memory_order_release);
+        spaceSignal.fetch_add(1, std::memory_order_release);
+        spaceSignal.notify_all();
+    }
+
+private:
+    std::vector<T> items;
+    size_t mask;
+
+    // Lado do produtor e lado do consumidor em linhas de cache separadas
+    alignas(64) std::atomic<uint32_t> head{0};        // próxima posição a publicar
+    std::atomic<uint32_t> dataSignal{0};
+    std::atomic<bool> closed{false};
+    alignas(64) std::atomic<uint32_t> tail{0};        // próxima posição a consumir
+    std::atomic<uint32_t> spaceSignal{0};
+    std::atomic<bool> cancelled{false};
+};
+
+// Registros em trânsito por padrão: suficiente para absorver variações de custo entre as etapas
+const size_t DEFAULT_PIPELINE_DEPTH = 64;
+
+// Decodifica data em uma thread própria, com as opções da sessão (decodeOptions()), e
+// chama apply para cada registro na thread chamadora, na ordem do fluxo. Uma exceção de
+// apply interrompe a decodificação e é propagada
+void runPipeline(std::span<const uint8_t> data, const PayloadOptions& options,
+                 const std::function<void(DecodedRecord&)>& apply, size_t depth = DEFAULT_PIPELINE_DEPTH);
+
+#endif
@@ -0,0 +1,93 @@
+#include <algorithm>
+#include "Prefetch.hpp"
+#include "Bytecode.hpp"
+
+std::vector<Code*> scanCallees(const Code& code) {
+    // Usa a forma pré-decodificada em cache ou, sem ela, decodifica só para a varredura
+    std::shared_ptr<const Bytecode> bytecode;
+    {
+        std::lock_guard<std::mutex> lock(*code.cacheLock);
+        bytecode = code.bytecode;
+    }
+    if (!bytecode) {
+        bytecode = std::make_shared<const Bytecode>(code.getCoCode(), false);
+    }
+
+    std::vector<Code*> result;
+    for (const Instruction& instr : bytecode->instructions()) {
+        if (unfusedOpcode(instr.opcode) == OP_LOAD_CONST && instr.arg < code.co_consts.size() &&
+            code.co_consts[instr.arg].isCode()) {
+            Code* callee = code.co_consts[instr.arg].asCode();
+            if (std::find(result.begin(), result.end(), callee) == result.end()) {
+                result.push_back(callee);
+            }
+        }
+    }
+    return result;
+}
+
+CalleeIndex::CalleeIndex(Code& root) {
+    predecodeBytecode(root);
+    std::vector<Code*> pending{&root};
+    while (!pending.empty()) {
+        Code* code = pending.back();
+        pending.pop_back();
+        code->materialize();
+
+        // Após deduplicateCodes um mesmo Code pode aparecer em vários pais
+        if (!callees.emplace(code, scanCallees(*code)).second) {
+            continue;
+        }
+        for (auto& child : code->children) {
+            pending.push_back(child.get());
+        }
+    }
+}
+
+std::span<Code* const> CalleeIndex::calleesOf(const Code& code) const {
+    auto it = callees.find(&code);
+    if (it == callees.end()) {
+        return {};
+    }
+    return it->second;
+}
+
+Prefetcher::Prefetcher(const CalleeIndex& index, PayloadCodec codec, size_t capacity)
+    : index(index), codec(codec), capacity(capacity) {}
+
+void Prefetcher::enter(Code& code) {
+    for (Code* callee : index.calleesOf(code)) {
+        if (std::find(queue.begin(), queue.end(), callee) != queue.end()) {
+            continue;
+        }
+        pending.push_back(callee);
+        queue.push_back(callee);
+        ++counters.prefetched;
+        if (queue.size() > capacity) {
+            queue.pop_front();
+        }
+    }
+}
+
+void Prefetcher::call(Code& callee) {
+    auto it = std::find(queue.begin(), queue.end(), &callee);
+    lastHit = it != queue.end();
+    if (lastHit) {
+        ++counters.hits;  // Continua na fila: o mesmo filho costuma ser chamado de novo
+    } else {
+        ++counters.misses;
+    }
+    enter(callee);
+}
+
+size_t Prefetcher::encodePending() {
+    size_t encoded = 0;
+    for (Code* callee : pending) {
+        if (!callee->hasPrecomputedPayload(codec)) {
+            callee->precomputePayload(codec);
+            ++encoded;
+        }
+    }
+    pending.clear();
+    return encoded;
+}
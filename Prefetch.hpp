@@ -0,0 +1,81 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include <cstdint>
+#include <deque>
+#include <span>
+#include <unordered_map>
+#include <vector>
+#include "Code.hpp"
+
+/*
+    * Pré-busca especulativa de frames filhos. O co_code de cada frame já diz quais Codes
+    * aninhados ele pode criar (LOAD_CONST de um Code seguido de MAKE_FUNCTION) e, portanto,
+    * chamar. A varredura é feita uma vez na carga; quando um frame é empilhado, os seus
+    * possíveis filhos entram na fila, e o co_code e o co_consts deles são codificados
+    * depois, por encodePending, de modo que a resposta à chamada seguinte só precise
+    * intercalar as tabelas da ativação.
+    *
+    * A codificação não fica no caminho da chamada: o laço da sessão chama encodePending
+    * depois de enviar a resposta do registro, no tempo em que o mestre a processa e
+    * prepara o registro seguinte (com --shm, o mestre trabalha em paralelo nesse meio-tempo).
+    *
+    * O bytecode é lido no formato de palavras do CPython 3.6+ (opcode e argumento de um
+    * byte, com EXTENDED_ARG), o mesmo aceito pelo leitor de marshal.
+*/
+
+// Codes aninhados que o co_code de code pode carregar, na ordem da primeira ocorrência
+std::vector<Code*> scanCallees(const Code& code);
+
+// Possíveis filhos de cada frame da árvore, calculados na construção. Toda a árvore é
+// materializada, como em CodeTable
+class CalleeIndex {
+public:
+    explicit CalleeIndex(Code& root);
+
+    std::span<Code* const> calleesOf(const Code& code) const;
+    size_t size() const { return callees.size(); }
+
+private:
+    std::unordered_map<const Code*, std::vector<Code*>> callees;
+};
+
+struct PrefetchStats {
+    uint64_t prefetched = 0;  // Codes colocados na fila
+    uint64_t hits = 0;        // chamadas a um Code que estava na fila
+    uint64_t misses = 0;
+};
+
+// Fila de pré-busca de uma sessão. O Prefetcher não deve ser usado fora da thread da
+// sessão; os Codes são compartilhados entre as sessões que usam o mesmo índice, e os blocos
+// codificados por encodePending são trocados sob a trava de cada Code (Code::cacheLock)
+class Prefetcher {
+public:
+    explicit Prefetcher(const CalleeIndex& index, PayloadCodec codec = PayloadCodec::V1, size_t capacity = 32);
+
+    // Frame empilhado (ou o raiz, no INIT): enfileira seus possíveis filhos, que ficam
+    // pendentes de codificação
+    void enter(Code& code);
+
+    // Chamada resolvida para callee: conta acerto ou falha da fila e entra no frame. Os
+    // Codes só saem da fila, em ordem de chegada, quando ela passa de capacity
+    void call(Code& callee);
+
+    // Pré-codifica os Codes enfileirados desde a última chamada; fora do caminho da
+    // resposta. Retorna quantos foram codificados
+    size_t encodePending();
+
+    const PrefetchStats& stats() const { return counters; }
+    bool lastCallHit() const { return lastHit; }
+
+private:
+    const CalleeIndex& index;
+    PayloadCodec codec;
+    size_t capacity;
+    std::deque<Code*> queue;
+    std::vector<Code*> pending;
+    PrefetchStats counters;
+    bool lastHit = false;
+};
+
+#endif
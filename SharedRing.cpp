@@ -0,0 +1,339 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#include "SharedRing.hpp"
+
+// Controle de um anel, na memória compartilhada. Produtor e consumidor escrevem em linhas
+// de cache diferentes
+struct RingControl {
+    alignas(64) std::atomic<uint64_t> head{0};   // bytes publicados pelo produtor
+    std::atomic<uint32_t> dataSignal{0};          // futex do consumidor
+    std::atomic<uint32_t> consumerWaiting{0};
+    alignas(64) std::atomic<uint64_t> tail{0};   // bytes consumidos
+    std::atomic<uint32_t> spaceSignal{0};         // futex do produtor
+    std::atomic<uint32_t> producerWaiting{0};
+    alignas(64) std::atomic<uint32_t> closed{0};
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+              "o anel compartilhado precisa de atômicos sem trava");
+
+namespace {
+const uint32_t CHANNEL_MAGIC = 0x52534643;  // "CFSR"
+const uint32_t CHANNEL_VERSION = 1;
+const size_t HEADER_SIZE = 64;
+const size_t RECORD_HEADER = sizeof(uint32_t);
+
+// Voltas de consulta antes de dormir no futex e, no modo BusyPoll, entre duas cessões
+// do processador (sem elas, dois lados no mesmo núcleo só avançariam a cada fatia de tempo)
+const unsigned FUTEX_SPINS = 128;
+const unsigned YIELD_SPINS = 1024;
+
+struct ChannelHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    std::atomic<uint32_t> ready;
+};
+static_assert(sizeof(ChannelHeader) <= HEADER_SIZE);
+
+size_t ringOffset(size_t index, uint64_t capacity) {
+    return HEADER_SIZE + index * (sizeof(RingControl) + capacity);
+}
+
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+void futexWait(std::atomic<uint32_t>& word, uint32_t expected) {
+#if defined(__linux__)
+    // Sem FUTEX_PRIVATE_FLAG: a palavra é compartilhada entre processos
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, nullptr, nullptr, 0);
+#else
+    (void)word;
+    (void)expected;
+    sched_yield();
+#endif
+}
+
+void futexWake(std::atomic<uint32_t>& word) {
+#if defined(__linux__)
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+// Acorda o outro lado se ele anunciou que vai dormir. A barreira ordena a publicação da
+// posição antes da leitura de waiting, par da barreira em waitUntil
+void notify(std::atomic<uint32_t>& signal, std::atomic<uint32_t>& waiting) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed)) {
+        signal.fetch_add(1, std::memory_order_release);
+        futexWake(signal);
+    }
+}
+
+// ready() consome ou publica o registro quando tem sucesso, então é chamado uma única vez
+// por tentativa
+template <typename Ready>
+void waitUntil(Ready ready, std::atomic<uint32_t>& signal, std::atomic<uint32_t>& waiting, WaitMode mode) {
+    for (unsigned spins = 1; !ready(); ++spins) {
+        if (mode == WaitMode::BusyPoll) {
+            cpuRelax();
+            if (spins % YIELD_SPINS == 0) sched_yield();
+            continue;
+        }
+        if (spins < FUTEX_SPINS) {
+            cpuRelax();
+            continue;
+        }
+        // O valor do futex é lido antes de anunciar a espera: uma publicação feita depois
+        // disso o altera, e o FUTEX_WAIT volta na hora em vez de dormir
+        uint32_t seen = signal.load(std::memory_order_acquire);
+        waiting.store(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool done = ready();
+        if (!done) {
+            futexWait(signal, seen);
+        }
+        waiting.store(0, std::memory_order_relaxed);
+        if (done) {
+            return;
+        }
+    }
+}
+
+uint64_t roundCapacity(size_t capacity) {
+    uint64_t result = 4096;
+    while (result < capacity) result <<= 1;
+    return result;
+}
+
+std::string segmentName(const std::string& name) {
+    if (name.empty()) {
+        throw std::runtime_error("nome de segmento de memória compartilhada vazio");
+    }
+    return name[0] == '/' ? name : "/" + name;
+}
+
+void* mapSegment(int fd, size_t size) {
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return memory == MAP_FAILED ? nullptr : memory;
+}
+
+void initializeChannel(void* memory, uint64_t capacity) {
+    auto* header = new (memory) ChannelHeader{CHANNEL_MAGIC, CHANNEL_VERSION, capacity, {0}};
+    for (size_t i = 0; i < 2; ++i) {
+        new (static_cast<uint8_t*>(memory) + ringOffset(i, capacity)) RingControl();
+    }
+    header->ready.store(1, std::memory_order_release);
+}
+}
+
+WaitMode parseWaitMode(const std::string& text) {
+    if (text == "poll") return WaitMode::BusyPoll;
+    if (text == "futex") return WaitMode::Futex;
+    throw std::runtime_error("modo de espera desconhecido: " + text + " (use poll ou futex)");
+}
+
+SharedRing::SharedRing(RingControl* control, uint8_t* data, uint64_t capacity)
+    : control(control), data(data), size(capacity), mask(capacity - 1) {}
+
+void SharedRing::copyIn(uint64_t position, const uint8_t* bytes, size_t count) {
+    size_t offset = position & mask;
+    size_t first = std::min<size_t>(count, size - offset);
+    std::memcpy(data + offset, bytes, first);
+    std::memcpy(data, bytes + first, count - first);
+}
+
+void SharedRing::copyOut(uint64_t position, uint8_t* bytes, size_t count) const {
+    size_t offset = position & mask;
+    size_t first = std::min<size_t>(count, size - offset);
+    std::memcpy(bytes, data + offset, first);
+    std::memcpy(bytes + first, data, count - first);
+}
+
+bool SharedRing::tryWrite(std::span<const uint8_t> record) {
+    uint64_t needed = RECORD_HEADER + record.size();
+    if (needed > size) {
+        throw std::runtime_error("registro de " + std::to_string(record.size()) + " bytes não cabe no anel de " +
+                                 std::to_string(size) + " bytes");
+    }
+    if (control->closed.load(std::memory_order_acquire)) {
+        throw std::runtime_error("anel de memória compartilhada fechado pelo outro lado");
+    }
+
+    uint64_t head = control->head.load(std::memory_order_relaxed);
+    if (head + needed - cachedTail > size) {
+        cachedTail = control->tail.load(std::memory_order_acquire);
+        if (head + needed - cachedTail > size) {
+            return false;
+        }
+    }
+    uint32_t length = static_cast<uint32_t>(record.size());
+    copyIn(head, reinterpret_cast<const uint8_t*>(&length), RECORD_HEADER);
+    copyIn(head + RECORD_HEADER, record.data(), record.size());
+    control->head.store(head + needed, std::memory_order_release);
+    notify(control->dataSignal, control->consumerWaiting);
+    return true;
+}
+
+void SharedRing::write(std::span<const uint8_t> record, WaitMode mode) {
+    // tryWrite lança se o consumidor fechar o anel durante a espera
+    waitUntil([&]() { return tryWrite(record); }, control->spaceSignal, control->producerWaiting, mode);
+}
+
+bool SharedRing::tryRead(std::vector<uint8_t>& record) {
+    uint64_t tail = control->tail.load(std::memory_order_relaxed);
+    if (tail == cachedHead) {
+        cachedHead = control->head.load(std::memory_order_acquire);
+        if (tail == cachedHead) {
+            return false;
+        }
+    }
+    uint32_t length = 0;
+    copyOut(tail, reinterpret_cast<uint8_t*>(&length), RECORD_HEADER);
+    if (RECORD_HEADER + length > cachedHead - tail) {
+        throw std::runtime_error("registro corrompido no anel de memória compartilhada");
+    }
+    record.resize(length);
+    copyOut(tail + RECORD_HEADER, record.data(), length);
+    control->tail.store(tail + RECORD_HEADER + length, std::memory_order_release);
+    notify(control->spaceSignal, control->producerWaiting);
+    return true;
+}
+
+bool SharedRing::read(std::vector<uint8_t>& record, WaitMode mode) {
+    bool received = false;
+    auto ready = [&]() {
+        return (received = tryRead(record)) || closed();
+    };
+    waitUntil(ready, control->dataSignal, control->consumerWaiting, mode);
+    // Fechado: o que foi publicado antes do close ainda é entregue
+    return received || tryRead(record);
+}
+
+void SharedRing::close() {
+    control->closed.store(1, std::memory_order_release);
+    for (std::atomic<uint32_t>* signal : {&control->dataSignal, &control->spaceSignal}) {
+        signal->fetch_add(1, std::memory_order_release);
+        futexWake(*signal);
+    }
+}
+
+bool SharedRing::closed() const {
+    return control->closed.load(std::memory_order_acquire) != 0;
+}
+
+SharedChannel::SharedChannel(void* memory, size_t mappedSize, std::string ownedName)
+    : memory(memory), mappedSize(mappedSize), ownedName(std::move(ownedName)) {
+    uint64_t capacity = static_cast<const ChannelHeader*>(memory)->capacity;
+    for (size_t i = 0; i < 2; ++i) {
+        uint8_t* base = static_cast<uint8_t*>(memory) + ringOffset(i, capacity);
+        rings.emplace_back(reinterpret_cast<RingControl*>(base), base + sizeof(RingControl), capacity);
+    }
+}
+
+SharedChannel::SharedChannel(SharedChannel&& other) noexcept
+    : memory(other.memory), mappedSize(other.mappedSize), ownedName(std::move(other.ownedName)),
+      rings(std::move(other.rings)) {
+    other.memory = nullptr;
+    other.ownedName.clear();
+}
+
+SharedChannel::~SharedChannel() {
+    if (!memory) {
+        return;
+    }
+    for (SharedRing& ring : rings) {
+        ring.close();
+    }
+    munmap(memory, mappedSize);
+    if (!ownedName.empty()) {
+        shm_unlink(ownedName.c_str());
+    }
+}
+
+SharedChannel SharedChannel::create(const std::string& name, size_t capacity) {
+    std::string path = segmentName(name);
+    uint64_t ringCapacity = roundCapacity(capacity);
+    size_t size = ringOffset(2, ringCapacity);
+
+    shm_unlink(path.c_str());
+    int fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) {
+        throw std::runtime_error("falha ao criar o segmento " + path + ": " + std::strerror(errno));
+    }
+    void* memory = ftruncate(fd, static_cast<off_t>(size)) == 0 ? mapSegment(fd, size) : nullptr;
+    int error = errno;
+    ::close(fd);
+    if (!memory) {
+        shm_unlink(path.c_str());
+        throw std::runtime_error("falha ao mapear o segmento " + path + ": " + std::strerror(error));
+    }
+    initializeChannel(memory, ringCapacity);
+    return SharedChannel(memory, size, path);
+}
+
+SharedChannel SharedChannel::open(const std::string& name, std::chrono::milliseconds timeout) {
+    std::string path = segmentName(name);
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        int fd = shm_open(path.c_str(), O_RDWR, 0);
+        if (fd >= 0) {
+            struct stat info {};
+            void* memory = nullptr;
+            size_t size = 0;
+            if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= HEADER_SIZE) {
+                size = static_cast<size_t>(info.st_size);
+                memory = mapSegment(fd, size);
+            }
+            ::close(fd);
+            if (memory) {
+                // O criador publica ready por último; antes disso o segmento ainda não vale
+                auto* header = static_cast<ChannelHeader*>(memory);
+                if (header->ready.load(std::memory_order_acquire) && header->magic == CHANNEL_MAGIC) {
+                    if (header->version != CHANNEL_VERSION || ringOffset(2, header->capacity) != size) {
+                        munmap(memory, size);
+                        throw std::runtime_error("segmento " + path + " com formato incompatível");
+                    }
+                    return SharedChannel(memory, size, "");
+                }
+                munmap(memory, size);
+            }
+        }
+        if (std::chrono::steady_clock::now() >= deadline) {
+            throw std::runtime_error("segmento de memória compartilhada não encontrado: " + path);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+SharedChannel SharedChannel::anonymous(size_t capacity) {
+    uint64_t ringCapacity = roundCapacity(capacity);
+    size_t size = ringOffset(2, ringCapacity);
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        throw std::runtime_error(std::string("falha ao mapear o anel anônimo: ") + std::strerror(errno));
+    }
+    initializeChannel(memory, ringCapacity);
+    return SharedChannel(memory, size, "");
+}
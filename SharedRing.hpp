@@ -0,0 +1,107 @@
+#ifndef SHARED_RING_H
+#define SHARED_RING_H
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+/*
+    * Transporte por memória compartilhada entre o mestre e o gerenciador, para mestres no
+    * mesmo host. Um segmento POSIX (shm_open) guarda dois anéis de um só produtor e um só
+    * consumidor:
+    *
+    *   - instructions(): mestre -> gerenciador, os registros do mestre (instrução,
+    *     argumentos e payload, sem o separador 0x03 0x02)
+    *   - responses():    gerenciador -> mestre, uma resposta por registro: ACK (0x06)
+    *     seguido do payload do frame nas chamadas e da tabela de frames no INIT com
+    *     --frame-ids
+    *
+    * Cada registro ocupa [tamanho uint32 na ordem do host][bytes], e pode dar a volta no
+    * fim do anel. Posições de leitura e escrita são contadores de 64 bits que só crescem,
+    * em linhas de cache separadas; cada lado guarda uma cópia local da posição do outro e
+    * só a relê quando o anel parece cheio ou vazio.
+    *
+    * Esperas:
+    *   - BusyPoll: consulta o anel continuamente (com pause da CPU), cedendo o processador
+    *     só depois de muitas voltas; a menor latência quando os dois lados têm núcleo próprio
+    *   - Futex: consulta por pouco tempo e depois dorme em um futex compartilhado, acordado
+    *     pelo outro lado quando publica
+*/
+
+enum class WaitMode : uint8_t { BusyPoll, Futex };
+
+// Lê "poll" ou "futex"; lança std::runtime_error para outros valores
+WaitMode parseWaitMode(const std::string& text);
+
+struct RingControl;
+
+// Visão de um anel dentro de uma região mapeada. O lado produtor só chama write/tryWrite
+// e o consumidor só read/tryRead, cada um de uma única thread
+class SharedRing {
+public:
+    SharedRing(RingControl* control, uint8_t* data, uint64_t capacity);
+
+    // Publica um registro; false (tryWrite) se não houver espaço. Lança se o registro
+    // não couber no anel ou se o anel estiver fechado
+    bool tryWrite(std::span<const uint8_t> record);
+    void write(std::span<const uint8_t> record, WaitMode mode);
+
+    // Consome o próximo registro para record. read espera por um registro e retorna false
+    // quando o anel foi fechado e não há mais nada a ler
+    bool tryRead(std::vector<uint8_t>& record);
+    bool read(std::vector<uint8_t>& record, WaitMode mode);
+
+    // Fim do fluxo: acorda quem espera dos dois lados
+    void close();
+    bool closed() const;
+
+    uint64_t capacity() const { return size; }
+
+private:
+    RingControl* control;
+    uint8_t* data;
+    uint64_t size;
+    uint64_t mask;
+    uint64_t cachedHead = 0;  // cópia do consumidor da posição de escrita
+    uint64_t cachedTail = 0;  // cópia do produtor da posição de leitura
+
+    void copyIn(uint64_t position, const uint8_t* bytes, size_t count);
+    void copyOut(uint64_t position, uint8_t* bytes, size_t count) const;
+};
+
+// Segmento com os dois anéis. Quem cria (o gerenciador) remove o nome do segmento no
+// destrutor; os dois lados fecham os anéis ao sair, para não deixar o outro esperando
+class SharedChannel {
+public:
+    static const size_t DEFAULT_CAPACITY = 1 << 20;
+
+    // Cria /name (um segmento antigo com o mesmo nome é substituído). A capacidade de cada
+    // anel é arredondada para uma potência de 2
+    static SharedChannel create(const std::string& name, size_t capacity = DEFAULT_CAPACITY);
+
+    // Abre um segmento criado pelo outro lado, tentando de novo até timeout
+    static SharedChannel open(const std::string& name, std::chrono::milliseconds timeout = {});
+
+    // Segmento sem nome, compartilhado entre threads ou com processos filhos de fork
+    static SharedChannel anonymous(size_t capacity = DEFAULT_CAPACITY);
+
+    SharedChannel(SharedChannel&& other) noexcept;
+    SharedChannel& operator=(SharedChannel&&) = delete;
+    SharedChannel(const SharedChannel&) = delete;
+    ~SharedChannel();
+
+    SharedRing& instructions() { return rings[0]; }
+    SharedRing& responses() { return rings[1]; }
+
+private:
+    SharedChannel(void* memory, size_t mappedSize, std::string ownedName);
+
+    void* memory;
+    size_t mappedSize;
+    std::string ownedName;  // vazio: não remove o segmento ao sair
+    std::vector<SharedRing> rings;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#include <stdexcept>
+#include "Symbols.hpp"
+
+uint32_t SymbolTable::intern(std::string_view text, bool* added) {
+    auto it = ids.find(text);
+    if (it != ids.end()) {
+        if (added) *added = false;
+        return it->second;
+    }
+
+    uint32_t id = static_cast<uint32_t>(strings.size());
+    const std::string& stored = strings.emplace_back(text);
+    ids.emplace(std::string_view(stored), id);
+    if (added) *added = true;
+    return id;
+}
+
+Value SymbolTable::handle(uint32_t id) const {
+    if (id >= strings.size()) {
+        throw std::out_of_range("Símbolo inexistente: " + std::to_string(id));
+    }
+    return Value::interned(strings[id]);
+}
@@ -0,0 +1,41 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <unordered_map>
+#include <cstdint>
+#include "Value.hpp"
+
+/*
+    * Modo de símbolos: cada string das tabelas de variáveis é transmitida por extenso
+    * (código de tipo 011) só na primeira vez; depois é referenciada pelo código de tipo
+    * 110 (custom) seguido do id em decimal. Cada direção do protocolo tem sua tabela, e os
+    * dois lados numeram as strings na ordem em que aparecem pela primeira vez.
+*/
+
+// Strings de uma direção do protocolo, com ids sequenciais a partir de 0
+class SymbolTable {
+public:
+    // Id da string, registrando-a se ainda não existir; added indica um registro novo
+    uint32_t intern(std::string_view text, bool* added = nullptr);
+
+    // Valor que referencia o texto guardado na tabela, sem alocar (ver Value::interned)
+    Value handle(uint32_t id) const;
+
+    size_t size() const { return strings.size(); }
+
+private:
+    // deque: os endereços dos textos não mudam quando a tabela cresce
+    std::deque<std::string> strings;
+    std::unordered_map<std::string_view, uint32_t> ids;
+};
+
+// Tabelas de uma sessão no modo de símbolos
+struct SessionSymbols {
+    SymbolTable incoming;   // Strings recebidas nos payloads do mestre
+    SymbolTable outgoing;   // Strings enviadas nas respostas do gerenciador
+};
+
+#endif
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include "TraceIndex.hpp"
+#include "Dispatcher.hpp"
+#include "Loader.hpp"
+
+namespace {
+const char MAGIC[4] = {'C', 'F', 'I', 'X'};
+const uint32_t VERSION = 2;  // 1: hash só de amostras do início e do fim do fluxo
+
+struct IndexHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t traceSize;
+    uint64_t traceHash;
+    uint64_t count;
+};
+
+// CRC32C (Castagnoli, polinômio refletido 0x82f63b78) do fluxo inteiro, oito bytes por
+// passo com as tabelas de slicing-by-8
+uint32_t crc32c(std::span<const uint8_t> data) {
+    static const auto tables = [] {
+        std::array<std::array<uint32_t, 256>, 8> t{};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (0x82f63b78u & (0u - (crc & 1)));
+            }
+            t[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (size_t k = 1; k < 8; ++k) {
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+            }
+        }
+        return t;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    const uint8_t* p = data.data();
+    size_t n = data.size();
+    for (; n >= 8; p += 8, n -= 8) {
+        uint32_t low = crc ^ (p[0] | p[1] << 8 | p[2] << 16 | static_cast<uint32_t>(p[3]) << 24);
+        crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^ tables[5][(low >> 16) & 0xFF] ^
+              tables[4][low >> 24] ^ tables[3][p[4]] ^ tables[2][p[5]] ^ tables[1][p[6]] ^ tables[0][p[7]];
+    }
+    for (; n > 0; ++p, --n) {
+        crc = (crc >> 8) ^ tables[0][(crc ^ *p) & 0xFF];
+    }
+    return ~crc;
+}
+
+struct Shard {
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::vector<uint8_t> instructions;
+};
+
+void scanShard(std::span<const uint8_t> data, Shard& shard, size_t begin, size_t end) {
+    forEachRecord(data, begin, end, [&](size_t offset, size_t length) {
+        shard.offsets.push_back(offset);
+        shard.lengths.push_back(static_cast<uint32_t>(length));
+        shard.instructions.push_back(data[offset]);
+    });
+}
+
+template <typename T>
+void appendColumn(std::vector<uint8_t>& out, const std::vector<T>& column) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(column.data());
+    out.insert(out.end(), bytes, bytes + column.size() * sizeof(T));
+}
+
+template <typename T>
+void readColumn(const std::vector<uint8_t>& in, size_t& position, std::vector<T>& column, size_t count) {
+    column.resize(count);
+    std::memcpy(column.data(), in.data() + position, count * sizeof(T));
+    position += count * sizeof(T);
+}
+}
+
+TraceIndex TraceIndex::build(std::span<const uint8_t> data, unsigned threads) {
+    std::vector<Shard> shards = forEachShard<Shard>(data, threads, [&](Shard& shard, size_t begin, size_t end) {
+        scanShard(data, shard, begin, end);
+    });
+
+    TraceIndex index;
+    index.traceSize = data.size();
+    index.traceHash = crc32c(data);
+    for (Shard& shard : shards) {
+        index.offsets.insert(index.offsets.end(), shard.offsets.begin(), shard.offsets.end());
+        index.lengths.insert(index.lengths.end(), shard.lengths.begin(), shard.lengths.end());
+        index.instructions.insert(index.instructions.end(), shard.instructions.begin(), shard.instructions.end());
+    }
+
+    index.depths.resize(index.instructions.size());
+    uint32_t depth = 1;
+    for (size_t i = 0; i < index.instructions.size(); ++i) {
+        uint8_t instruction = index.instructions[i];
+        if (instruction == INSTR_CALL_FUNCTION || instruction == INSTR_CALL_FRAME) {
+            ++depth;
+        } else if (instruction == INSTR_RETURN && depth > 0) {
+            --depth;
+        }
+        index.depths[i] = depth;
+    }
+    return index;
+}
+
+void TraceIndex::save(const std::string& path, IoBackend backend) const {
+    IndexHeader header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.traceSize = traceSize;
+    header.traceHash = traceHash;
+    header.count = offsets.size();
+
+    std::vector<uint8_t> out(reinterpret_cast<const uint8_t*>(&header),
+                             reinterpret_cast<const uint8_t*>(&header) + sizeof(header));
+    out.reserve(sizeof(header) + size() * (sizeof(uint64_t) + 2 * sizeof(uint32_t) + 1));
+    appendColumn(out, offsets);
+    appendColumn(out, lengths);
+    appendColumn(out, depths);
+    appendColumn(out, instructions);
+    writeOutput(path, out, backend);
+}
+
+TraceIndex TraceIndex::load(const std::string& path, IoBackend backend) {
+    std::vector<uint8_t> in = readInput(path, backend);
+    IndexHeader header;
+    if (in.size() < sizeof(header)) {
+        throw std::runtime_error("Índice truncado: " + path);
+    }
+    std::memcpy(&header, in.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION) {
+        throw std::runtime_error("Arquivo não é um índice de fluxo: " + path);
+    }
+    size_t count = header.count;
+    if (in.size() != sizeof(header) + count * (sizeof(uint64_t) + 2 * sizeof(uint32_t) + 1)) {
+        throw std::runtime_error("Índice truncado: " + path);
+    }
+
+    TraceIndex index;
+    index.traceSize = header.traceSize;
+    index.traceHash = header.traceHash;
+    size_t position = sizeof(header);
+    readColumn(in, position, index.offsets, count);
+    readColumn(in, position, index.lengths, count);
+    readColumn(in, position, index.depths, count);
+    readColumn(in, position, index.instructions, count);
+
+    // Registros dentro do fluxo, não vazios e em ordem, com ao menos o separador entre
+    // eles: record() pode recortar o fluxo sem conferir
+    uint64_t end = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t offset = index.offsets[i];
+        uint32_t length = index.lengths[i];
+        if (length == 0 || (i > 0 && offset < end + 2) || offset > index.traceSize ||
+            length > index.traceSize - offset) {
+            throw std::runtime_error("Índice corrompido: registro " + std::to_string(i) + " fora do fluxo em " + path);
+        }
+        end = offset + length;
+    }
+    return index;
+}
+
+TraceIndex TraceIndex::forTrace(const std::string& tracePath, std::span<const uint8_t> data, IoBackend backend,
+                                bool* built) {
+    std::string indexPath = tracePath + ".idx";
+    if (std::filesystem::exists(indexPath)) {
+        try {
+            TraceIndex index = load(indexPath, backend);
+            if (index.matches(data)) {
+                if (built) *built = false;
+                return index;
+            }
+        } catch (const std::runtime_error&) {
+            // Índice ilegível: é montado de novo e substituído
+        }
+    }
+    TraceIndex index = build(data);
+    index.save(indexPath, backend);
+    if (built) *built = true;
+    return index;
+}
+
+bool TraceIndex::matches(std::span<const uint8_t> data) const {
+    return traceSize == data.size() && traceHash == crc32c(data);
+}
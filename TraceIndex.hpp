@@ -0,0 +1,67 @@
+#ifndef TRACE_INDEX_H
+#define TRACE_INDEX_H
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+#include "IoBackend.hpp"
+
+/*
+    * Índice de acesso aleatório do fluxo de instruções do mestre, gravado ao lado do
+    * arquivo (<fluxo>.idx). Para cada registro, na ordem de splitByDelimiters, guarda a
+    * posição e o tamanho no fluxo (sem o separador), a instrução e a profundidade da pilha
+    * de frames depois dele, em colunas de tamanho fixo:
+    *
+    *   [cabeçalho][offsets uint64 × n][lengths uint32 × n][depths uint32 × n][instruções × n]
+    *
+    * Os valores ficam na ordem de bytes do host. O cabeçalho identifica o fluxo indexado
+    * pelo tamanho e pelo CRC32C do conteúdo inteiro (o fluxo já está em memória quando o
+    * índice é conferido), de modo que uma edição que mantém o tamanho mas desloca os
+    * separadores também invalida o índice. load confere que cada registro está dentro do
+    * fluxo e depois do anterior.
+    *
+    * A profundidade supõe um fluxo válido (ver Validation.hpp): cada chamada empilha um
+    * frame e cada RETURN desempilha um; 1 é só o frame raiz e 0, a sessão encerrada.
+*/
+
+class TraceIndex {
+public:
+    // Monta o índice em uma passada sobre data, dividida em fatias entre threads
+    // (0: uma por núcleo; ver forEachShard)
+    static TraceIndex build(std::span<const uint8_t> data, unsigned threads = 0);
+
+    // Lê um índice gravado por save; lança std::runtime_error se o arquivo não for um índice
+    // ou tiver um registro fora do fluxo
+    static TraceIndex load(const std::string& path, IoBackend backend = IoBackend::Stream);
+    void save(const std::string& path, IoBackend backend = IoBackend::Stream) const;
+
+    // Índice do fluxo tracePath, cujo conteúdo é data: lido de tracePath + ".idx" quando
+    // corresponde a data, ou montado e gravado lá. built indica que foi montado agora
+    static TraceIndex forTrace(const std::string& tracePath, std::span<const uint8_t> data,
+                               IoBackend backend = IoBackend::Stream, bool* built = nullptr);
+
+    // Se o índice foi montado a partir de data: mesmo tamanho e mesmo CRC32C
+    bool matches(std::span<const uint8_t> data) const;
+
+    size_t size() const { return offsets.size(); }
+    uint64_t offset(size_t i) const { return offsets[i]; }
+    uint32_t length(size_t i) const { return lengths[i]; }
+    uint32_t depth(size_t i) const { return depths[i]; }
+    uint8_t instruction(size_t i) const { return instructions[i]; }
+
+    // Bytes do registro i dentro de data, sem cópia
+    std::span<const uint8_t> record(std::span<const uint8_t> data, size_t i) const {
+        return data.subspan(offsets[i], lengths[i]);
+    }
+
+private:
+    uint64_t traceSize = 0;
+    uint64_t traceHash = 0;
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> lengths;
+    std::vector<uint32_t> depths;
+    std::vector<uint8_t> instructions;
+};
+
+#endif
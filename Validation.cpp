@@ -0,0 +1,120 @@
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+#include "Validation.hpp"
+#include "Dispatcher.hpp"
+#include "Loader.hpp"
+
+namespace {
+// Registro encontrado por uma fatia; só o necessário para a passada da pilha
+struct RecordSpan {
+    size_t offset;
+    uint32_t length;
+    uint8_t instruction;
+};
+
+struct Shard {
+    std::vector<RecordSpan> records;
+    std::vector<RecordError> errors;    // index ainda relativo à fatia
+};
+
+RecordError makeError(size_t index, const RecordSpan& record, std::string message) {
+    return RecordError{index, record.offset, record.length, record.instruction, std::move(message)};
+}
+
+// Confere um registro sem o estado da sessão; retorna a mensagem de erro ou uma string vazia
+std::string checkRecord(std::span<const uint8_t> segment, const ValidationOptions& options,
+                        const PayloadOptions& decodeOptions, std::string& payload, DecodedPayload& decoded) {
+    uint8_t instruction = segment[0];
+    if (instruction == INSTR_INIT || instruction == INSTR_RETURN) {
+        return {};
+    }
+    if (instruction != INSTR_CALL_FUNCTION && instruction != INSTR_CALL_FRAME) {
+        char message[48];
+        std::snprintf(message, sizeof(message), "Instrução desconhecida: 0x%02x", instruction);
+        return message;
+    }
+
+    if (instruction == INSTR_CALL_FRAME && !options.codeTable) {
+        return "CALL_FRAME recebido fora do modo por id de frame";
+    }
+    if (segment.size() < 4) {
+        return instruction == INSTR_CALL_FUNCTION ? "Registro de CALL_FUNCTION truncado" : "Registro de CALL_FRAME truncado";
+    }
+    if (instruction == INSTR_CALL_FUNCTION && segment[1] > 4) {
+        return "Vetor de destino inválido: " + std::to_string(segment[1]);
+    }
+    if (instruction == INSTR_CALL_FRAME) {
+        uint32_t id = segment[1] | (static_cast<uint32_t>(segment[2]) << 8);
+        if (id >= options.codeTable->size()) {
+            return "Id de frame inexistente: " + std::to_string(id);
+        }
+    }
+
+    payload.assign(segment.begin() + 4, segment.end());
+    try {
+        decodeFramePayload(payload, decoded, decodeOptions);
+    } catch (const std::exception& error) {
+        return error.what();
+    }
+    return {};
+}
+
+void validateShard(std::span<const uint8_t> data, Shard& shard, size_t begin, size_t end,
+                   const ValidationOptions& options) {
+    PayloadOptions decodeOptions;
+    decodeOptions.codec = options.codec;
+    decodeOptions.unresolvedSymbols = options.symbols;
+    std::string payload;
+    DecodedPayload decoded;
+
+    forEachRecord(data, begin, end, [&](size_t offset, size_t length) {
+        RecordSpan record{offset, static_cast<uint32_t>(length), data[offset]};
+        std::string message = checkRecord(data.subspan(offset, length), options, decodeOptions, payload, decoded);
+        if (!message.empty()) {
+            shard.errors.push_back(makeError(shard.records.size(), record, std::move(message)));
+        }
+        shard.records.push_back(record);
+    });
+}
+}
+
+void ValidationReport::write(std::ostream& os) const {
+    os << "validation: records=" << records << " errors=" << errors.size() << " threads=" << threads << std::endl;
+    for (const RecordError& error : errors) {
+        os << "  record " << error.index << " at offset " << error.offset << " (" << error.length << " bytes, "
+           << instructionName(error.instruction) << "): " << error.message << std::endl;
+    }
+}
+
+ValidationReport validateTrace(std::span<const uint8_t> data, const ValidationOptions& options) {
+    std::vector<Shard> shards = forEachShard<Shard>(data, options.threads, [&](Shard& shard, size_t begin, size_t end) {
+        validateShard(data, shard, begin, end, options);
+    });
+
+    // Passada da pilha: o frame raiz fica sempre empilhado, e um RETURN recusado não a altera
+    ValidationReport report;
+    report.threads = static_cast<unsigned>(shards.size());
+    size_t depth = 1;
+    for (Shard& shard : shards) {
+        size_t first = report.records;
+        auto shardError = shard.errors.begin();
+        for (size_t i = 0; i < shard.records.size(); ++i) {
+            const RecordSpan& record = shard.records[i];
+            if (shardError != shard.errors.end() && shardError->index == i) {
+                shardError->index += first;
+                report.errors.push_back(std::move(*shardError++));
+            } else if (record.instruction == INSTR_CALL_FUNCTION || record.instruction == INSTR_CALL_FRAME) {
+                ++depth;
+            } else if (record.instruction == INSTR_RETURN) {
+                if (depth == 1) {
+                    report.errors.push_back(makeError(first + i, record, "RETURN sem chamada em andamento"));
+                } else {
+                    --depth;
+                }
+            }
+        }
+        report.records += shard.records.size();
+    }
+    return report;
+}
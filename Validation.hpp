@@ -0,0 +1,58 @@
+#ifndef VALIDATION_H
+#define VALIDATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <vector>
+#include "Code.hpp"
+#include "CodeTable.hpp"
+
+/*
+    * Validação do fluxo de instruções antes da execução. O fluxo é dividido em fatias de
+    * bytes, uma por thread; cada thread encontra os registros que começam na sua fatia
+    * (ver findRecordSeparator) e confere o que não depende do estado da sessão:
+    *
+    *   - instrução conhecida, e CALL_FRAME só no modo por id de frame, com id existente
+    *   - chamadas com os argumentos completos e vetor de destino entre 0 e 4
+    *   - payload decodificável na revisão da sessão (decodeFramePayload). Referências a
+    *     símbolos são aceitas sem conferir o id, que depende dos registros anteriores
+    *
+    * Depois, uma passada curta sobre as instruções de todas as fatias acompanha a
+    * profundidade da pilha e aponta os RETURN sem chamada em andamento. Índices, valores de
+    * variáveis e o Code chamado continuam sendo conferidos só na execução.
+*/
+
+// Registro que a sessão recusaria
+struct RecordError {
+    size_t index = 0;       // ordem do registro no fluxo, como em splitByDelimiters
+    size_t offset = 0;      // primeiro byte do registro no fluxo
+    size_t length = 0;      // bytes do registro, sem o separador
+    uint8_t instruction = 0;
+    std::string message;
+};
+
+struct ValidationOptions {
+    PayloadCodec codec = PayloadCodec::V1;
+    bool symbols = false;                   // modo de símbolos da sessão
+    const CodeTable* codeTable = nullptr;   // modo por id de frame
+    unsigned threads = 0;                   // 0: uma por núcleo
+};
+
+// Resultado de validateTrace
+struct ValidationReport {
+    size_t records = 0;
+    unsigned threads = 0;               // threads efetivamente usadas
+    std::vector<RecordError> errors;    // na ordem do fluxo
+
+    bool ok() const { return errors.empty(); }
+    void write(std::ostream& os) const;
+};
+
+// Valida todos os registros de data, sem parar no primeiro erro. Fluxos pequenos usam
+// menos threads que o pedido, para que cada fatia compense o custo de criar a thread
+ValidationReport validateTrace(std::span<const uint8_t> data, const ValidationOptions& options = {});
+
+#endif
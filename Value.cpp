@@ -0,0 +1,115 @@
+#include <cstring>
+#include "Value.hpp"
+
+Value::Value(int value) noexcept : tag(Type::Int) {
+    store<int32_t>(value);
+}
+
+Value::Value(bool value) noexcept : tag(Type::Bool) {
+    storage[0] = value ? 1 : 0;
+}
+
+Value::Value(float value) noexcept : tag(Type::Float) {
+    store<float>(value);
+}
+
+Value::Value(std::string_view value) : tag(Type::String) {
+    if (value.size() <= INLINE_CAPACITY) {
+        std::memcpy(storage, value.data(), value.size());
+        storage[LENGTH_BYTE] = static_cast<unsigned char>(value.size());
+    } else {
+        storeHeapString(value.data(), static_cast<uint32_t>(value.size()));
+    }
+}
+
+Value::Value(Code* code) noexcept : tag(Type::Code) {
+    store<Code*>(code);
+}
+
+Value Value::interned(std::string_view text) noexcept {
+    Value value;
+    value.storeStringRef(text.data(), static_cast<uint32_t>(text.size()), INTERNED_STRING);
+    value.tag = Type::String;
+    return value;
+}
+
+Value::Value(const Value& other) : tag(Type::Null) {
+    copyFrom(other);
+}
+
+Value::Value(Value&& other) noexcept : tag(other.tag) {
+    // A string do heap muda de dono junto com os bytes
+    std::memcpy(storage, other.storage, sizeof(storage));
+    other.tag = Type::Null;
+}
+
+Value& Value::operator=(const Value& other) {
+    if (this != &other) {
+        release();
+        copyFrom(other);
+    }
+    return *this;
+}
+
+Value& Value::operator=(Value&& other) noexcept {
+    if (this != &other) {
+        release();
+        std::memcpy(storage, other.storage, sizeof(storage));
+        tag = other.tag;
+        other.tag = Type::Null;
+    }
+    return *this;
+}
+
+std::string_view Value::asString() const noexcept {
+    if (storage[LENGTH_BYTE] == HEAP_STRING || storage[LENGTH_BYTE] == INTERNED_STRING) {
+        uint32_t size;
+        std::memcpy(&size, storage + sizeof(char*), sizeof(size));
+        return std::string_view(load<const char*>(), size);
+    }
+    return std::string_view(reinterpret_cast<const char*>(storage), storage[LENGTH_BYTE]);
+}
+
+bool Value::operator==(const Value& other) const noexcept {
+    if (tag != other.tag) {
+        return false;
+    }
+    switch (tag) {
+        case Type::Null: return true;
+        case Type::Int: return asInt() == other.asInt();
+        case Type::Float: return asFloat() == other.asFloat();
+        case Type::Bool: return asBool() == other.asBool();
+        case Type::Code: return asCode() == other.asCode();
+        case Type::String: return asString() == other.asString();
+    }
+    return false;
+}
+
+void Value::storeHeapString(const char* data, uint32_t size) {
+    char* buffer = new char[size];
+    std::memcpy(buffer, data, size);
+    storeStringRef(buffer, size, HEAP_STRING);
+}
+
+void Value::storeStringRef(const char* data, uint32_t size, unsigned char marker) noexcept {
+    store<const char*>(data);
+    std::memcpy(storage + sizeof(char*), &size, sizeof(size));
+    storage[LENGTH_BYTE] = marker;
+}
+
+void Value::copyFrom(const Value& other) {
+    if (other.isHeapString()) {
+        std::string_view value = other.asString();
+        storeHeapString(value.data(), static_cast<uint32_t>(value.size()));
+    } else {
+        std::memcpy(storage, other.storage, sizeof(storage));
+    }
+    tag = other.tag;
+}
+
+void Value::release() noexcept {
+    if (isHeapString()) {
+        delete[] load<char*>();
+    }
+    tag = Type::Null;
+}
@@ -0,0 +1,96 @@
+#ifndef VALUE_H
+#define VALUE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+class Code;
+
+// Valor de 16 bytes guardado nos vetores de variáveis e constantes dos frames.
+// ints, floats, bools e strings de até INLINE_CAPACITY bytes ficam no próprio valor;
+// strings maiores vão para o heap. Objetos Code são referenciados por ponteiro e
+// pertencem ao Code pai (ver Code::addChild)
+class Value {
+public:
+    enum class Type : uint8_t { Null, Int, Float, String, Code, Bool };
+
+    static const size_t INLINE_CAPACITY = 14;
+
+    Value() noexcept : tag(Type::Null) {}
+    Value(std::nullptr_t) noexcept : tag(Type::Null) {}
+    Value(int value) noexcept;
+    Value(bool value) noexcept;
+    Value(float value) noexcept;
+    Value(double value) noexcept : Value(static_cast<float>(value)) {}
+    Value(const char* value) : Value(std::string_view(value)) {}
+    Value(const std::string& value) : Value(std::string_view(value)) {}
+    Value(std::string_view value);
+    Value(Code* code) noexcept;
+
+    // String que não pertence ao valor: aponta para um texto guardado em uma SymbolTable
+    // (ver Symbols.hpp), que precisa viver mais que o valor. Cópias não alocam
+    static Value interned(std::string_view text) noexcept;
+
+    Value(const Value& other);
+    Value(Value&& other) noexcept;
+    Value& operator=(const Value& other);
+    Value& operator=(Value&& other) noexcept;
+    ~Value() { release(); }
+
+    Type type() const noexcept { return tag; }
+    bool isNull() const noexcept { return tag == Type::Null; }
+    bool isInt() const noexcept { return tag == Type::Int; }
+    bool isFloat() const noexcept { return tag == Type::Float; }
+    bool isBool() const noexcept { return tag == Type::Bool; }
+    bool isString() const noexcept { return tag == Type::String; }
+    bool isCode() const noexcept { return tag == Type::Code; }
+
+    // Acesso sem verificação: o tipo deve ser conferido antes
+    int asInt() const noexcept { return load<int32_t>(); }
+    float asFloat() const noexcept { return load<float>(); }
+    bool asBool() const noexcept { return storage[0] != 0; }
+    Code* asCode() const noexcept { return load<Code*>(); }
+    std::string_view asString() const noexcept;
+
+    // Mesmo tipo e mesmo conteúdo; Code é comparado por identidade
+    bool operator==(const Value& other) const noexcept;
+
+    // Verdadeiro se a string não coube no próprio valor
+    bool isHeapString() const noexcept { return tag == Type::String && storage[LENGTH_BYTE] == HEAP_STRING; }
+    bool isInternedString() const noexcept { return tag == Type::String && storage[LENGTH_BYTE] == INTERNED_STRING; }
+
+private:
+    static const size_t LENGTH_BYTE = INLINE_CAPACITY;
+    static const unsigned char HEAP_STRING = 0xFF;
+    static const unsigned char INTERNED_STRING = 0xFE;
+
+    // Bytes 0..13: dado ou string curta; byte 14: tamanho da string curta (ou HEAP_STRING,
+    // INTERNED_STRING). String no heap ou internada: ponteiro nos bytes 0..7 e tamanho nos bytes 8..11
+    alignas(8) unsigned char storage[15];
+    Type tag;
+
+    template <typename T>
+    T load() const noexcept {
+        T value;
+        std::memcpy(&value, storage, sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    void store(T value) noexcept {
+        std::memcpy(storage, &value, sizeof(T));
+    }
+
+    void storeHeapString(const char* data, uint32_t size);
+    void storeStringRef(const char* data, uint32_t size, unsigned char marker) noexcept;
+
+    void copyFrom(const Value& other);
+    void release() noexcept;
+};
+
+static_assert(sizeof(Value) == 16, "Value deve ocupar 16 bytes");
+
+#endif
@@ -0,0 +1,942 @@
+#include <string>
+#include <vector>
+#include <sstream>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <filesystem>
+#include <benchmark/benchmark.h>
+#include "include/json.hpp"
+#include "Code.hpp"
+#include "Loader.hpp"
+#include "Marshal.hpp"
+#include "Dedup.hpp"
+#include "Bytecode.hpp"
+#include "Prefetch.hpp"
+#include "Emulator.hpp"
+#include "SharedRing.hpp"
+#include "IoBackend.hpp"
+#include "Pipeline.hpp"
+#include "Validation.hpp"
+#include "TraceIndex.hpp"
+#include "Checkpoint.hpp"
+#include "Dispatcher.hpp"
+#include "FrameExecutor.hpp"
+#include "Metrics.hpp"
+
+/*
+    * Benchmarks dos caminhos críticos de serialização e despacho.
+    *
+    * Parâmetros comuns:
+    *   - size: quantidade de itens em cada vetor de variáveis
+    *   - mix:  composição dos valores (0 = int, 1 = string, 2 = misto)
+    *   - depth: profundidade de aninhamento dos objetos Code
+    *
+    * Para saída legível por máquina:
+    *   ./benchmarks --benchmark_format=json --benchmark_out=bench.json
+*/
+
+namespace {
+
+const uint8_t recordSeparator[2] = {0x03, 0x02};
+
+enum ValueMix { MIX_INT = 0, MIX_STRING = 1, MIX_MIXED = 2 };
+
+const char* mixName(int mix) {
+    switch (mix) {
+        case MIX_INT: return "int";
+        case MIX_STRING: return "string";
+        default: return "mixed";
+    }
+}
+
+// Inteiros pequenos, típicos de frames Python. O formato atual não escapa os
+// separadores, então valores cujo byte seja GS (29) ou US (31) são evitados
+int smallInt(size_t i) {
+    int value = static_cast<int>(i % 100);
+    return (value == 29 || value == 31) ? value + 1 : value;
+}
+
+// Gera um vetor de variáveis com a composição pedida
+std::vector<VarType> makeVector(size_t size, int mix) {
+    std::vector<VarType> vec;
+    vec.reserve(size);
+    for (size_t i = 0; i < size; ++i) {
+        int kind = (mix == MIX_MIXED) ? static_cast<int>(i % 5) : (mix == MIX_INT ? 0 : 1);
+        switch (kind) {
+            case 0: vec.emplace_back(smallInt(i)); break;
+            case 1: vec.emplace_back("name_" + std::to_string(i)); break;
+            case 2: vec.emplace_back(i % 2 == 0); break;
+            case 3: vec.emplace_back(nullptr); break;
+            default: vec.emplace_back(static_cast<float>(i) * 0.5f); break;
+        }
+    }
+    return vec;
+}
+
+// co_code representativo (corpo de add_numbers em code.json)
+const std::string SAMPLE_CO_CODE = "8700660164016402840889007c007c011700740074017402830217005300";
+
+Code makeFrame(size_t size, int mix) {
+    Code code(SAMPLE_CO_CODE);
+    code.setCoNames(makeVector(size, mix));
+    code.setCoVarnames(makeVector(size, mix));
+    code.setCoFreevars(makeVector(size / 4, mix));
+    code.setCoCellvars(makeVector(size / 4, mix));
+    code.setCoConsts(makeVector(size, mix));
+    return code;
+}
+
+// JSON no formato de pyc_serializer.py com 'depth' níveis de funções aninhadas
+nlohmann::json makeNestedJson(int depth) {
+    nlohmann::json node = {
+        {"co_code", SAMPLE_CO_CODE},
+        {"co_names", {"add_numbers", "a", "b"}},
+        {"co_varnames", {"x", "y"}},
+        {"co_freevars", nlohmann::json::array()},
+        {"co_cellvars", {"subtract_numbers"}},
+        {"co_consts", {nullptr, 10, 6, "Resultado:", 1.5, true}}
+    };
+    if (depth > 0) {
+        node["co_consts"].push_back(makeNestedJson(depth - 1));
+    }
+    return node;
+}
+
+// Mesmo módulo de makeNestedJson serializado em marshal (layout do Python 3.10)
+const uint16_t MARSHAL_MAGIC_310 = 3439;
+
+std::string marshalInt32(int32_t value) {
+    std::string bytes(4, '\0');
+    for (int i = 0; i < 4; ++i) bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+    return bytes;
+}
+
+std::string marshalShortString(const std::string& text) {
+    return std::string("z") + static_cast<char>(text.size()) + text;
+}
+
+std::string marshalNames(const std::vector<std::string>& names) {
+    std::string bytes = std::string(")") + static_cast<char>(names.size());
+    for (const auto& name : names) bytes += marshalShortString(name);
+    return bytes;
+}
+
+std::string makeNestedMarshal(int depth) {
+    std::string coCode;
+    for (size_t i = 0; i < SAMPLE_CO_CODE.size(); i += 2) {
+        coCode.push_back(static_cast<char>(std::stoi(SAMPLE_CO_CODE.substr(i, 2), nullptr, 16)));
+    }
+
+    std::string bytes = "c";
+    for (int32_t field : {2, 0, 0, 2, 4, 3}) {  // argcount .. flags
+        bytes += marshalInt32(field);
+    }
+    bytes += "s" + marshalInt32(coCode.size()) + coCode;
+
+    double real = 1.5;
+    std::string consts = "N" + ("i" + marshalInt32(10)) + ("i" + marshalInt32(6)) + marshalShortString("Resultado:");
+    consts += "g" + std::string(reinterpret_cast<const char*>(&real), sizeof(real)) + "T";
+    bytes += "(" + marshalInt32(depth > 0 ? 7 : 6) + consts;
+    if (depth > 0) bytes += makeNestedMarshal(depth - 1);
+
+    bytes += marshalNames({"add_numbers", "a", "b"});
+    bytes += marshalNames({"x", "y"});
+    bytes += marshalNames({});
+    bytes += marshalNames({"subtract_numbers"});
+    bytes += marshalShortString("test.py") + marshalShortString("add_numbers");
+    bytes += marshalInt32(1) + "s" + marshalInt32(0);
+    return bytes;
+}
+
+// Árvore de frames em que o filho de cada nível está em co_consts[0] e é
+// referenciado pelo int em co_names[0]
+Code makeCallChain(int depth) {
+    Code code(SAMPLE_CO_CODE);
+    code.setCoNames(std::vector<VarType>{0});
+    code.setCoVarnames(std::vector<VarType>{nullptr, nullptr});
+    if (depth > 0) {
+        code.setCoConsts(std::vector<VarType>{code.addChild(makeCallChain(depth - 1)), nullptr, "child"});
+    } else {
+        code.setCoConsts(std::vector<VarType>{nullptr, nullptr, "leaf"});
+    }
+    return code;
+}
+
+// Fluxo INIT, 'depth' CALL_FUNCTION e 'depth' RETURN, como gerado por testPayload.cpp
+std::vector<uint8_t> makeTrace(int depth) {
+    Code caller;
+    caller.setCoNames(std::vector<VarType>{0});
+    caller.setCoVarnames(std::vector<VarType>{7, "x"});
+    std::string callPayload = caller.generateInputTestPayload({});
+
+    std::vector<uint8_t> trace;
+    auto appendSeparator = [&trace]() {
+        trace.insert(trace.end(), recordSeparator, recordSeparator + 2);
+    };
+
+    trace.push_back(INSTR_INIT);
+    appendSeparator();
+    for (int i = 0; i < depth; ++i) {
+        trace.push_back(INSTR_CALL_FUNCTION);
+        trace.push_back(1);
+        trace.push_back(0);
+        trace.insert(trace.end(), callPayload.begin(), callPayload.end());
+        appendSeparator();
+    }
+    for (int i = 0; i < depth; ++i) {
+        trace.push_back(INSTR_RETURN);
+        appendSeparator();
+    }
+    return trace;
+}
+
+} // namespace
+
+static void BM_GeneratePayload(benchmark::State& state) {
+    Code code = makeFrame(state.range(0), state.range(1));
+    std::vector<VarType> globals = makeVector(state.range(0), state.range(1));
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        std::string payload = code.generatePayload(globals);
+        bytes += payload.size();
+        benchmark::DoNotOptimize(payload);
+    }
+    state.SetBytesProcessed(bytes);
+    state.SetLabel(mixName(state.range(1)));
+}
+BENCHMARK(BM_GeneratePayload)->ArgsProduct({{8, 64, 512, 4096}, {MIX_INT, MIX_STRING, MIX_MIXED}});
+
+// Mesmo payload com co_code e co_consts pré-codificados por precomputePayload
+static void BM_GeneratePayloadPrecomputed(benchmark::State& state) {
+    Code code = makeFrame(state.range(0), state.range(1));
+    code.precomputePayload();
+    std::vector<VarType> globals = makeVector(state.range(0), state.range(1));
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        std::string payload = code.generatePayload(globals);
+        bytes += payload.size();
+        benchmark::DoNotOptimize(payload);
+    }
+    state.SetBytesProcessed(bytes);
+    state.SetLabel(mixName(state.range(1)));
+}
+BENCHMARK(BM_GeneratePayloadPrecomputed)->ArgsProduct({{8, 64, 512, 4096}, {MIX_INT, MIX_STRING, MIX_MIXED}});
+
+// Aquecimento de um módulo com 'depth' funções aninhadas, em 1 e em várias threads
+static void BM_PrecomputePayloads(benchmark::State& state) {
+    Code root = readCodeFromJson(makeNestedJson(state.range(0)));
+    unsigned threads = static_cast<unsigned>(state.range(1));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(precomputePayloads(root, threads));
+    }
+    state.counters["frames"] = state.range(0) + 1;
+}
+BENCHMARK(BM_PrecomputePayloads)->ArgsProduct({{8, 32}, {1, 4}})->UseRealTime();
+
+static void BM_GenerateInputTestPayload(benchmark::State& state) {
+    Code code = makeFrame(state.range(0), state.range(1));
+    std::vector<VarType> globals = makeVector(state.range(0), state.range(1));
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        std::string payload = code.generateInputTestPayload(globals);
+        bytes += payload.size();
+        benchmark::DoNotOptimize(payload);
+    }
+    state.SetBytesProcessed(bytes);
+    state.SetLabel(mixName(state.range(1)));
+}
+BENCHMARK(BM_GenerateInputTestPayload)->ArgsProduct({{8, 64, 512, 4096}, {MIX_INT, MIX_STRING, MIX_MIXED}});
+
+static void BM_UpdateFromPayload(benchmark::State& state) {
+    Code source = makeFrame(state.range(0), state.range(1));
+    std::vector<VarType> globals = makeVector(state.range(0), state.range(1));
+    // O Dispatcher descarta o GS inicial junto com os argumentos do CALL_FUNCTION
+    std::string payload = source.generateInputTestPayload(globals).substr(1);
+    Code target;
+
+    for (auto _ : state) {
+        target.updateFromPayload(payload, globals);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * payload.size());
+    state.SetLabel(mixName(state.range(1)));
+}
+BENCHMARK(BM_UpdateFromPayload)->ArgsProduct({{8, 64, 512, 4096}, {MIX_INT, MIX_STRING, MIX_MIXED}});
+
+// Decodificação de tabelas com nomes longos (acima da capacidade inline de Value), sem
+// (argumento 0) e com (argumento 1) a tabela de símbolos da sessão, que evita uma alocação
+// por string; o contador response_bytes mostra a resposta com os símbolos já enviados
+static void BM_SymbolTables(benchmark::State& state) {
+    bool useSymbols = state.range(1) != 0;
+    std::vector<VarType> names;
+    for (int i = 0; i < state.range(0); ++i) {
+        names.emplace_back("subtract_numbers_" + std::to_string(i));
+    }
+    Code source;
+    source.setCoNames(names);
+    source.setCoVarnames(names);
+    std::vector<VarType> globals;
+    std::string payload = source.generateInputTestPayload(globals).substr(1);
+
+    SessionSymbols symbols;
+    PayloadOptions incoming{useSymbols ? &symbols.incoming : nullptr};
+    PayloadOptions outgoing{useSymbols ? &symbols.outgoing : nullptr};
+    std::vector<VarType> tables[4];
+
+    for (auto _ : state) {
+        decodeFramePayload(payload, globals, tables[0], tables[1], tables[2], tables[3], incoming);
+        benchmark::ClobberMemory();
+    }
+
+    source.generatePayload(globals, source.tables(), outgoing);
+    state.counters["response_bytes"] = static_cast<double>(source.generatePayload(globals, source.tables(), outgoing).size());
+    state.SetBytesProcessed(state.iterations() * payload.size());
+    state.SetLabel(useSymbols ? "symbols" : "plain");
+}
+BENCHMARK(BM_SymbolTables)->ArgsProduct({{8, 64, 512}, {0, 1}});
+
+// Ida e volta de um payload nas codificações V1 (argumento 2 = 1) e V2 (= 2): gera com
+// generateInputTestPayload e decodifica com decodeFramePayload. O contador payload_bytes
+// compara o tamanho das duas revisões para cada composição de valores
+static void BM_PayloadCodec(benchmark::State& state) {
+    PayloadCodec codec = static_cast<PayloadCodec>(state.range(2));
+    Code source = makeFrame(state.range(0), state.range(1));
+    std::vector<VarType> globals = makeVector(state.range(0), state.range(1));
+    PayloadOptions options{nullptr, codec};
+    std::vector<VarType> decodedGlobals;
+    std::vector<VarType> tables[4];
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        std::string payload = source.generateInputTestPayload(globals, codec).substr(1);
+        decodeFramePayload(payload, decodedGlobals, tables[0], tables[1], tables[2], tables[3], options);
+        bytes += payload.size();
+        benchmark::ClobberMemory();
+    }
+    state.counters["payload_bytes"] =
+        static_cast<double>(source.generateInputTestPayload(globals, codec).size());
+    state.SetBytesProcessed(bytes);
+    state.SetLabel(std::string(mixName(state.range(1))) + (codec == PayloadCodec::V2 ? "/v2" : "/v1"));
+}
+BENCHMARK(BM_PayloadCodec)->ArgsProduct({{8, 64, 512}, {MIX_INT, MIX_STRING, MIX_MIXED}, {1, 2}});
+
+static void BM_HexToBinaryStream(benchmark::State& state) {
+    std::string hex;
+    while (hex.size() < static_cast<size_t>(state.range(0)) * 2) {
+        hex += SAMPLE_CO_CODE;
+    }
+    hex.resize(state.range(0) * 2);
+
+    for (auto _ : state) {
+        std::ostringstream out;
+        hexToBinaryStream(hex, out);
+        benchmark::DoNotOptimize(out);
+    }
+    state.SetBytesProcessed(state.iterations() * hex.size());
+}
+BENCHMARK(BM_HexToBinaryStream)->RangeMultiplier(8)->Range(32, 32 << 12);
+
+static void BM_SplitByDelimiters(benchmark::State& state) {
+    std::vector<uint8_t> trace = makeTrace(state.range(0));
+
+    for (auto _ : state) {
+        auto segments = splitByDelimiters(trace, recordSeparator[0], recordSeparator[1]);
+        benchmark::DoNotOptimize(segments);
+    }
+    state.SetBytesProcessed(state.iterations() * trace.size());
+}
+BENCHMARK(BM_SplitByDelimiters)->RangeMultiplier(8)->Range(1, 1 << 12);
+
+static void BM_ReadCodeFromJson(benchmark::State& state) {
+    nlohmann::json jsonData = makeNestedJson(state.range(0));
+
+    for (auto _ : state) {
+        Code code = readCodeFromJson(jsonData);
+        benchmark::DoNotOptimize(code);
+    }
+    state.counters["frames"] = state.range(0) + 1;
+}
+BENCHMARK(BM_ReadCodeFromJson)->DenseRange(0, 32, 8);
+
+// Carga de um módulo a partir do texto JSON (caminho pyc_serializer.py) e do marshal do .pyc
+static void BM_LoadModuleJson(benchmark::State& state) {
+    std::string text = makeNestedJson(state.range(0)).dump(4);
+
+    for (auto _ : state) {
+        Code code = readCodeFromJson(nlohmann::json::parse(text));
+        benchmark::DoNotOptimize(code);
+    }
+    state.SetBytesProcessed(state.iterations() * text.size());
+}
+BENCHMARK(BM_LoadModuleJson)->DenseRange(0, 32, 8);
+
+// Módulo com 'width' cópias da mesma função aninhada: carga seguida de deduplicação
+static void BM_DeduplicateCodes(benchmark::State& state) {
+    nlohmann::json module = makeNestedJson(0);
+    for (int i = 0; i < state.range(0); ++i) {
+        module["co_consts"].push_back(makeNestedJson(2));
+    }
+    DedupReport report;
+
+    for (auto _ : state) {
+        Code code = readCodeFromJson(module);
+        report = deduplicateCodes(code);
+        benchmark::DoNotOptimize(code);
+    }
+    state.counters["unique"] = static_cast<double>(report.uniqueCodes);
+    state.counters["bytes_saved"] = static_cast<double>(report.bytesSaved);
+}
+BENCHMARK(BM_DeduplicateCodes)->RangeMultiplier(4)->Range(1, 64);
+
+// Carga preguiçosa do mesmo texto: só o frame raiz é convertido; o segundo argumento
+// resolve o primeiro filho logo após a carga, como faria o primeiro CALL_FUNCTION
+static void BM_LoadModuleJsonLazy(benchmark::State& state) {
+    auto text = std::make_shared<const std::string>(makeNestedJson(state.range(0)).dump(4));
+    bool resolveFirstCall = state.range(1) != 0;
+    std::vector<VarType> globals{6};  // Índice do filho em co_consts de makeNestedJson
+
+    for (auto _ : state) {
+        Code code = readCodeFromJsonLazy(text);
+        if (resolveFirstCall && !code.children.empty()) {
+            benchmark::DoNotOptimize(&code.getCodeFromVariable(globals, 0, 0));
+        }
+        benchmark::DoNotOptimize(code);
+    }
+    state.SetBytesProcessed(state.iterations() * text->size());
+}
+BENCHMARK(BM_LoadModuleJsonLazy)->ArgsProduct({benchmark::CreateDenseRange(0, 32, 8), {0, 1}});
+
+static void BM_LoadModuleMarshal(benchmark::State& state) {
+    std::string bytes = makeNestedMarshal(state.range(0));
+
+    for (auto _ : state) {
+        Code code = readCodeFromMarshal(bytes, MARSHAL_MAGIC_310);
+        benchmark::DoNotOptimize(code);
+    }
+    state.SetBytesProcessed(state.iterations() * bytes.size());
+}
+BENCHMARK(BM_LoadModuleMarshal)->DenseRange(0, 32, 8);
+
+// Laço completo do gerenciador: divisão do fluxo, despacho e geração do payload de resposta.
+// O segundo argumento liga a coleta de métricas, para medir o custo da instrumentação
+static void BM_DispatchLoop(benchmark::State& state) {
+    int depth = state.range(0);
+    bool instrumented = state.range(1) != 0;
+    Code root = makeCallChain(depth);
+    std::vector<uint8_t> trace = makeTrace(depth);
+    Metrics metrics;
+
+    for (auto _ : state) {
+        auto segments = splitByDelimiters(trace, recordSeparator[0], recordSeparator[1]);
+        Dispatcher dispatcher(root);
+        if (instrumented) dispatcher.setMetrics(&metrics);
+        for (const auto& segment : segments) {
+            if (dispatcher.dispatch(segment) == INSTR_CALL_FUNCTION) {
+                std::string response = dispatcher.currentPayload();
+                if (instrumented) metrics.recordEncoded(response.size());
+                benchmark::DoNotOptimize(response);
+            }
+        }
+    }
+    state.counters["records"] = benchmark::Counter(
+        static_cast<double>(state.iterations()) * (2 * depth + 1), benchmark::Counter::kIsRate);
+    state.SetLabel(instrumented ? "metrics" : "plain");
+}
+BENCHMARK(BM_DispatchLoop)->ArgsProduct({{1, 4, 16, 64, 256}, {0, 1}});
+
+// Fluxo com 'calls' pares CALL_FUNCTION/RETURN a partir do frame raiz, cada chamada com
+// varnames de 'size' valores mistos, e o mesmo laço aplicado em sequência (0) ou com a
+// divisão e a decodificação dos payloads em outra thread (1, ver Pipeline.hpp)
+static void BM_PipelinedDispatch(benchmark::State& state) {
+    int size = state.range(0);
+    bool pipelined = state.range(1) != 0;
+    const int calls = 1024;
+    Code root = makeCallChain(1);
+
+    Code caller;
+    caller.setCoNames(std::vector<VarType>{0});
+    caller.setCoVarnames(makeVector(size, MIX_MIXED));
+    std::string callPayload = caller.generateInputTestPayload({});
+    std::vector<uint8_t> trace{INSTR_INIT, recordSeparator[0], recordSeparator[1]};
+    for (int i = 0; i < calls; ++i) {
+        trace.insert(trace.end(), {INSTR_CALL_FUNCTION, 1, 0});
+        trace.insert(trace.end(), callPayload.begin(), callPayload.end());
+        trace.insert(trace.end(), {recordSeparator[0], recordSeparator[1], INSTR_RETURN, recordSeparator[0], recordSeparator[1]});
+    }
+
+    for (auto _ : state) {
+        Dispatcher dispatcher(root);
+        auto apply = [&](const std::vector<uint8_t>& segment, DecodedPayload* decoded) {
+            if (dispatcher.dispatch(segment, decoded) == INSTR_CALL_FUNCTION) {
+                std::string response = dispatcher.currentPayload();
+                benchmark::DoNotOptimize(response);
+            }
+        };
+        if (pipelined) {
+            runPipeline(trace, dispatcher.decodeOptions(), [&](DecodedRecord& record) {
+                apply(record.segment, record.decodedPayload());
+            });
+        } else {
+            for (const auto& segment : splitByDelimiters(trace, recordSeparator[0], recordSeparator[1])) {
+                apply(segment, nullptr);
+            }
+        }
+    }
+    state.counters["records"] = benchmark::Counter(
+        static_cast<double>(state.iterations()) * (2 * calls + 1), benchmark::Counter::kIsRate);
+    state.SetLabel(pipelined ? "pipeline" : "serial");
+}
+BENCHMARK(BM_PipelinedDispatch)->ArgsProduct({{8, 64, 512}, {0, 1}})->UseRealTime();
+
+// Validação de um fluxo de cerca de 8 MiB (chamadas com 64 valores mistos) em 'threads' threads
+static void BM_ValidateTrace(benchmark::State& state) {
+    Code caller;
+    caller.setCoNames(std::vector<VarType>{0});
+    caller.setCoVarnames(makeVector(64, MIX_MIXED));
+    std::string callPayload = caller.generateInputTestPayload({});
+    std::vector<uint8_t> trace{INSTR_INIT, recordSeparator[0], recordSeparator[1]};
+    while (trace.size() < (8 << 20)) {
+        trace.insert(trace.end(), {INSTR_CALL_FUNCTION, 1, 0});
+        trace.insert(trace.end(), callPayload.begin(), callPayload.end());
+        trace.insert(trace.end(), {recordSeparator[0], recordSeparator[1], INSTR_RETURN, recordSeparator[0], recordSeparator[1]});
+    }
+
+    ValidationOptions options;
+    options.threads = static_cast<unsigned>(state.range(0));
+    for (auto _ : state) {
+        ValidationReport report = validateTrace(trace, options);
+        benchmark::DoNotOptimize(report);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * trace.size());
+}
+BENCHMARK(BM_ValidateTrace)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+// Acesso ao registro do meio de um fluxo de 64k chamadas: 0 divide o fluxo inteiro com
+// splitByDelimiters, 1 monta o índice, 2 lê o índice já gravado, confere que corresponde
+// ao fluxo (CRC32C) e vai direto ao registro
+static void BM_TraceIndexSeek(benchmark::State& state) {
+    int mode = state.range(0);
+    std::vector<uint8_t> trace = makeTrace(32 * 1024);
+    std::string path = (std::filesystem::temp_directory_path() / "codeframe_bench_trace.idx").string();
+    TraceIndex::build(trace).save(path);
+    size_t target = 32 * 1024;
+
+    for (auto _ : state) {
+        if (mode == 0) {
+            auto segments = splitByDelimiters(trace, recordSeparator[0], recordSeparator[1]);
+            benchmark::DoNotOptimize(segments[target].data());
+        } else {
+            TraceIndex index = mode == 1 ? TraceIndex::build(trace) : TraceIndex::load(path, IoBackend::Posix);
+            if (mode == 2 && !index.matches(trace)) {
+                state.SkipWithError("índice não corresponde ao fluxo");
+                break;
+            }
+            benchmark::DoNotOptimize(index.record(trace, target).data());
+        }
+    }
+    std::filesystem::remove(path);
+    state.SetLabel(mode == 0 ? "split" : mode == 1 ? "build" : "load");
+}
+BENCHMARK(BM_TraceIndexSeek)->DenseRange(0, 2);
+
+// Retomada de uma sessão com 'depth' chamadas em andamento: argumento 1 = 0 reaplica os
+// registros desde o INIT, 1 lê o checkpoint gravado naquele ponto e o restaura
+static void BM_CheckpointRestore(benchmark::State& state) {
+    const int depth = static_cast<int>(state.range(0));
+    bool restore = state.range(1) != 0;
+    Code root = makeCallChain(depth);
+    auto segments = splitByDelimiters(makeTrace(depth), recordSeparator[0], recordSeparator[1]);
+    segments.resize(depth + 1);
+    std::string path = (std::filesystem::temp_directory_path() / "codeframe_bench.ckpt").string();
+    {
+        Dispatcher dispatcher(root);
+        for (const auto& segment : segments) dispatcher.dispatch(segment);
+        CheckpointWriter writer(path, root);
+        writer.capture(dispatcher.state(), segments.size());
+        writer.close();
+    }
+
+    for (auto _ : state) {
+        Dispatcher dispatcher(root);
+        if (restore) {
+            SavedSession saved = readCheckpoint(path, root);
+            dispatcher.restore(saved);
+        } else {
+            for (const auto& segment : segments) dispatcher.dispatch(segment);
+        }
+        benchmark::DoNotOptimize(dispatcher.current());
+    }
+    state.counters["checkpoint_bytes"] = static_cast<double>(std::filesystem::file_size(path));
+    std::filesystem::remove(path);
+    state.SetLabel(restore ? "restore" : "replay");
+}
+BENCHMARK(BM_CheckpointRestore)->ArgsProduct({{8, 64, 512}, {0, 1}});
+
+// Várias sessões intercaladas na mesma thread, cada uma com uma pilha de 8 chamadas em
+// andamento: pilha explícita (Dispatcher) contra frames em corrotinas (FrameExecutor)
+template <typename Session>
+static void BM_MultiplexedSessions(benchmark::State& state) {
+    const int depth = 8;
+    Code root = makeCallChain(depth);
+    auto segments = splitByDelimiters(makeTrace(depth), recordSeparator[0], recordSeparator[1]);
+
+    for (auto _ : state) {
+        std::vector<std::unique_ptr<Session>> sessions;
+        sessions.reserve(state.range(0));
+        for (int i = 0; i < state.range(0); ++i) {
+            sessions.push_back(std::make_unique<Session>(root));
+        }
+        for (const auto& segment : segments) {
+            for (auto& session : sessions) {
+                session->dispatch(segment);
+            }
+        }
+    }
+    state.counters["records"] = benchmark::Counter(
+        static_cast<double>(state.iterations()) * state.range(0) * segments.size(), benchmark::Counter::kIsRate);
+}
+BENCHMARK_TEMPLATE(BM_MultiplexedSessions, Dispatcher)->RangeMultiplier(8)->Range(1, 4096);
+BENCHMARK_TEMPLATE(BM_MultiplexedSessions, FrameExecutor)->RangeMultiplier(8)->Range(1, 4096);
+
+// Resposta a um CALL_FUNCTION no protocolo completo (argumento 0) e no modo por id de
+// frame (argumento 1), em que co_code e co_consts já foram enviados na tabela de frames
+static void BM_CallResponse(benchmark::State& state) {
+    bool frameIds = state.range(0) != 0;
+    Code root = makeCallChain(1);
+    CodeTable table(root);
+    Dispatcher dispatcher(root);
+    if (frameIds) dispatcher.setCodeTable(&table);
+    std::vector<uint8_t> call = splitByDelimiters(makeTrace(1), recordSeparator[0], recordSeparator[1])[1];
+    dispatcher.dispatch(call);
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        std::string response = dispatcher.currentPayload();
+        bytes = response.size();
+        benchmark::DoNotOptimize(response);
+    }
+    state.counters["response_bytes"] = static_cast<double>(bytes);
+    state.SetLabel(frameIds ? "frame-ids" : "full");
+}
+BENCHMARK(BM_CallResponse)->Arg(0)->Arg(1);
+
+// Resposta do frame raiz de um módulo com 'depth' funções aninhadas, sem (argumento 1 = 0)
+// e com os Codes filhos embutidos até 'inline' níveis. O contador round_trips conta as
+// chamadas extras que o mestre ainda precisa fazer para obter a subárvore inteira
+static void BM_NestedPayload(benchmark::State& state) {
+    const int depth = static_cast<int>(state.range(0));
+    const unsigned inlineDepth = static_cast<unsigned>(state.range(1));
+    Code root = readCodeFromJson(makeNestedJson(depth));
+    std::vector<VarType> globals = root.co_names;
+    PayloadOptions options{nullptr, PayloadCodec::V1, inlineDepth};
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        std::string payload = root.generatePayload(globals, root.tables(), options);
+        bytes += payload.size();
+        benchmark::DoNotOptimize(payload);
+    }
+    state.counters["payload_bytes"] =
+        static_cast<double>(root.generatePayload(globals, root.tables(), options).size());
+    state.counters["round_trips"] = static_cast<double>(std::max(0, depth - static_cast<int>(inlineDepth)));
+    state.SetBytesProcessed(bytes);
+}
+BENCHMARK(BM_NestedPayload)->ArgsProduct({{1, 8, 32}, {0, 1, 8, 32}});
+
+// Cadeia de makeCallChain em que cada frame carrega o filho com LOAD_CONST 0 e
+// MAKE_FUNCTION antes do corpo, como o bytecode real de uma função que define outra
+void prependMakeFunction(Code& code) {
+    code.setCoCode("64008400" + code.getCoCode());
+    for (auto& child : code.children) {
+        prependMakeFunction(*child);
+    }
+}
+
+// Tempo de resposta às chamadas de um fluxo com 'depth' CALL_FUNCTION, sem (argumento 1 = 0)
+// e com pré-busca. Cada iteração parte de frames sem payload pré-codificado. O contador
+// response_ns é a média, por chamada, do caminho crítico inteiro: dispatch (com o apply e
+// o enter da pré-busca) mais currentPayload. idle_ns é o encodePending feito depois da
+// resposta, como nos laços do gerenciador, que no modo --shm se sobrepõe ao mestre
+static void BM_Prefetch(benchmark::State& state) {
+    const int depth = static_cast<int>(state.range(0));
+    const bool prefetch = state.range(1) != 0;
+    Code root = makeCallChain(depth);
+    prependMakeFunction(root);
+    auto segments = splitByDelimiters(makeTrace(depth), recordSeparator[0], recordSeparator[1]);
+    CalleeIndex index(root);
+    std::vector<Code*> codes{&root};
+    for (size_t i = 0; i < codes.size(); ++i) {
+        for (auto& child : codes[i]->children) codes.push_back(child.get());
+    }
+    std::chrono::nanoseconds responseTime{0};
+    std::chrono::nanoseconds idleTime{0};
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (Code* code : codes) code->payloadPrecomputed = false;
+        state.ResumeTiming();
+
+        Dispatcher dispatcher(root);
+        Prefetcher prefetcher(index);
+        if (prefetch) dispatcher.setPrefetcher(&prefetcher);
+        for (const auto& segment : segments) {
+            auto start = std::chrono::steady_clock::now();
+            if (dispatcher.dispatch(segment) == INSTR_CALL_FUNCTION) {
+                std::string response = dispatcher.currentPayload();
+                responseTime += std::chrono::steady_clock::now() - start;
+                benchmark::DoNotOptimize(response);
+            }
+            if (prefetch) {
+                auto idle = std::chrono::steady_clock::now();
+                prefetcher.encodePending();
+                idleTime += std::chrono::steady_clock::now() - idle;
+            }
+        }
+    }
+    state.counters["response_ns"] = static_cast<double>(responseTime.count()) / (state.iterations() * depth);
+    state.counters["idle_ns"] = static_cast<double>(idleTime.count()) / (state.iterations() * depth);
+    state.SetLabel(prefetch ? "prefetch" : "plain");
+}
+BENCHMARK(BM_Prefetch)->ArgsProduct({{4, 64}, {0, 1}});
+
+// Resolução do Code chamado em um call site quente: busca completa em getCodeFromVariable
+// (argumento 0) contra o cache da ativação em FrameStack::resolveCall (argumento 1)
+static void BM_ResolveCall(benchmark::State& state) {
+    bool cached = state.range(0) != 0;
+    Code root = makeCallChain(1);
+    std::vector<VarType> globals;
+    FrameStack frames;
+    frames.push(root);
+
+    for (auto _ : state) {
+        Code* target = cached ? &frames.resolveCall(globals, 1, 0)
+                              : &root.getCodeFromVariable(globals, frames.topTables(), 1, 0);
+        benchmark::DoNotOptimize(target);
+    }
+    const CallCacheStats& stats = frames.callCacheStats();
+    state.counters["hits"] = static_cast<double>(stats.hits);
+    state.SetLabel(cached ? "cache" : "lookup");
+}
+BENCHMARK(BM_ResolveCall)->Arg(0)->Arg(1);
+
+// Chamadas recursivas de um mesmo Code: cada CALL_FUNCTION empilha uma ativação nova
+// na FrameStack da sessão, que é reaproveitada de uma iteração para a outra
+template <typename Session>
+static void BM_RecursiveCalls(benchmark::State& state) {
+    int depth = state.range(0);
+    Code function(SAMPLE_CO_CODE);
+    function.setCoNames(std::vector<VarType>{0});
+    function.setCoVarnames(std::vector<VarType>{nullptr, nullptr});
+    function.setCoConsts(std::vector<VarType>{&function, nullptr, "recursive"});
+
+    auto segments = splitByDelimiters(makeTrace(depth), recordSeparator[0], recordSeparator[1]);
+    segments.erase(segments.begin());  // Sem o INIT: a sessão fica aberta entre iterações
+    Session session(function);
+
+    for (auto _ : state) {
+        for (const auto& segment : segments) {
+            session.dispatch(segment);
+        }
+    }
+    state.counters["records"] = benchmark::Counter(
+        static_cast<double>(state.iterations()) * segments.size(), benchmark::Counter::kIsRate);
+}
+BENCHMARK_TEMPLATE(BM_RecursiveCalls, Dispatcher)->RangeMultiplier(4)->Range(1, 256);
+BENCHMARK_TEMPLATE(BM_RecursiveCalls, FrameExecutor)->RangeMultiplier(4)->Range(1, 256);
+
+// Módulo compilado pelo CPython 3.10 (JSON de pyc_serializer.py):
+//
+//   def run(n):
+//       def fib(k):
+//           if k < 2:
+//               return k
+//           return fib(k - 1) + fib(k - 2)
+//       total = 0
+//       i = 0
+//       while i < n:
+//           total += i * 3 % 7
+//           i += 1
+//       return total + fib(12)
+//   result = run(2000)
+const char* const EMULATOR_MODULE_JSON =
+    R"({"co_code":"6400640184005a006500640283015a0164035300","co_names":["run","result"],"co_varnames":)"
+    R"([],"co_freevars":[],"co_cellvars":[],"co_argcount":0,"co_consts":[{"co_code":"870066016401640284)"
+    R"(08890064037d0164037d027c027c006b00721e7c017c02640414006405160037007d017c02640637007d027c027c006b)"
+    R"(00730e7c0188006407830117005300","co_names":[],"co_varnames":["n","total","i"],"co_freevars":[],")"
+    R"(co_cellvars":["fib"],"co_argcount":1,"co_consts":[null,{"co_code":"7c0064016b0072067c00530088007)"
+    R"(c0064021800830188007c0064011800830117005300","co_names":[],"co_varnames":["k"],"co_freevars":["f)"
+    R"(ib"],"co_cellvars":[],"co_argcount":1,"co_consts":[null,2,1]},"run.<locals>.fib",0,3,7,1,12]},"r)"
+    R"(un",2000,null]})";
+
+// Mestre emulado executando o módulo acima, com os registros aplicados a um Dispatcher.
+// Argumento 1: com a tabela de frames, cada chamada recursiva de fib também vira um
+// CALL_FRAME; sem ela, só run é espelhada no gerenciador
+static void BM_MasterEmulator(benchmark::State& state) {
+    const bool frameIds = state.range(0) != 0;
+    Code root = readCodeFromJson(nlohmann::json::parse(EMULATOR_MODULE_JSON));
+    CodeTable table(root);
+    EmulatorOptions options;
+    options.codeTable = frameIds ? &table : nullptr;
+    uint64_t instructions = 0;
+    uint64_t records = 0;
+
+    for (auto _ : state) {
+        Dispatcher dispatcher(root);
+        dispatcher.setCodeTable(options.codeTable);
+        auto sink = [&dispatcher](const std::vector<uint8_t>& record) {
+            uint8_t instruction = dispatcher.dispatch(record);
+            if (instruction == INSTR_CALL_FUNCTION || instruction == INSTR_CALL_FRAME) {
+                std::string response = dispatcher.currentPayload();
+                benchmark::DoNotOptimize(response);
+            }
+        };
+        EmulatorReport report = runMasterEmulator(root, sink, options);
+        instructions += report.instructions;
+        records += report.records;
+    }
+    state.counters["instructions"] = benchmark::Counter(static_cast<double>(instructions), benchmark::Counter::kIsRate);
+    state.counters["records"] = benchmark::Counter(static_cast<double>(records), benchmark::Counter::kIsRate);
+    state.SetLabel(frameIds ? "frame-ids" : "call-function");
+}
+BENCHMARK(BM_MasterEmulator)->Arg(0)->Arg(1);
+
+// Despacho de opcodes isolado: o emulador sem registros nem print, com (1) e sem (0)
+// superinstruções. O contador instructions é o mesmo nos dois casos
+static void BM_OpcodeDispatch(benchmark::State& state) {
+    Code root = readCodeFromJson(nlohmann::json::parse(EMULATOR_MODULE_JSON));
+    predecodeBytecode(root);
+    EmulatorOptions options;
+    options.superinstructions = state.range(0) != 0;
+    auto sink = [](const std::vector<uint8_t>& record) { benchmark::DoNotOptimize(record.data()); };
+    uint64_t instructions = 0;
+
+    for (auto _ : state) {
+        EmulatorReport report = runMasterEmulator(root, sink, options);
+        instructions += report.instructions;
+    }
+    state.counters["instructions"] = benchmark::Counter(static_cast<double>(instructions), benchmark::Counter::kIsRate);
+    state.SetLabel(options.superinstructions ? "superinstructions" : "plain");
+}
+BENCHMARK(BM_OpcodeDispatch)->Arg(0)->Arg(1);
+
+// Custo da pré-decodificação de um co_code, feita uma vez por texto na carga
+static void BM_DecodeBytecode(benchmark::State& state) {
+    Code root = readCodeFromJson(nlohmann::json::parse(EMULATOR_MODULE_JSON));
+    std::vector<const std::string*> texts;
+    std::vector<Code*> pending{&root};
+    while (!pending.empty()) {
+        Code* code = pending.back();
+        pending.pop_back();
+        texts.push_back(code->co_code.get());
+        for (auto& child : code->children) pending.push_back(child.get());
+    }
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        for (const std::string* text : texts) {
+            Bytecode bytecode(*text);
+            benchmark::DoNotOptimize(bytecode.size());
+            bytes += text->size() / 2;
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_DecodeBytecode);
+
+// Ida e volta de um registro de 64 bytes pelos anéis em memória compartilhada, com uma
+// thread que devolve cada registro. Arg: 0 espera ativa, 1 futex
+static void BM_SharedRingRoundTrip(benchmark::State& state) {
+    const WaitMode mode = state.range(0) == 0 ? WaitMode::BusyPoll : WaitMode::Futex;
+    SharedChannel channel = SharedChannel::anonymous(1 << 16);
+    std::thread echo([&channel, mode]() {
+        std::vector<uint8_t> record;
+        while (channel.instructions().read(record, mode)) {
+            channel.responses().write(record, mode);
+        }
+    });
+    std::vector<uint8_t> record(64, 0x83);
+    std::vector<uint8_t> response;
+
+    for (auto _ : state) {
+        channel.instructions().write(record, mode);
+        channel.responses().read(response, mode);
+    }
+    channel.instructions().close();
+    echo.join();
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(mode == WaitMode::BusyPoll ? "poll" : "futex");
+}
+BENCHMARK(BM_SharedRingRoundTrip)->Arg(0)->Arg(1)->UseRealTime();
+
+// Arquivo de 16 MiB de registros para os benchmarks de E/S, criado uma vez
+const std::string& ioBenchmarkFile() {
+    static const std::string path = []() {
+        std::string file = (std::filesystem::temp_directory_path() / "codeframe_io_benchmark.bin").string();
+        std::vector<uint8_t> data;
+        while (data.size() < (16u << 20)) {
+            data.insert(data.end(), {0x83, 0x00, 0x01, 0x1d, 0x1f, 0x01, 0x2a, 0x00, 0x00, 0x00, 0x1d, 0x03, 0x02});
+        }
+        writeOutput(file, data);
+        return file;
+    }();
+    return path;
+}
+
+// Leitura do fluxo de instruções inteiro. Arg: 0 iostream, 1 read, 2 io_uring
+static void BM_ReadInput(benchmark::State& state) {
+    const IoBackend backend = static_cast<IoBackend>(state.range(0));
+    const std::string& path = ioBenchmarkFile();
+    IoStats stats;
+
+    for (auto _ : state) {
+        std::vector<uint8_t> data = readInput(path, backend, &stats);
+        benchmark::DoNotOptimize(data.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(stats.bytes));
+    state.counters["syscalls"] = benchmark::Counter(static_cast<double>(stats.syscalls) / state.iterations());
+    state.SetLabel(ioBackendName(stats.backend));
+}
+BENCHMARK(BM_ReadInput)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond);
+
+// Gravação de 16 MiB em registros de 256 bytes, como o traço do emulador
+static void BM_WriteOutput(benchmark::State& state) {
+    const IoBackend backend = static_cast<IoBackend>(state.range(0));
+    std::string path = (std::filesystem::temp_directory_path() / "codeframe_io_output.bin").string();
+    std::vector<uint8_t> record(256, 0x2a);
+    uint64_t bytes = 0;
+    IoBackend used = backend;
+
+    for (auto _ : state) {
+        OutputFile out(path, backend);
+        for (size_t written = 0; written < (16u << 20); written += record.size()) {
+            out.write(record);
+        }
+        out.flush();
+        bytes += out.stats().bytes;
+        used = out.stats().backend;
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+    state.SetLabel(ioBackendName(used));
+}
+BENCHMARK(BM_WriteOutput)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond);
+
+// Custo isolado de uma amostra no histograma de latência
+static void BM_LatencyHistogramRecord(benchmark::State& state) {
+    LatencyHistogram histogram;
+    uint64_t value = 1;
+
+    for (auto _ : state) {
+        histogram.record(value);
+        value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+        value >>= 44;
+    }
+    benchmark::DoNotOptimize(histogram.percentile(99.0));
+}
+BENCHMARK(BM_LatencyHistogramRecord);
+
+BENCHMARK_MAIN();
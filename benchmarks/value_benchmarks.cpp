@@ -0,0 +1,98 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <variant>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "Value.hpp"
+
+/*
+    * Ocupação de memória por posição dos vetores de variáveis e constantes:
+    * o std::variant antigo, que embutia um Code inteiro em cada posição, contra o
+    * Value de 16 bytes. Os bytes alocados são contados substituindo o operator new, por
+    * isso este arquivo é compilado em um executável próprio (value_benchmarks).
+*/
+
+namespace {
+
+std::atomic<size_t> allocatedBytes{0};
+
+// Réplica do layout antigo: VarType = std::variant<Code, int, bool, std::string, std::nullptr_t, float>
+struct LegacyCode;
+using LegacyVarType = std::variant<LegacyCode, int, bool, std::string, std::nullptr_t, float>;
+struct LegacyCode {
+    std::string co_code;
+    std::vector<LegacyVarType> co_names;
+    std::vector<LegacyVarType> co_varnames;
+    std::vector<LegacyVarType> co_freevars;
+    std::vector<LegacyVarType> co_cellvars;
+    std::vector<LegacyVarType> co_consts;
+};
+
+enum SlotMix { SLOTS_NULL = 0, SLOTS_INT = 1, SLOTS_SHORT_STRING = 2, SLOTS_MIXED = 3 };
+
+const char* slotMixName(int mix) {
+    switch (mix) {
+        case SLOTS_NULL: return "null";
+        case SLOTS_INT: return "int";
+        case SLOTS_SHORT_STRING: return "short-string";
+        default: return "mixed";
+    }
+}
+
+// Composição "mixed" inclui nomes longos como "add_numbers.<locals>.subtract_numbers"
+template <typename Slot>
+void fillSlots(std::vector<Slot>& slots, size_t count, int mix) {
+    for (size_t i = 0; i < count; ++i) {
+        int kind = (mix == SLOTS_MIXED) ? static_cast<int>(i % 5) : mix;
+        switch (kind) {
+            case SLOTS_NULL: slots.emplace_back(nullptr); break;
+            case SLOTS_INT: slots.emplace_back(static_cast<int>(i)); break;
+            case SLOTS_SHORT_STRING: slots.emplace_back(std::string("add_numbers")); break;
+            case 3: slots.emplace_back(i % 2 == 0); break;
+            default: slots.emplace_back(std::string("add_numbers.<locals>.subtract_numbers")); break;
+        }
+    }
+}
+
+} // namespace
+
+void* operator new(size_t size) {
+    allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    std::free(ptr);
+}
+
+template <typename Slot>
+static void BM_SlotFootprint(benchmark::State& state) {
+    size_t count = state.range(0);
+    int mix = state.range(1);
+    size_t bytes = 0;
+
+    for (auto _ : state) {
+        size_t before = allocatedBytes.load(std::memory_order_relaxed);
+        std::vector<Slot> slots;
+        slots.reserve(count);
+        fillSlots(slots, count, mix);
+        bytes = allocatedBytes.load(std::memory_order_relaxed) - before;
+        benchmark::DoNotOptimize(slots.data());
+    }
+    state.counters["sizeof_slot"] = sizeof(Slot);
+    state.counters["bytes_per_slot"] = static_cast<double>(bytes) / count;
+    state.SetLabel(slotMixName(mix));
+}
+BENCHMARK_TEMPLATE(BM_SlotFootprint, LegacyVarType)
+    ->ArgsProduct({{4096}, {SLOTS_NULL, SLOTS_INT, SLOTS_SHORT_STRING, SLOTS_MIXED}});
+BENCHMARK_TEMPLATE(BM_SlotFootprint, Value)
+    ->ArgsProduct({{4096}, {SLOTS_NULL, SLOTS_INT, SLOTS_SHORT_STRING, SLOTS_MIXED}});
@@ -0,0 +1,28 @@
+# Executa o gerenciador sobre cada caso de teste do repositório.
+# Variáveis esperadas: MANAGER, SOURCE_DIR, WORK_DIR
+
+set(CASE_NAMES raiz caso2)
+set(raiz_JSON "${SOURCE_DIR}/code.json")
+set(raiz_TRACE "${SOURCE_DIR}/master_instructions.bin")
+set(caso2_JSON "${SOURCE_DIR}/casos de teste/caso 2/code - caso 2.json")
+set(caso2_TRACE "${SOURCE_DIR}/casos de teste/caso 2/master_instructions (caso 2).bin")
+
+foreach(CASE IN LISTS CASE_NAMES)
+  set(CASE_DIR "${WORK_DIR}/${CASE}")
+  file(MAKE_DIRECTORY "${CASE_DIR}")
+  configure_file("${${CASE}_JSON}" "${CASE_DIR}/code.json" COPYONLY)
+  configure_file("${${CASE}_TRACE}" "${CASE_DIR}/master_instructions.bin" COPYONLY)
+
+  # Modo normal e modo depuração, que também exercita a geração de payloads
+  foreach(ARGS IN ITEMS "" "-d")
+    execute_process(
+      COMMAND "${MANAGER}" ${ARGS}
+      WORKING_DIRECTORY "${CASE_DIR}"
+      OUTPUT_QUIET
+      RESULT_VARIABLE RESULT
+    )
+    if(NOT RESULT EQUAL 0)
+      message(FATAL_ERROR "Caso '${CASE}' (${ARGS}) falhou: ${RESULT}")
+    endif()
+  endforeach()
+endforeach()
@@ -0,0 +1,5 @@
+# Configuração instalada para find_package(codeframe)
+include(CMakeFindDependencyMacro)
+find_dependency(Threads)
+
+include("${CMAKE_CURRENT_LIST_DIR}/codeframeTargets.cmake")
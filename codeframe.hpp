@@ -0,0 +1,57 @@
+#ifndef CODEFRAME_H
+#define CODEFRAME_H
+
+/*
+    * API pública da biblioteca codeframe.
+    *
+    *   - Value.hpp:      valor compacto de 16 bytes dos vetores de variáveis e constantes
+    *   - Symbols.hpp:    tabelas de strings do modo de símbolos
+    *   - Code.hpp:       objeto-código e codificação/decodificação de payloads
+    *   - Loader.hpp:     leitura do JSON de objetos-código e do fluxo de instruções
+    *   - Marshal.hpp:    leitura direta de arquivos .pyc
+    *   - Frame.hpp:      registros de ativação em uma pilha contígua, separados do Code
+    *   - CodeTable.hpp:  tabela plana de frames do modo de protocolo por id de frame
+    *   - Dedup.hpp:      deduplicação por conteúdo de co_code e de Codes idênticos
+    *   - Bytecode.hpp:   co_code pré-decodificado, com saltos absolutos e superinstruções
+    *   - Prefetch.hpp:   varredura de chamadas no co_code e pré-busca dos frames filhos
+    *   - Emulator.hpp:   mestre emulado que interpreta o co_code e emite as instruções
+    *   - SharedRing.hpp: anéis em memória compartilhada entre o mestre e o gerenciador
+    *   - IoBackend.hpp:  leitura do fluxo de instruções e gravação de arquivos por io_uring ou read/write
+    *   - Pipeline.hpp:   decodificação dos registros em outra thread, em paralelo com a aplicação
+    *   - Validation.hpp: validação paralela do fluxo de instruções antes da execução
+    *   - TraceIndex.hpp: índice de acesso aleatório aos registros do fluxo, gravado ao lado dele
+    *   - Checkpoint.hpp: checkpoint do estado da sessão, gravado em segundo plano e restaurado
+    *   - Dispatcher.hpp: navegação entre frames e aplicação das instruções do mestre
+    *   - FrameExecutor.hpp: alternativa ao Dispatcher com cada frame em uma corrotina
+    *   - Metrics.hpp:    contadores e histogramas de latência do despacho
+    *
+    * A biblioteca não mantém estado global nem escreve no console: cada Dispatcher é
+    * uma sessão independente e pode ser conduzido pelo laço de eventos da aplicação.
+*/
+
+#define CODEFRAME_VERSION_MAJOR 1
+#define CODEFRAME_VERSION_MINOR 0
+#define CODEFRAME_VERSION_PATCH 0
+
+#include "Value.hpp"
+#include "Symbols.hpp"
+#include "Code.hpp"
+#include "Loader.hpp"
+#include "Marshal.hpp"
+#include "Frame.hpp"
+#include "CodeTable.hpp"
+#include "Dedup.hpp"
+#include "Bytecode.hpp"
+#include "Prefetch.hpp"
+#include "Emulator.hpp"
+#include "SharedRing.hpp"
+#include "IoBackend.hpp"
+#include "Pipeline.hpp"
+#include "Validation.hpp"
+#include "TraceIndex.hpp"
+#include "Checkpoint.hpp"
+#include "Dispatcher.hpp"
+#include "FrameExecutor.hpp"
+#include "Metrics.hpp"
+
+#endif
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "Code.hpp"
+#include "Loader.hpp"
+#include "CodeTable.hpp"
+#include "Dispatcher.hpp"
+#include "FrameExecutor.hpp"
+#include "Emulator.hpp"
+#include "Bytecode.hpp"
+#include "Metrics.hpp"
+#include "SharedRing.hpp"
+#include "IoBackend.hpp"
+
+/*
+    * Mestre local: executa o módulo de --code (JSON ou .pyc) no emulador e grava os
+    * registros emitidos em --out, no formato de master_instructions.bin. Com --run, cada
+    * registro também é aplicado na hora a um gerenciador no mesmo processo, que responde
+    * às chamadas com o payload do frame, como faria pelo canal com o mestre real. Com
+    * --shm, os registros vão pelo anel em memória compartilhada a um gerenciador em outro
+    * processo (./gerenciador --shm=<nome>), e cada um espera a resposta dele.
+    *
+    * Os payloads usam a codificação V2 por padrão: na V1 os inteiros viajam como 4 bytes
+    * crus, que podem conter os separadores do payload, e o gerenciador só decodifica o
+    * primeiro deles. A V1 (--codec=1) só grava o traço, sem --run nem --shm.
+*/
+
+namespace {
+const uint8_t RECORD_SEPARATOR[2] = {0x03, 0x02};
+
+struct Options {
+    std::string codeFile = "code.json";
+    std::string outFile = "master_instructions.bin";
+    bool run = false;
+    bool coroutines = false;
+    bool frameIds = false;
+    bool quiet = false;
+    bool superinstructions = true;
+    PayloadCodec codec = PayloadCodec::V2;
+    unsigned repeat = 1;
+    std::string shmName;
+    WaitMode waitMode = WaitMode::Futex;
+    IoBackend ioBackend = IoBackend::Stream;
+};
+
+const uint8_t ACK = 0x06;
+
+// Gerenciador no mesmo processo: aplica cada registro e gera a resposta das chamadas
+template <typename Session>
+class LocalManager {
+public:
+    LocalManager(Code& code, const Options& options, const CodeTable* codeTable) : session(code) {
+        session.setCodeTable(codeTable);
+        session.setCodec(options.codec);
+    }
+
+    void apply(const std::vector<uint8_t>& record) {
+        session.dispatch(record);
+        if (record[0] == INSTR_CALL_FUNCTION || record[0] == INSTR_CALL_FRAME) {
+            responseBytes += session.currentPayload().size();
+        }
+    }
+
+    uint64_t responseBytes = 0;
+
+private:
+    Session session;
+};
+
+// Gerenciador em outro processo, pelo anel em memória compartilhada: cada registro é uma
+// ida e volta, medida no histograma
+class SharedManager {
+public:
+    SharedManager(const std::string& name, WaitMode waitMode)
+        : channel(SharedChannel::open(name, std::chrono::seconds(5))), waitMode(waitMode) {}
+
+    void apply(const std::vector<uint8_t>& record) {
+        auto start = std::chrono::steady_clock::now();
+        channel.instructions().write(record, waitMode);
+        if (!channel.responses().read(response, waitMode)) {
+            throw std::runtime_error("o gerenciador fechou o canal de memória compartilhada");
+        }
+        roundTrips.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+        if (response.empty() || response[0] != ACK) {
+            throw std::runtime_error("resposta do gerenciador sem ACK");
+        }
+        responseBytes += response.size() - 1;
+    }
+
+    // Fim do fluxo: o gerenciador sai do laço depois de responder ao que já recebeu
+    void close() { channel.instructions().close(); }
+
+    LatencyHistogram roundTrips;
+    uint64_t responseBytes = 0;
+
+private:
+    SharedChannel channel;
+    WaitMode waitMode;
+    std::vector<uint8_t> response;
+};
+
+template <typename Session>
+EmulatorReport emulate(Code& code, const Options& options, const CodeTable* codeTable, SharedManager* remote,
+                       std::vector<uint8_t>& trace, uint64_t& responseBytes) {
+    EmulatorOptions emulatorOptions;
+    emulatorOptions.codeTable = codeTable;
+    emulatorOptions.codec = options.codec;
+    emulatorOptions.output = options.quiet ? nullptr : &std::cout;
+    emulatorOptions.superinstructions = options.superinstructions;
+
+    std::unique_ptr<LocalManager<Session>> manager;
+    if (options.run) {
+        manager = std::make_unique<LocalManager<Session>>(code, options, codeTable);
+    }
+    auto sink = [&](const std::vector<uint8_t>& record) {
+        trace.insert(trace.end(), record.begin(), record.end());
+        trace.insert(trace.end(), RECORD_SEPARATOR, RECORD_SEPARATOR + 2);
+        if (manager) manager->apply(record);
+        if (remote) remote->apply(record);
+    };
+    EmulatorReport report = runMasterEmulator(code, sink, emulatorOptions);
+    if (manager) responseBytes += manager->responseBytes;
+    return report;
+}
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg(argv[i]);
+            if (arg == "--run") {
+                options.run = true;
+            } else if (arg == "-c") {
+                options.coroutines = true;
+            } else if (arg == "--frame-ids") {
+                options.frameIds = true;
+            } else if (arg == "--quiet") {
+                options.quiet = true;
+            } else if (arg == "--no-superinstructions") {
+                options.superinstructions = false;
+            } else if (arg == "--codec=1" || arg == "--codec=2") {
+                options.codec = static_cast<PayloadCodec>(arg.back() - '0');
+            } else if (arg.rfind("--codec=", 0) == 0) {
+                std::cerr << "Unknown payload codec: " << arg.substr(8) << std::endl;
+                return 1;
+            } else if (arg.rfind("--repeat=", 0) == 0) {
+                options.repeat = std::max(1u, static_cast<unsigned>(std::stoul(arg.substr(9))));
+            } else if (arg.rfind("--shm=", 0) == 0) {
+                options.shmName = arg.substr(6);
+            } else if (arg.rfind("--shm-wait=", 0) == 0) {
+                options.waitMode = parseWaitMode(arg.substr(11));
+            } else if (arg.rfind("--io=", 0) == 0) {
+                options.ioBackend = parseIoBackend(arg.substr(5));
+            } else if (arg.rfind("--code=", 0) == 0) {
+                options.codeFile = arg.substr(7);
+            } else if (arg.rfind("--out=", 0) == 0) {
+                options.outFile = arg.substr(6);
+            }
+        }
+
+        if (options.codec == PayloadCodec::V1 && (options.run || !options.shmName.empty())) {
+            std::cerr << "--codec=1 cannot be used with --run or --shm: V1 payloads do not carry every int intact"
+                      << std::endl;
+            return 1;
+        }
+
+        Code code = readCodeFromFile(options.codeFile);
+        if (options.superinstructions) {
+            predecodeBytecode(code);
+        }
+        std::unique_ptr<CodeTable> codeTable;
+        if (options.frameIds) {
+            codeTable = std::make_unique<CodeTable>(code);
+        }
+
+        std::unique_ptr<SharedManager> remote;
+        if (!options.shmName.empty()) {
+            remote = std::make_unique<SharedManager>(options.shmName, options.waitMode);
+        }
+
+        // --repeat: o programa é executado várias vezes para medir a vazão; só a primeira
+        // execução imprime e só o traço dela é gravado
+        std::vector<uint8_t> trace;
+        EmulatorReport report;
+        uint64_t instructions = 0;
+        uint64_t records = 0;
+        uint64_t responseBytes = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned round = 0; round < options.repeat; ++round) {
+            std::vector<uint8_t> roundTrace;
+            report = options.coroutines
+                         ? emulate<FrameExecutor>(code, options, codeTable.get(), remote.get(), roundTrace, responseBytes)
+                         : emulate<Dispatcher>(code, options, codeTable.get(), remote.get(), roundTrace, responseBytes);
+            instructions += report.instructions;
+            records += report.records;
+            if (round == 0) {
+                trace = std::move(roundTrace);
+                options.quiet = true;
+            }
+        }
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (remote) {
+            remote->close();
+        }
+
+        OutputFile out(options.outFile, options.ioBackend);
+        out.write(trace);
+        out.flush();
+        IoStats io = out.stats();
+
+        report.write(std::cerr);
+        std::cerr << "emulator: " << options.repeat << " run(s) in " << seconds * 1e3 << " ms, "
+                  << static_cast<uint64_t>(instructions / seconds) << " instructions/s, "
+                  << static_cast<uint64_t>(records / seconds) << " records/s";
+        if (options.run) {
+            std::cerr << ", " << responseBytes << " response bytes";
+        }
+        std::cerr << std::endl;
+        if (options.ioBackend != IoBackend::Stream) {
+            std::cerr << "io: " << ioBackendName(io.backend) << ", " << io.bytes << " bytes in " << io.operations
+                      << " writes and " << io.syscalls << " syscalls" << std::endl;
+        }
+        if (remote) {
+            const LatencyHistogram& trips = remote->roundTrips;
+            std::cerr << "shm: " << trips.count() << " round trips, " << remote->responseBytes << " response bytes, mean "
+                      << static_cast<uint64_t>(trips.mean()) << " ns, p50 " << trips.percentile(50.0) << " ns, p99 "
+                      << trips.percentile(99.0) << " ns" << std::endl;
+        }
+
+        return report.error.empty() ? 0 : 1;
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+}
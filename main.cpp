@@ -9,260 +9,552 @@
 #include "include/json.hpp"
 #include <bitset>
 #include <iomanip>
+#include <csignal>
+#include <algorithm>
+#include <exception>
 #include "Code.hpp"
+#include "Loader.hpp"
+#include "CodeTable.hpp"
+#include "Dedup.hpp"
+#include "Prefetch.hpp"
+#include "Dispatcher.hpp"
+#include "FrameExecutor.hpp"
+#include "Metrics.hpp"
+#include "SharedRing.hpp"
+#include "IoBackend.hpp"
+#include "Pipeline.hpp"
+#include "Validation.hpp"
+#include "TraceIndex.hpp"
+#include "Checkpoint.hpp"
 
 
-// Função para ler o JSON e criar o objeto Code
-Code readCodeFromJson(const nlohmann::json& jsonData) {
-    Code codeObj;
-
-    codeObj.setCoCode(jsonData["co_code"].get<std::string>());
-
-    size_t namesSize = jsonData["co_names"].size();
-    size_t varnamesSize = jsonData["co_varnames"].size();
-    size_t freevarsSize = jsonData["co_freevars"].size();
-    size_t cellvarsSize = jsonData["co_cellvars"].size();
-
-    codeObj.setCoNames(std::vector<VarType>(namesSize, nullptr));
-    codeObj.setCoVarnames(std::vector<VarType>(varnamesSize, nullptr));
-    codeObj.setCoFreevars(std::vector<VarType>(freevarsSize, nullptr));
-    codeObj.setCoCellvars(std::vector<VarType>(cellvarsSize, nullptr));
-
-    std::vector<VarType> consts;
-    for (const auto& item : jsonData["co_consts"]) {
-        if (item.is_string()) {
-            consts.push_back(item.get<std::string>());
-        } else if (item.is_number_integer()) {
-            consts.push_back(item.get<int>());
-        } else if (item.is_boolean()) {
-            consts.push_back(item.get<bool>());
-        } else if (item.is_null()) {
-            consts.push_back(nullptr);
-        } else if (item.is_number_float()) {
-            consts.push_back(item.get<float>());
-        } else if (item.is_object()) {
-            consts.push_back(readCodeFromJson(item)); // Chamada recursiva
-        }
-    }
-    codeObj.setCoConsts(consts);
-
-    return codeObj;
+void printGreetings() {
+    std::cout << std::endl << "Welcome to... \033[36m" << std::endl;
+    std::cout <<   " ▗▄▄▖ ▗▄▖ ▗▄▄▄ ▗▄▄▄▖    ▗▄▄▄▖▗▄▄▖  ▗▄▖ ▗▖  ▗▖▗▄▄▄▖    ▗▄▄▖ ▗▄▄▖  ▗▄▖  ▗▄▄▖▗▄▄▄▖ ▗▄▄▖ ▗▄▄▖ ▗▄▖ ▗▄▄▖ " << std::endl;
+    std::cout <<   "▐▌   ▐▌ ▐▌▐▌  █▐▌       ▐▌   ▐▌ ▐▌▐▌ ▐▌▐▛▚▞▜▌▐▌       ▐▌ ▐▌▐▌ ▐▌▐▌ ▐▌▐▌   ▐▌   ▐▌   ▐▌   ▐▌ ▐▌▐▌ ▐▌" << std::endl;
+    std::cout <<   "▐▌   ▐▌ ▐▌▐▌  █▐▛▀▀▘    ▐▛▀▀▘▐▛▀▚▖▐▛▀▜▌▐▌  ▐▌▐▛▀▀▘    ▐▛▀▘ ▐▛▀▚▖▐▌ ▐▌▐▌   ▐▛▀▀▘ ▝▀▚▖ ▝▀▚▖▐▌ ▐▌▐▛▀▚▖" << std::endl;
+    std::cout <<   "▝▚▄▄▖▝▚▄▞▘▐▙▄▄▀▐▙▄▄▖    ▐▌   ▐▌ ▐▌▐▌ ▐▌▐▌  ▐▌▐▙▄▄▖    ▐▌   ▐▌ ▐▌▝▚▄▞▘▝▚▄▄▖▐▙▄▄▖▗▄▄▞▘▗▄▄▞▘▝▚▄▞▘▐▌ ▐▌" << std::endl;
+    std::cout <<   "" << std::endl;
+    std::cout << "" << std::endl << "\033[0m";                                                                                                    
 }
 
-Code readCodeFromJsonFile(const std::string& filename) {
-    std::ifstream inputFile(filename);
-    nlohmann::json jsonData;
+void printBinaryString(const std::string& binaryString) {
+    std::cout << "\033[36m";
 
-    if (!inputFile.is_open()) {
-        throw std::runtime_error("Could not open file: " + filename);
+    for (unsigned char c : binaryString) {
+        std::cout << std::hex << std::setfill('0') << std::setw(2) 
+                  << static_cast<int>(c) << " ";
     }
+    std::cout << std::dec << "\033[0m" << std::endl; // Retorna o manipulador para decimal
+}
 
-    inputFile >> jsonData;  // Lê o JSON do arquivo
-    return readCodeFromJson(jsonData); // Lê o primeiro Frame e retorna
+// Backend dos arquivos gravados em modo de depuração (--io)
+IoBackend outputBackend = IoBackend::Stream;
+
+// Salva o payload gerado em um arquivo binário
+void writePayloadToFile(const std::string& payload, const std::string& filename) {
+    try {
+        writeOutput(filename, std::span<const uint8_t>(reinterpret_cast<const uint8_t*>(payload.data()), payload.size()),
+                    outputBackend);
+    } catch (const std::runtime_error&) {
+        std::cerr << "Erro ao abrir o arquivo para escrita!" << std::endl;
+    }
 }
 
-// Pilha para gerenciar a navegação entre os objetos Code
-class CodeNavigator {
-private:
-    std::stack<Code*> navigationStack;
+// Pedido de despejo das métricas feito por sinal: SIGUSR1 (texto) ou SIGUSR2 (JSON)
+volatile std::sig_atomic_t metricsDumpRequest = 0;
 
-public:
-    // Adiciona um novo objeto Code à pilha
-    void push(Code* code) {
-        navigationStack.push(code);
+void requestMetricsDump(int signal) {
+    metricsDumpRequest = signal;
+}
+
+void dumpMetrics(const Metrics& metrics, const std::string& format) {
+    if (format == "json") {
+        metrics.writeJson(std::cerr);
+    } else {
+        metrics.writeText(std::cerr);
     }
+}
 
-    // Retorna o objeto Code no topo da pilha
-    Code* pop() {
-        if (navigationStack.empty()) {
-            throw std::runtime_error("Navigation stack is empty.");
-        }
-        Code* top = navigationStack.top();
-        navigationStack.pop();
-        return top;
+const uint8_t ACK = 0x06;
+
+// Registros não vazios do fluxo já recebidos, inclusive os ignorados: a posição gravada
+// nos checkpoints. Com --restore, os primeiros resumeAt são ignorados
+uint64_t recordsSeen = 0;
+uint64_t resumeAt = 0;
+
+// --checkpoint: estado da sessão capturado a cada checkpointEvery registros
+CheckpointWriter* checkpointWriter = nullptr;
+uint64_t checkpointEvery = 64;
+
+template <typename Session>
+void checkpointRecord(Session& dispatcher) {
+    if (checkpointWriter && recordsSeen % checkpointEvery == 0) {
+        checkpointWriter->capture(dispatcher.state(), recordsSeen);
     }
+}
 
-    // Retorna o objeto Code no topo da pilha sem removê-lo
-    Code* peek() {
-        if (navigationStack.empty()) {
-            throw std::runtime_error("Navigation stack is empty.");
+// Última captura, na posição final do fluxo (se checkpointRecord ainda não a fez), e
+// espera da gravação
+template <typename Session>
+void finishCheckpoint(Session& dispatcher) {
+    if (checkpointWriter) {
+        if (recordsSeen % checkpointEvery != 0) {
+            checkpointWriter->capture(dispatcher.state(), recordsSeen);
         }
-        return navigationStack.top();
+        checkpointWriter->close();
     }
+}
 
-    bool empty() {
-        return navigationStack.empty();
-    }
-};
+// --prefetch: fila de pré-busca da sessão
+Prefetcher* sessionPrefetcher = nullptr;
 
-std::string readPayloadFromFile(const std::string& filename) {
-    std::ifstream inputFile(filename, std::ios::binary);
-    if (!inputFile) {
-        throw std::runtime_error("Erro ao abrir o arquivo para leitura.");
+// Codifica os filhos que a pré-busca enfileirou; os laços abaixo a chamam depois que a
+// resposta do registro saiu, fora do caminho da chamada
+void encodePrefetched() {
+    if (sessionPrefetcher) {
+        sessionPrefetcher->encodePending();
     }
+}
 
-    // Move o ponteiro de leitura para o final do arquivo para obter o tamanho
-    inputFile.seekg(0, std::ios::end);
-    std::streamsize fileSize = inputFile.tellg();
-    inputFile.seekg(0, std::ios::beg);
+// Aplica um registro na sessão (Dispatcher ou FrameExecutor); false se foi ignorado.
+// decoded: payload já decodificado pela etapa de decodificação (ver Pipeline.hpp)
+// response: recebe o payload do novo frame nas chamadas (--shm). Ele é gerado uma vez só
+// por chamada, para a depuração e para a resposta: com --symbols, gerá-lo registra as
+// strings na tabela de saída, e um segundo payload só as referenciaria
+template <typename Session>
+bool processSegment(Session& dispatcher, const std::vector<uint8_t>& segment, bool DEBUG, Metrics& metrics,
+                    const CodeTable* codeTable, PayloadCodec codec, DecodedPayload* decoded = nullptr,
+                    std::string* response = nullptr) {
+    // apenas para DEBUG
+    std::string ackString(1, static_cast<char>(ACK));
 
-    // Lê o conteúdo do arquivo para uma string
-    std::string payload(fileSize, '\0');
-    if (!inputFile.read(&payload[0], fileSize)) {
-        throw std::runtime_error("Erro ao ler o conteúdo do arquivo.");
+    if (metricsDumpRequest) {
+        dumpMetrics(metrics, metricsDumpRequest == SIGUSR2 ? "json" : "text");
+        metricsDumpRequest = 0;
     }
 
-    return payload;
-}
+    if (segment.empty()) {
+        return false;
+    }
+    if (++recordsSeen <= resumeAt || dispatcher.finished()) {
+        return false;
+    }
 
-std::vector<std::vector<uint8_t>> splitByDelimiters(const std::vector<uint8_t>& data, uint8_t delimiter1, uint8_t delimiter2) {
-    std::vector<std::vector<uint8_t>> result;
-    std::vector<uint8_t> currentSegment;
+    // Extrai a instrução; argumentos e payload são tratados pelo Dispatcher
+    uint8_t instruction = segment[0];
 
-    for (size_t i = 0; i < data.size(); ++i) {
-        if (i + 1 < data.size() && data[i] == delimiter1 && data[i + 1] == delimiter2) {
-            // Encontrei os delimitadores (0x03 seguido de 0x02), salvei o segmento atual
-            if (!currentSegment.empty()) {
-                result.push_back(currentSegment);
-                currentSegment.clear();
+    if(instruction == INSTR_CALL_FUNCTION || instruction == INSTR_CALL_FRAME) {
+        if(DEBUG) {
+            if (instruction == INSTR_CALL_FUNCTION) {
+                std::cout << "--> Instruction: 0x83 (CALL_FUNCTION)" << std::endl;
+            } else {
+                std::cout << "--> Instruction: 0x84 (CALL_FRAME)" << std::endl;
             }
-            ++i; // Skip the second delimiter
-        } else {
-            currentSegment.push_back(data[i]);
+            std::cout << "* sending ACK to master: ";
+            printBinaryString(ackString);
+        } 
+        dispatcher.dispatch(segment, decoded);
+        std::string framePayload;
+        if (DEBUG || response) {
+            framePayload = dispatcher.currentPayload();
         }
+        if(DEBUG) {
+            std::cout << "* updated current frame from received payload..." << std::endl;
+            std::cout << "* pushed new frame to execution stack:" << std::endl;
+            dispatcher.current()->print(std::cout, dispatcher.getGlobals(), dispatcher.currentTables());
+            metrics.recordEncoded(framePayload.size());
+            writePayloadToFile(framePayload, "output.bin");
+            std::cout << "\n* generated payload for new frame: ";
+            printBinaryString(framePayload);
+        } 
+        if (response) {
+            *response = std::move(framePayload);
+        }
+    } else if(instruction == INSTR_RETURN) {
+        if(DEBUG) {
+            std::cout << "--> Instruction: 0x53 (RETURN)" << std::endl;
+            std::cout << "* sending ACK to master: ";
+            printBinaryString(ackString);
+        }
+        dispatcher.dispatch(segment, decoded);
+        if(DEBUG) {
+            std::cout << "* returned to previous frame:" << std::endl;
+            dispatcher.current()->print(std::cout, dispatcher.getGlobals(), dispatcher.currentTables());
+        } 
+    } else if(instruction == INSTR_INIT) {
+        dispatcher.dispatch(segment, decoded);
+        if(DEBUG) {
+            std::cout << "--> Instruction: 0x02 (INIT)" << std::endl;
+            std::cout << "* sending ACK to master: ";
+            printBinaryString(ackString);
+            std::cout << "* " << "sending first frame:" << std::endl;
+            dispatcher.current()->print(std::cout, dispatcher.getGlobals(), dispatcher.currentTables());
+            if (codeTable) {
+                std::string tablePayload = codeTable->encode(codec);
+                metrics.recordEncoded(tablePayload.size());
+                writePayloadToFile(tablePayload, "code_table.bin");
+                std::cout << "\n* sending code table (" << codeTable->size() << " frames): ";
+                printBinaryString(tablePayload);
+            }
+        } 
+    } else {
+        throw std::runtime_error("Instrução desconhecida");
     }
-    // Adiciono o último segmento, se existir
-    if (!currentSegment.empty()) {
-        result.push_back(currentSegment);
-    }
+    checkpointRecord(dispatcher);
+    return true;
+}
 
-    return result;
+// Laço principal do modo por arquivo: aplica cada registro de master_instructions.bin
+template <typename Session>
+void processSegments(Session& dispatcher, const std::vector<std::vector<uint8_t>>& segments, bool DEBUG, Metrics& metrics,
+                     const CodeTable* codeTable, PayloadCodec codec) {
+    for (const auto& segment : segments) {
+        if (processSegment(dispatcher, segment, DEBUG, metrics, codeTable, codec)) {
+            std::cout << std::endl << std::endl;
+        }
+        encodePrefetched();
+    }
 }
 
-void printGreetings() {
-    std::cout << std::endl << "Welcome to... \033[36m" << std::endl;
-    std::cout <<   " ▗▄▄▖ ▗▄▖ ▗▄▄▄ ▗▄▄▄▖    ▗▄▄▄▖▗▄▄▖  ▗▄▖ ▗▖  ▗▖▗▄▄▄▖    ▗▄▄▖ ▗▄▄▖  ▗▄▖  ▗▄▄▖▗▄▄▄▖ ▗▄▄▖ ▗▄▄▖ ▗▄▖ ▗▄▄▖ " << std::endl;
-    std::cout <<   "▐▌   ▐▌ ▐▌▐▌  █▐▌       ▐▌   ▐▌ ▐▌▐▌ ▐▌▐▛▚▞▜▌▐▌       ▐▌ ▐▌▐▌ ▐▌▐▌ ▐▌▐▌   ▐▌   ▐▌   ▐▌   ▐▌ ▐▌▐▌ ▐▌" << std::endl;
-    std::cout <<   "▐▌   ▐▌ ▐▌▐▌  █▐▛▀▀▘    ▐▛▀▀▘▐▛▀▚▖▐▛▀▜▌▐▌  ▐▌▐▛▀▀▘    ▐▛▀▘ ▐▛▀▚▖▐▌ ▐▌▐▌   ▐▛▀▀▘ ▝▀▚▖ ▝▀▚▖▐▌ ▐▌▐▛▀▚▖" << std::endl;
-    std::cout <<   "▝▚▄▄▖▝▚▄▞▘▐▙▄▄▀▐▙▄▄▖    ▐▌   ▐▌ ▐▌▐▌ ▐▌▐▌  ▐▌▐▙▄▄▖    ▐▌   ▐▌ ▐▌▝▚▄▞▘▝▚▄▄▖▐▙▄▄▖▗▄▄▞▘▗▄▄▞▘▝▚▄▞▘▐▌ ▐▌" << std::endl;
-    std::cout <<   "" << std::endl;
-    std::cout << "" << std::endl << "\033[0m";                                                                                                    
+// --pipeline: mesmo laço de processSegments, com a divisão do fluxo e a decodificação dos
+// payloads feitas em outra thread enquanto a sessão aplica o registro anterior
+template <typename Session>
+void processPipelined(Session& dispatcher, std::span<const uint8_t> data, bool DEBUG, Metrics& metrics,
+                      const CodeTable* codeTable, PayloadCodec codec) {
+    runPipeline(data, dispatcher.decodeOptions(), [&](DecodedRecord& record) {
+        if (processSegment(dispatcher, record.segment, DEBUG, metrics, codeTable, codec, record.decodedPayload())) {
+            std::cout << std::endl << std::endl;
+        }
+        encodePrefetched();
+    });
 }
 
-void printBinaryString(const std::string& binaryString) {
-    std::cout << "\033[36m";
+// --index/--from: registros localizados pelo índice do fluxo (ver TraceIndex.hpp). Os
+// anteriores a from são aplicados sem saída, só para reconstruir o estado da sessão; os
+// anteriores a um checkpoint restaurado nem são lidos
+template <typename Session>
+void processIndexed(Session& dispatcher, std::span<const uint8_t> data, const TraceIndex& index, size_t from,
+                    bool DEBUG, Metrics& metrics, const CodeTable* codeTable, PayloadCodec codec) {
+    std::vector<uint8_t> segment;
+    recordsSeen = std::min<uint64_t>(resumeAt, index.size());
+    for (size_t i = recordsSeen; i < index.size(); ++i) {
+        std::span<const uint8_t> record = index.record(data, i);
+        segment.assign(record.begin(), record.end());
+        if (i < from) {
+            ++recordsSeen;
+            if (!dispatcher.finished()) {
+                dispatcher.dispatch(segment);
+                checkpointRecord(dispatcher);
+            }
+        } else if (processSegment(dispatcher, segment, DEBUG, metrics, codeTable, codec)) {
+            std::cout << std::endl << std::endl;
+        }
+        encodePrefetched();
+    }
+}
 
-    for (unsigned char c : binaryString) {
-        std::cout << std::hex << std::setfill('0') << std::setw(2) 
-                  << static_cast<int>(c) << " ";
+// --shm: registros lidos do anel do mestre até ele fechar o anel. Cada registro recebe uma
+// resposta no anel de volta: ACK, seguido do payload do novo frame nas chamadas e da
+// tabela de frames no INIT com --frame-ids (ver SharedRing.hpp). Se um registro falhar, o
+// erro é impresso, os dois anéis são fechados (o mestre não fica esperando a resposta) e
+// retorna false
+template <typename Session>
+bool processSharedChannel(Session& dispatcher, SharedChannel& channel, WaitMode waitMode, bool DEBUG, Metrics& metrics,
+                          const CodeTable* codeTable, PayloadCodec codec) {
+    std::vector<uint8_t> segment;
+    std::vector<uint8_t> response;
+    std::string payload;
+    try {
+        while (channel.instructions().read(segment, waitMode)) {
+            response.assign(1, ACK);
+            if (processSegment(dispatcher, segment, DEBUG, metrics, codeTable, codec, nullptr, &payload)) {
+                if (segment[0] == INSTR_CALL_FUNCTION || segment[0] == INSTR_CALL_FRAME) {
+                    response.insert(response.end(), payload.begin(), payload.end());
+                } else if (segment[0] == INSTR_INIT && codeTable) {
+                    std::string table = codeTable->encode(codec);
+                    response.insert(response.end(), table.begin(), table.end());
+                }
+            }
+            channel.responses().write(response, waitMode);
+            encodePrefetched();  // Enquanto o mestre processa a resposta
+        }
+    } catch (const std::exception& error) {
+        channel.instructions().close();
+        channel.responses().close();
+        std::cerr << error.what() << std::endl;
+        return false;
     }
-    std::cout << std::dec << "\033[0m" << std::endl; // Retorna o manipulador para decimal
+    channel.responses().close();
+    return true;
 }
 
 int main(int argc, char* argv[]) {
     bool DEBUG = false;
-
-    if (argc > 1 && std::string(argv[1]) == "-d") {
-        DEBUG = true;
+    bool USE_COROUTINES = false;
+    bool LAZY_LOAD = false;
+    bool WARMUP = false;
+    unsigned warmupThreads = 0;  // 0: uma thread por núcleo
+    bool FRAME_IDS = false;
+    bool DEDUP = false;
+    bool SYMBOLS = false;
+    PayloadCodec codec = PayloadCodec::V1;
+    unsigned inlineDepth = 0;
+    bool PREFETCH = false;
+    bool PIPELINE = false;
+    bool VALIDATE = false;
+    bool INDEX = false;
+    size_t fromRecord = 0;  // --from: primeiro registro processado com saída
+    std::string checkpointFile;  // Vazio: sem checkpoints
+    std::string restoreFile;     // Vazio: sessão começa do INIT
+    unsigned validateThreads = 0;  // 0: uma thread por núcleo
+    std::string metricsFormat;  // Vazio: métricas só são despejadas por sinal
+    std::string codeFile = "code.json";
+    std::string shmName;  // Vazio: registros lidos de inputFile
+    std::string inputFile = "master_instructions.bin";
+    IoBackend ioBackend = IoBackend::Stream;
+    WaitMode waitMode = WaitMode::Futex;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "-d") {
+            DEBUG = true;
+        } else if (arg == "-c") {
+            USE_COROUTINES = true;
+        } else if (arg == "--lazy") {
+            LAZY_LOAD = true;
+        } else if (arg == "--symbols") {
+            SYMBOLS = true;
+        } else if (arg == "--dedup") {
+            DEDUP = true;
+        } else if (arg == "--prefetch") {
+            PREFETCH = true;
+        } else if (arg == "--frame-ids") {
+            FRAME_IDS = true;
+        } else if (arg == "--pipeline") {
+            PIPELINE = true;
+        } else if (arg == "--index") {
+            INDEX = true;
+        } else if (arg.rfind("--from=", 0) == 0) {
+            INDEX = true;
+            fromRecord = std::stoull(arg.substr(7));
+        } else if (arg.rfind("--checkpoint=", 0) == 0) {
+            checkpointFile = arg.substr(13);
+        } else if (arg.rfind("--checkpoint-every=", 0) == 0) {
+            checkpointEvery = std::max<uint64_t>(1, std::stoull(arg.substr(19)));
+        } else if (arg.rfind("--restore=", 0) == 0) {
+            restoreFile = arg.substr(10);
+        } else if (arg == "--validate") {
+            VALIDATE = true;
+        } else if (arg.rfind("--validate=", 0) == 0) {
+            VALIDATE = true;
+            validateThreads = static_cast<unsigned>(std::stoul(arg.substr(11)));
+        } else if (arg == "--warmup") {
+            WARMUP = true;
+        } else if (arg.rfind("--warmup=", 0) == 0) {
+            WARMUP = true;
+            warmupThreads = static_cast<unsigned>(std::stoul(arg.substr(9)));
+        } else if (arg.rfind("--codec=", 0) == 0) {
+            int revision = std::stoi(arg.substr(8));
+            if (revision != 1 && revision != 2) {
+                std::cerr << "Unknown payload codec: " << revision << std::endl;
+                return 1;
+            }
+            codec = static_cast<PayloadCodec>(revision);
+        } else if (arg.rfind("--inline-frames=", 0) == 0) {
+            inlineDepth = static_cast<unsigned>(std::stoul(arg.substr(16)));
+        } else if (arg == "--metrics" || arg == "--metrics=text") {
+            metricsFormat = "text";
+        } else if (arg == "--metrics=json") {
+            metricsFormat = "json";
+        } else if (arg.rfind("--shm=", 0) == 0) {
+            shmName = arg.substr(6);
+        } else if (arg.rfind("--shm-wait=", 0) == 0) {
+            waitMode = parseWaitMode(arg.substr(11));
+        } else if (arg.rfind("--input=", 0) == 0) {
+            inputFile = arg.substr(8);
+        } else if (arg.rfind("--io=", 0) == 0) {
+            ioBackend = parseIoBackend(arg.substr(5));
+        } else if (arg.rfind("--code=", 0) == 0) {
+            codeFile = arg.substr(7);
+        }
     }
+    // --validate e --index leem o arquivo inteiro antes da sessão, o que não existe com --shm;
+    // --pipeline decodifica o registro seguinte, que o mestre só envia depois da resposta
+    if (!shmName.empty() && (VALIDATE || INDEX || PIPELINE)) {
+        std::cerr << (VALIDATE ? "--validate" : INDEX ? "--index and --from" : "--pipeline")
+                  << " cannot be used with --shm" << std::endl;
+        return 1;
+    }
+    if (INDEX && PIPELINE) {
+        std::cerr << "--index and --from cannot be used with --pipeline" << std::endl;
+        return 1;
+    }
+    // Com --pipeline --symbols a tabela de símbolos de entrada pertence à thread de
+    // decodificação (ver Pipeline.hpp), e o checkpoint a leria da thread da sessão
+    if (!checkpointFile.empty() && PIPELINE && SYMBOLS) {
+        std::cerr << "--checkpoint cannot be used with --pipeline --symbols" << std::endl;
+        return 1;
+    }
+    outputBackend = ioBackend;
 
-    Code code = readCodeFromJsonFile("code.json");
-    Code::globals = code.co_names;
-    const std::string ENQ = "ENQ";
-    const uint8_t ACK = 0x06;
-
-    // apenas para DEBUG
-    std::string ackString(1, static_cast<char>(ACK));
-
-    const char* filename = "master_instructions.bin";
-    std::ifstream file(filename, std::ios::binary);
+    Metrics metrics;
+    std::signal(SIGUSR1, requestMetricsDump);
+    std::signal(SIGUSR2, requestMetricsDump);
 
-    if (!file.is_open()) {
-        std::cerr << "Failed to open file: " << filename << std::endl;
-        return 1;
+    Code code = readCodeFromFile(codeFile, LAZY_LOAD);
+    if (DEDUP) {
+        deduplicateCodes(code).write(std::cerr);
     }
+    if (WARMUP) {
+        precomputePayloads(code, warmupThreads, codec);
+    }
+    const std::string ENQ = "ENQ";
 
-    std::vector<uint8_t> fileData((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    // --shm: o mestre escreve no anel em memória compartilhada em vez do arquivo de --input
+    std::unique_ptr<SharedChannel> channel;
+    std::vector<uint8_t> fileData;
+    std::vector<std::vector<uint8_t>> segments;
+    if (!shmName.empty()) {
+        channel = std::make_unique<SharedChannel>(SharedChannel::create(shmName));
+        std::cerr << "Waiting for master on shared memory segment " << shmName << std::endl;
+    } else {
+        try {
+            fileData = readInput(inputFile, ioBackend);
+        } catch (const std::runtime_error& error) {
+            std::cerr << error.what() << std::endl;
+            return 1;
+        }
 
-    auto segments = splitByDelimiters(fileData, 0x03, 0x02);
+        // --pipeline: o fluxo é dividido pela etapa de decodificação; --index: pelo índice
+        if (!PIPELINE && !INDEX) {
+            segments = splitByDelimiters(fileData, 0x03, 0x02);
+        }
+    }
 
 
     printGreetings();
     if (DEBUG) std::cout << "\n\033[33mManager started on Debugger Mode...\033[0m" << std::endl << std::endl;
 
 
-    CodeNavigator navigator;
-    navigator.push(&code);
+    // --frame-ids: tabela de frames enviada após o INIT e respostas só com id e tabelas
+    std::unique_ptr<CodeTable> codeTable;
+    if (FRAME_IDS) {
+        codeTable = std::make_unique<CodeTable>(code);
+    }
 
-    /*
-        * INITIALIZE: 0x02
-        * RETURN_VALUE: 0x53
-        * CALL_FUNCTION: 0x83
-    */
+    // --validate: confere todos os registros do arquivo antes de aplicar o primeiro
+    if (VALIDATE) {
+        ValidationReport report = validateTrace(fileData, {codec, SYMBOLS, codeTable.get(), validateThreads});
+        report.write(std::cerr);
+        if (!report.ok()) {
+            return 1;
+        }
+    }
 
-    Code* currCode = &code;
-    for (const auto& segment : segments) {
-        if (segment.empty() || navigator.empty()) {
-            continue;
+    // --index: índice ao lado do fluxo, montado na primeira vez (a entrada padrão não é gravada)
+    std::unique_ptr<TraceIndex> traceIndex;
+    if (INDEX) {
+        bool built = true;
+        traceIndex = std::make_unique<TraceIndex>(inputFile == "-"
+            ? TraceIndex::build(fileData)
+            : TraceIndex::forTrace(inputFile, fileData, ioBackend, &built));
+        if (fromRecord > traceIndex->size()) {
+            std::cerr << "Record " << fromRecord << " out of range: the trace has " << traceIndex->size() << " records" << std::endl;
+            return 1;
+        }
+        std::cerr << "index: " << traceIndex->size() << " records" << (built ? " (built)" : " (loaded)");
+        if (fromRecord > 0 && fromRecord < traceIndex->size()) {
+            std::cerr << ", starting at record " << fromRecord << " (offset " << traceIndex->offset(fromRecord)
+                      << ", depth " << traceIndex->depth(fromRecord - 1) << ")";
         }
+        std::cerr << std::endl;
+    }
 
-        // Extrai a instrução e o payload
-        uint8_t instruction = segment[0];
-        std::vector<uint8_t> payload(segment.begin() + 1, segment.end());
+    // --prefetch: possíveis filhos de cada frame, varridos do co_code na carga
+    std::unique_ptr<CalleeIndex> callees;
+    std::unique_ptr<Prefetcher> prefetcher;
+    if (PREFETCH) {
+        callees = std::make_unique<CalleeIndex>(code);
+        prefetcher = std::make_unique<Prefetcher>(*callees, codec);
+        sessionPrefetcher = prefetcher.get();
+    }
 
-        if(instruction == 0x83) {
-            if(DEBUG) {
-                std::cout << "--> Instruction: 0x83 (CALL_FUNCTION)" << std::endl;
-                std::cout << "* sending ACK to master: ";
-                printBinaryString(ackString);
-            } 
-            std::vector<uint8_t> args(segment.begin() + 1, segment.begin() + 3);
-            std::vector<uint8_t> payload(segment.begin() + 4, segment.end());
-            std::string payloadString(payload.begin(), payload.end());
-
-            currCode->updateFromPayload(payloadString);
-            if(DEBUG) {
-                std::cout << "* updated current frame from received payload..." << std::endl;
-            }
+    // --restore: estado lido antes de criar a sessão, aplicado logo depois de configurá-la
+    std::unique_ptr<SavedSession> saved;
+    if (!restoreFile.empty()) {
+        try {
+            saved = std::make_unique<SavedSession>(readCheckpoint(restoreFile, code));
+        } catch (const std::runtime_error& error) {
+            std::cerr << error.what() << std::endl;
+            return 1;
+        }
+        if (saved->symbols != SYMBOLS) {
+            std::cerr << "Checkpoint " << restoreFile << (saved->symbols ? " requires" : " cannot be used with")
+                      << " --symbols" << std::endl;
+            return 1;
+        }
+        resumeAt = saved->record;
+        std::cerr << "checkpoint: resuming at record " << saved->record << " (depth " << saved->frames.size() << ")"
+                  << std::endl;
+    }
+    std::unique_ptr<CheckpointWriter> writer;
+    if (!checkpointFile.empty()) {
+        writer = std::make_unique<CheckpointWriter>(checkpointFile, code);
+        checkpointWriter = writer.get();
+    }
 
-            navigator.push(&currCode->getCodeFromVariable(args[0], args[1]));
-            currCode = navigator.peek();
-            if(DEBUG) {
-                std::cout << "* pushed new frame to execution stack:" << std::endl;
-                currCode->print();
-                std::cout << "\n* generated payload for new frame: ";
-                printBinaryString(currCode->generatePayload());
-            } 
-        } else if(instruction == 0x53) {
-            if(DEBUG) {
-                std::cout << "--> Instruction: 0x53 (RETURN)" << std::endl;
-                std::cout << "* sending ACK to master: ";
-                printBinaryString(ackString);
+    // -c: pilha de frames em corrotinas (FrameExecutor) em vez da pilha explícita
+    if (USE_COROUTINES) {
+        FrameExecutor executor(code);
+        executor.setMetrics(&metrics);
+        executor.setCodeTable(codeTable.get());
+        executor.setCodec(codec);
+        executor.setInlineDepth(inlineDepth);
+        executor.setPrefetcher(prefetcher.get());
+        if (SYMBOLS) executor.enableSymbols();
+        if (saved) executor.restore(*saved);
+        if (channel) {
+            if (!processSharedChannel(executor, *channel, waitMode, DEBUG, metrics, codeTable.get(), codec)) {
+                return 1;
             }
-            navigator.pop();
-            currCode = navigator.peek();
-            if(DEBUG) {
-                std::cout << "* returned to previous frame:" << std::endl;
-                currCode->print();
-            } 
-        } else if(instruction == 0x02) {
-            if(DEBUG) {
-                std::cout << "--> Instruction: 0x02 (INIT)" << std::endl;
-                std::cout << "* sending ACK to master: ";
-                printBinaryString(ackString);
-                std::cout << "* " << "sending first frame:" << std::endl;
-                currCode->print();
-            } 
+        } else if (traceIndex) {
+            processIndexed(executor, fileData, *traceIndex, fromRecord, DEBUG, metrics, codeTable.get(), codec);
+        } else if (PIPELINE) {
+            processPipelined(executor, fileData, DEBUG, metrics, codeTable.get(), codec);
         } else {
-            throw std::runtime_error("Instrução desconhecida");
+            processSegments(executor, segments, DEBUG, metrics, codeTable.get(), codec);
         }
-
-        
-        std::cout << std::endl << std::endl;
+        finishCheckpoint(executor);
+    } else {
+        Dispatcher dispatcher(code);
+        dispatcher.setMetrics(&metrics);
+        dispatcher.setCodeTable(codeTable.get());
+        dispatcher.setCodec(codec);
+        dispatcher.setInlineDepth(inlineDepth);
+        dispatcher.setPrefetcher(prefetcher.get());
+        if (SYMBOLS) dispatcher.enableSymbols();
+        if (saved) dispatcher.restore(*saved);
+        if (channel) {
+            if (!processSharedChannel(dispatcher, *channel, waitMode, DEBUG, metrics, codeTable.get(), codec)) {
+                return 1;
+            }
+        } else if (traceIndex) {
+            processIndexed(dispatcher, fileData, *traceIndex, fromRecord, DEBUG, metrics, codeTable.get(), codec);
+        } else if (PIPELINE) {
+            processPipelined(dispatcher, fileData, DEBUG, metrics, codeTable.get(), codec);
+        } else {
+            processSegments(dispatcher, segments, DEBUG, metrics, codeTable.get(), codec);
+        }
+        finishCheckpoint(dispatcher);
     }
 
     std::cout << "\033[32mAll instructions processed, exiting...\033[0m\n\n";
 
+    if (!metricsFormat.empty()) {
+        dumpMetrics(metrics, metricsFormat);
+    }
+
     return 0;
 }
 
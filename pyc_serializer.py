@@ -67,6 +67,7 @@ def create_dict(code):
     current_CO['co_varnames'] = code.co_varnames
     current_CO['co_freevars'] = code.co_freevars
     current_CO['co_cellvars'] = code.co_cellvars
+    current_CO['co_argcount'] = code.co_argcount
     current_CO['co_consts'] = []
     for const in code.co_consts:
         if type(const) == types.CodeType:
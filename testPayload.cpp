@@ -8,17 +8,20 @@ uint8_t recordSeparator[2] = {0x03, 0x02};
  * 
  * @param outfile O arquivo de saída onde a função será escrita.
  * @param codeObj é o objeto Code a ser convertido.
+ * @param globals Variáveis globais enviadas junto com o frame.
  * @param dstVector Vetor de destino.
  * @param dstIndexVector Índice do vetor de destino.
+ * @param codec Revisão da codificação dos valores (a mesma passada ao gerenciador em --codec).
  */
-void generateCallFn(std::ofstream& outfile, Code& codeObj, uint8_t dstVector, uint8_t dstIndexVector) {
+void generateCallFn(std::ofstream& outfile, Code& codeObj, const std::vector<VarType>& globals, uint8_t dstVector, uint8_t dstIndexVector,
+                    PayloadCodec codec = PayloadCodec::V1) {
     if (!outfile.is_open()) {
         throw std::runtime_error("Arquivo não está aberto para escrita.");
     }
 
     uint8_t fixedByte = 0x83;
     
-    std::string serializedStr = codeObj.generateInputTestPayload();
+    std::string serializedStr = codeObj.generateInputTestPayload(globals, codec);
 
     outfile.write(reinterpret_cast<const char*>(&fixedByte), sizeof(fixedByte));
     outfile.write(reinterpret_cast<const char*>(&dstVector), sizeof(dstVector));
@@ -39,7 +42,15 @@ void generateReturn(std::ofstream& outfile) {
     outfile.write(reinterpret_cast<const char*>(&recordSeparator), sizeof(recordSeparator));
 }
 
-int main() {
+int main(int argc, char* argv[]) {
+    // --codec=2 gera os payloads na codificação V2
+    PayloadCodec codec = PayloadCodec::V1;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]) == "--codec=2") {
+            codec = PayloadCodec::V2;
+        }
+    }
+
     // Nome do arquivo binário a ser criado
     const char* filename = "master_instructions.bin";
 
@@ -55,14 +66,15 @@ int main() {
     outfile.write(reinterpret_cast<const char*>(&recordSeparator), sizeof(recordSeparator));
 
     Code codeObj;
+    std::vector<VarType> globals;
     
     // Configuração de payload de recebimento e injeção de CALL_FUNCTION
-    Code::globals = {0, 20};
+    globals = {0, 20};
     codeObj.setCoNames(std::vector<VarType>{"two", true});
     codeObj.setCoVarnames(std::vector<VarType>{nullptr, 3});
     codeObj.setCoFreevars(std::vector<VarType>{});
     codeObj.setCoCellvars(std::vector<VarType>{});
-    generateCallFn(outfile, codeObj, 0, 0);
+    generateCallFn(outfile, codeObj, globals, 0, 0, codec);
 
     // retorna ao original
     generateReturn(outfile);